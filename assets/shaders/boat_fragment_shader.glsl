@@ -0,0 +1,40 @@
+#version 330 core
+// Fragment Shader for the Boat - texture modulated by the material diffuse color
+
+in vec2 TexCoord;
+in vec3 FragPosWorld;
+in vec3 NormalWorld;
+
+out vec4 FragColor;
+
+// Diffuse colors of all boat materials, filled once from the MTL file (size must match BOAT_MAX_MATERIALS)
+layout (std140) uniform Materials {
+    vec4 diffuseColors[64];
+};
+
+uniform int materialIndex;       // Material of the current draw batch
+uniform sampler2D boatTexture;
+// Camera and light, written once per frame by Renderer::updateFrameUniforms (must match FrameUniforms)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosWorld;
+    vec3 lightDir;
+    vec3 lightColor;
+};
+
+void main() {
+    vec3 albedoColor = texture(boatTexture, TexCoord).rgb * diffuseColors[materialIndex].rgb;
+
+    // Same light as the former fixed-function GL_LIGHT0 setup
+    vec3 normal = normalize(NormalWorld);
+    vec3 lightDirNorm = normalize(lightDir);
+    vec3 viewDirNorm = normalize(viewPosWorld - FragPosWorld);
+    vec3 reflectDir = reflect(-lightDirNorm, normal);
+
+    vec3 ambient = 0.2 * albedoColor;
+    vec3 diffuse = 0.8 * max(dot(normal, lightDirNorm), 0.0) * albedoColor;
+    vec3 specular = vec3(0.5 * 0.5) * pow(max(dot(viewDirNorm, reflectDir), 0.0), 50.0);
+
+    FragColor = vec4(ambient + diffuse + specular, 1.0);
+}
@@ -0,0 +1,29 @@
+#version 330 core
+// Vertex Shader for the retained-mode Boat mesh
+
+layout (location = 0) in vec3 aPos;      // Vertex position (model space)
+layout (location = 1) in vec3 aNormal;   // Vertex normal (model space)
+layout (location = 2) in vec2 aTexCoord; // Texture coordinates
+
+out vec2 TexCoord;
+out vec3 FragPosWorld;
+out vec3 NormalWorld;
+
+uniform mat4 model;
+// Camera and light, written once per frame by Renderer::updateFrameUniforms (must match FrameUniforms)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosWorld;
+    vec3 lightDir;
+    vec3 lightColor;
+};
+uniform mat3 normalMatrix;
+
+void main() {
+    vec4 worldPos = model * vec4(aPos, 1.0);
+    gl_Position = projection * view * worldPos;
+    TexCoord = aTexCoord;
+    FragPosWorld = worldPos.xyz;
+    NormalWorld = normalize(normalMatrix * aNormal);
+}
@@ -0,0 +1,10 @@
+#version 330 core
+// Fragment Shader for the batched debug lines, unlit
+
+in vec4 Color;
+
+out vec4 FragColor;
+
+void main() {
+    FragColor = Color;
+}
@@ -0,0 +1,21 @@
+#version 330 core
+// Vertex Shader for the batched debug lines
+
+layout (location = 0) in vec3 aPos;   // World space
+layout (location = 1) in vec4 aColor; // RGBA8, normalized
+
+out vec4 Color;
+
+// Camera and light, written once per frame by Renderer::updateFrameUniforms (must match FrameUniforms)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosWorld;
+    vec3 lightDir;
+    vec3 lightColor;
+};
+
+void main() {
+    gl_Position = projection * view * vec4(aPos, 1.0);
+    Color = aColor;
+}
@@ -14,9 +14,14 @@ out vec4 FragColor;
 // Uniforms (textures, lighting parameters, camera position)
 uniform sampler2D oceanTexture;    // Sampler for ocean color texture
 uniform sampler2D normalMap;       // Sampler for normal map texture
-uniform vec3 lightDir;          // Directional light direction (world space)
-uniform vec3 lightColor;        // Light color
-uniform vec3 viewPosWorld;      // Camera position in world space
+// Camera and light, written once per frame by Renderer::updateFrameUniforms (must match FrameUniforms)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosWorld;
+    vec3 lightDir;
+    vec3 lightColor;
+};
 
 void main() {
     // 1. Sample textures
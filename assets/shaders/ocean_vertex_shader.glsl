@@ -15,9 +15,15 @@ out vec3 NormalInterp; // **OUT variable declaration - crucial!**
 
 // Uniforms (matrices, light parameters, etc.)
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 uniform mat3 normalMatrix; // Normal matrix for correct normal transformation
+// Camera and light, written once per frame by Renderer::updateFrameUniforms (must match FrameUniforms)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosWorld;
+    vec3 lightDir;
+    vec3 lightColor;
+};
 
 void main() {
     // 1. Transform vertex position to clip space
@@ -13,9 +13,14 @@ out vec4 FragColor;
 uniform sampler2D terrainTexture; // Sampler for terrain color texture (no normal map for now)
 uniform sampler2D heightMapTexture; // **New: Sampler for heightmap texture**
 
-uniform vec3 lightDir;
-uniform vec3 lightColor;
-uniform vec3 viewPosWorld;
+// Camera and light, written once per frame by Renderer::updateFrameUniforms (must match FrameUniforms)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosWorld;
+    vec3 lightDir;
+    vec3 lightColor;
+};
 
 void main() {
     // 1. Sample terrain texture
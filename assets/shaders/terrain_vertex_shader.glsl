@@ -10,8 +10,14 @@ out vec3 FragPosWorld;
 out vec3 NormalWorld;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Camera and light, written once per frame by Renderer::updateFrameUniforms (must match FrameUniforms)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosWorld;
+    vec3 lightDir;
+    vec3 lightColor;
+};
 uniform mat3 normalMatrix;
 
 void main() {
@@ -0,0 +1,306 @@
+/*
+ * File:        Baseline.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Versioned binary store of kernel timings and the rank test the perf gate compares them with
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "Baseline.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    const char MAGIC[4] = {'I', 'P', 'A', 'B'};
+
+    void writeU16(std::string &out, uint16_t value)
+    {
+        out.push_back(static_cast<char>(value & 0xFF));
+        out.push_back(static_cast<char>(value >> 8));
+    }
+
+    void writeU32(std::string &out, uint32_t value)
+    {
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            out.push_back(static_cast<char>((value >> shift) & 0xFF));
+        }
+    }
+
+    void writeString(std::string &out, const std::string &value)
+    {
+        writeU16(out, static_cast<uint16_t>(std::min<size_t>(value.size(), 0xFFFF)));
+        out.append(value, 0, std::min<size_t>(value.size(), 0xFFFF));
+    }
+
+    void writeVarint(std::string &out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    // Bounds-checked reads over the whole file; any short read leaves ok false
+    struct Reader
+    {
+        const std::string &data;
+        size_t position;
+        bool ok;
+
+        uint8_t byte()
+        {
+            if (position >= data.size())
+            {
+                ok = false;
+                return 0;
+            }
+            return static_cast<uint8_t>(data[position++]);
+        }
+
+        uint32_t u32()
+        {
+            uint32_t value = 0;
+            for (int shift = 0; shift < 32; shift += 8)
+            {
+                value |= static_cast<uint32_t>(byte()) << shift;
+            }
+            return value;
+        }
+
+        std::string string()
+        {
+            uint16_t length = byte();
+            length |= static_cast<uint16_t>(byte() << 8);
+            if (!ok || position + length > data.size())
+            {
+                ok = false;
+                return "";
+            }
+            position += length;
+            return data.substr(position - length, length);
+        }
+
+        uint64_t varint()
+        {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64 && ok; shift += 7)
+            {
+                uint8_t next = byte();
+                value |= static_cast<uint64_t>(next & 0x7F) << shift;
+                if ((next & 0x80) == 0)
+                {
+                    return value;
+                }
+            }
+            ok = false;
+            return 0;
+        }
+    };
+
+    double median(std::vector<uint64_t> values)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        std::sort(values.begin(), values.end());
+        size_t middle = values.size() / 2;
+        return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+    }
+}
+
+const BaselineCase *Baseline::find(const std::string &name) const
+{
+    for (const BaselineCase &entry : cases)
+    {
+        if (entry.name == name)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool Baseline::save(const std::string &path) const
+{
+    std::string out(MAGIC, sizeof(MAGIC));
+    writeU32(out, BASELINE_VERSION);
+    writeString(out, host);
+    writeU32(out, gridSize);
+    writeU32(out, static_cast<uint32_t>(cases.size()));
+    for (const BaselineCase &entry : cases)
+    {
+        std::vector<uint64_t> sorted = entry.samples; // The test only needs the distribution
+        std::sort(sorted.begin(), sorted.end());
+        writeString(out, entry.name);
+        writeU32(out, static_cast<uint32_t>(sorted.size()));
+        uint64_t previous = 0;
+        for (uint64_t sample : sorted)
+        {
+            writeVarint(out, sample - previous);
+            previous = sample;
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file || !file.write(out.data(), out.size()))
+    {
+        std::cerr << "Cannot write baseline " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Baseline::load(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Cannot open baseline " << path << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string data = buffer.str();
+
+    if (data.size() < sizeof(MAGIC) || data.compare(0, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0)
+    {
+        std::cerr << path << " is not a baseline file" << std::endl;
+        return false;
+    }
+    Reader reader = {data, sizeof(MAGIC), true};
+    uint32_t version = reader.u32();
+    if (version != BASELINE_VERSION)
+    {
+        std::cerr << path << " has baseline version " << version << ", this build reads " << BASELINE_VERSION << std::endl;
+        return false;
+    }
+    host = reader.string();
+    gridSize = reader.u32();
+    uint32_t caseCount = reader.u32();
+    cases.clear();
+    for (uint32_t i = 0; i < caseCount && reader.ok; ++i)
+    {
+        BaselineCase entry;
+        entry.name = reader.string();
+        uint32_t sampleCount = reader.u32();
+        if (sampleCount > data.size()) // Every sample takes at least a byte
+        {
+            reader.ok = false;
+            break;
+        }
+        entry.samples.reserve(sampleCount);
+        uint64_t value = 0;
+        for (uint32_t j = 0; j < sampleCount && reader.ok; ++j)
+        {
+            value += reader.varint();
+            entry.samples.push_back(value);
+        }
+        cases.push_back(entry);
+    }
+    if (!reader.ok)
+    {
+        std::cerr << path << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Baseline::importPlotData(const std::string &directory, int maxWaves)
+{
+    for (int waves = 1; waves <= maxWaves; ++waves)
+    {
+        std::string path = directory + "/" + std::to_string(waves) + "waves";
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cerr << "Cannot open " << path << std::endl;
+            return false;
+        }
+        BaselineCase reference = {"reference/" + std::to_string(waves) + "waves", {}};
+        BaselineCase simd = {"simd/" + std::to_string(waves) + "waves", {}};
+        uint64_t nanoseconds, cycles;
+        bool isReference = true;
+        while (file >> nanoseconds >> cycles)
+        {
+            (isReference ? reference : simd).samples.push_back(nanoseconds);
+            isReference = !isReference;
+        }
+        cases.push_back(reference);
+        cases.push_back(simd);
+    }
+    return true;
+}
+
+SampleComparison compareSamples(const std::vector<uint64_t> &baseline, const std::vector<uint64_t> &current, double alpha,
+                                double threshold)
+{
+    SampleComparison result;
+    result.baselineMedian = median(baseline);
+    result.currentMedian = median(current);
+    result.ratio = result.baselineMedian > 0.0 ? result.currentMedian / result.baselineMedian : 1.0;
+    result.pSlower = 1.0;
+    result.pFaster = 1.0;
+    result.regression = false;
+    result.improvement = false;
+    if (baseline.empty() || current.empty())
+    {
+        return result;
+    }
+
+    // Pool both samples (false = baseline) and give ties their average rank
+    std::vector<std::pair<uint64_t, bool>> pooled;
+    pooled.reserve(baseline.size() + current.size());
+    for (uint64_t sample : baseline)
+    {
+        pooled.push_back({sample, false});
+    }
+    for (uint64_t sample : current)
+    {
+        pooled.push_back({sample, true});
+    }
+    std::sort(pooled.begin(), pooled.end());
+
+    double n1 = static_cast<double>(current.size());
+    double n2 = static_cast<double>(baseline.size());
+    double total = n1 + n2;
+    double rankSum = 0.0, ties = 0.0;
+    for (size_t begin = 0; begin < pooled.size();)
+    {
+        size_t end = begin;
+        while (end < pooled.size() && pooled[end].first == pooled[begin].first)
+        {
+            end++;
+        }
+        double rank = (begin + 1 + end) / 2.0; // Ranks begin+1 .. end
+        for (size_t i = begin; i < end; ++i)
+        {
+            rankSum += pooled[i].second ? rank : 0.0;
+        }
+        double count = static_cast<double>(end - begin);
+        ties += count * count * count - count;
+        begin = end;
+    }
+
+    double u = rankSum - n1 * (n1 + 1.0) / 2.0; // Large when the current samples rank high, i.e. are slower
+    double mean = n1 * n2 / 2.0;
+    double variance = n1 * n2 / 12.0 * ((total + 1.0) - ties / (total * (total - 1.0)));
+    if (variance > 0.0)
+    {
+        double deviation = std::sqrt(variance);
+        result.pSlower = 0.5 * std::erfc((u - mean - 0.5) / deviation / std::sqrt(2.0)); // With continuity correction
+        result.pFaster = 0.5 * std::erfc((mean - u - 0.5) / deviation / std::sqrt(2.0));
+    }
+    result.regression = result.pSlower < alpha && result.ratio > 1.0 + threshold;
+    result.improvement = result.pFaster < alpha && result.ratio < 1.0 - threshold;
+    return result;
+}
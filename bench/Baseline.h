@@ -0,0 +1,58 @@
+#ifndef BASELINE_H
+#define BASELINE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Stored kernel timings for the perf gate (perf_gate.cpp) and the test that compares a new run against them.
+//
+// File format, little endian:
+//   "IPAB"  u32 version  str host  u32 gridSize  u32 caseCount
+//   per case: str name  u32 sampleCount  sampleCount LEB128 varints
+//   str = u16 length + bytes
+// Samples are nanoseconds, sorted and stored as deltas from the previous one: the 10,000 runs of a docs/data
+// text file (170 KB) take about 18 KB. Readers reject other versions.
+
+#define BASELINE_VERSION 1
+#define BASELINE_DEFAULT_ALPHA 0.001   // One-sided Mann-Whitney p-value below which a slowdown is significant
+#define BASELINE_DEFAULT_THRESHOLD 0.05 // ... and the median must also be this much slower
+
+struct BaselineCase
+{
+    std::string name; // "<kernel>/<N>waves"
+    std::vector<uint64_t> samples;
+};
+
+struct Baseline
+{
+    std::string host; // CPU brand, timings from another model are not comparable
+    uint32_t gridSize = 0;
+    std::vector<BaselineCase> cases;
+
+    const BaselineCase *find(const std::string &name) const;
+    bool save(const std::string &path) const;
+    bool load(const std::string &path);
+
+    // docs/data/<N>waves: "ns cycles" lines alternating reference and assembly SIMD kernel, as written to BASE.txt by
+    // --trace --kernel simd; the other kernels go to BASE.<kernel>.txt and are not imported under the simd name
+    bool importPlotData(const std::string &directory, int maxWaves);
+};
+
+struct SampleComparison
+{
+    double baselineMedian;
+    double currentMedian;
+    double ratio;       // current / baseline median
+    double pSlower;     // One-sided p that the current samples are not larger
+    double pFaster;
+    bool regression;
+    bool improvement;
+};
+
+// Mann-Whitney U with tie correction and the normal approximation; rank based, so the long tails of
+// interrupted runs do not move it the way they move a mean
+SampleComparison compareSamples(const std::vector<uint64_t> &baseline, const std::vector<uint64_t> &current, double alpha,
+                                double threshold);
+
+#endif // BASELINE_H
@@ -0,0 +1,219 @@
+/*
+ * File:        Bench.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Microbenchmark runner - cache-sized working sets, robust statistics and reports
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "Bench.h"
+#include "Timing.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+namespace
+{
+    size_t cacheSize(int name, size_t fallback)
+    {
+        long size = sysconf(name);
+        return size > 0 ? static_cast<size_t>(size) : fallback;
+    }
+
+    double median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        size_t middle = values.size() / 2;
+        return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+    }
+}
+
+BenchmarkRunner::BenchmarkRunner(int repetitions, const std::string &filter) : repetitions(repetitions), filter(filter)
+{
+    Timing::calibrate();
+    size_t llc = cacheSize(_SC_LEVEL3_CACHE_SIZE, 0);
+    if (llc == 0)
+    {
+        llc = cacheSize(_SC_LEVEL2_CACHE_SIZE, 8u << 20);
+    }
+    cacheTargets[CACHE_L1] = cacheSize(_SC_LEVEL1_DCACHE_SIZE, 32u << 10) / 2;
+    cacheTargets[CACHE_L2] = cacheSize(_SC_LEVEL2_CACHE_SIZE, 1u << 20) / 2;
+    cacheTargets[CACHE_LLC] = std::min<size_t>(llc / 2, BENCH_MAX_WORKING_SET / 4);
+    cacheTargets[CACHE_DRAM] = std::min<size_t>(llc * 4, BENCH_MAX_WORKING_SET);
+    if (cacheTargets[CACHE_DRAM] < llc * 2)
+    {
+        std::printf("LLC of %zu MiB, the DRAM working set is capped and may partly hit the LLC\n", llc >> 20);
+    }
+    std::printf("Working sets: L1 %zu KiB, L2 %zu KiB, LLC %zu KiB, DRAM %zu KiB\n", cacheTargets[CACHE_L1] >> 10,
+                cacheTargets[CACHE_L2] >> 10, cacheTargets[CACHE_LLC] >> 10, cacheTargets[CACHE_DRAM] >> 10);
+}
+
+bool BenchmarkRunner::enableCounters(const std::vector<PerfEventSpec> &events)
+{
+    return counters.open(events);
+}
+
+const char *BenchmarkRunner::levelName(CacheLevel level)
+{
+    static const char *const names[CACHE_LEVEL_COUNT] = {"L1", "L2", "LLC", "DRAM"};
+    return names[level];
+}
+
+void BenchmarkRunner::run(const std::string &name, CacheLevel level, size_t items, size_t bytes, const std::function<void()> &body)
+{
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+    {
+        return;
+    }
+
+    // Warmup, which also sizes the repetition
+    uint64_t calls = 0;
+    uint64_t start = __rdtsc();
+    double warmup = 0.0;
+    do
+    {
+        body();
+        calls++;
+        warmup = Timing::ticksToNanoseconds(__rdtsc() - start);
+    } while (warmup < BENCH_WARMUP_NS);
+    double callNanoseconds = warmup / calls;
+    uint64_t callsPerRepetition = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(BENCH_MIN_REPETITION_NS / callNanoseconds)));
+
+    std::vector<double> samples; // ns per item
+    samples.reserve(repetitions);
+    PerfSample countersBefore, countersAfter;
+    bool counting = counters.isOpen() && counters.read(countersBefore);
+    for (int repetition = 0; repetition < repetitions; ++repetition)
+    {
+        _mm_lfence();
+        uint64_t begin = __rdtsc();
+        for (uint64_t call = 0; call < callsPerRepetition; ++call)
+        {
+            body();
+        }
+        _mm_lfence();
+        uint64_t end = __rdtsc();
+        samples.push_back(Timing::ticksToNanoseconds(end - begin) / (static_cast<double>(callsPerRepetition) * items));
+    }
+    counting = counting && counters.read(countersAfter);
+
+    BenchmarkResult result;
+    result.name = name;
+    result.level = levelName(level);
+    result.items = items;
+    result.bytes = bytes;
+    result.repetitions = repetitions;
+    result.median = median(samples);
+    result.min = *std::min_element(samples.begin(), samples.end());
+
+    // Median absolute deviation, scaled to a standard deviation for normal data
+    std::vector<double> deviations;
+    for (double sample : samples)
+    {
+        deviations.push_back(std::fabs(sample - result.median));
+    }
+    double mad = 1.4826 * median(deviations);
+
+    double sum = 0.0, squares = 0.0;
+    int kept = 0;
+    for (double sample : samples)
+    {
+        if (mad > 0.0 && std::fabs(sample - result.median) > BENCH_OUTLIER_MADS * mad)
+        {
+            continue;
+        }
+        sum += sample;
+        squares += sample * sample;
+        kept++;
+    }
+    result.outliers = repetitions - kept;
+    result.mean = sum / kept;
+    result.stddev = kept > 1 ? std::sqrt(std::max(0.0, (squares - sum * sum / kept) / (kept - 1))) : 0.0;
+    if (counting)
+    {
+        double totalItems = static_cast<double>(repetitions) * callsPerRepetition * items;
+        for (size_t i = 0; i < counters.size(); ++i)
+        {
+            result.counters.push_back(PerfCounters::delta(countersBefore, countersAfter, i) / totalItems);
+        }
+    }
+    results.push_back(result);
+
+    std::printf("  %-34s %-4s %10zu KiB %10.3f ns/item (%5.1f %%)\n", name.c_str(), result.level.c_str(), bytes >> 10,
+                result.median, result.mean > 0.0 ? 100.0 * result.stddev / result.mean : 0.0);
+    std::fflush(stdout);
+}
+
+void BenchmarkRunner::printTable() const
+{
+    std::printf("\n%-34s %-4s %12s %10s %10s %10s %10s %9s %8s\n", "benchmark", "set", "bytes", "median", "mean", "stddev",
+                "min", "GB/s", "outliers");
+    for (const BenchmarkResult &result : results)
+    {
+        double gigabytesPerSecond = result.bytes / (result.median * result.items); // bytes per ns
+        std::printf("%-34s %-4s %12zu %10.3f %10.3f %10.3f %10.3f %9.2f %5d/%d\n", result.name.c_str(), result.level.c_str(),
+                    result.bytes, result.median, result.mean, result.stddev, result.min, gigabytesPerSecond,
+                    result.outliers, result.repetitions);
+    }
+    std::printf("Times are ns per item.\n");
+
+    if (!counters.isOpen())
+    {
+        return;
+    }
+    int cycles = counters.findEvent("cycles");
+    int instructions = counters.findEvent("instructions");
+    std::printf("\n%-34s %-4s", "hardware counters per item", "set");
+    for (size_t i = 0; i < counters.size(); ++i)
+    {
+        std::printf(" %13s", counters.getName(i).c_str());
+    }
+    std::printf("%s\n", cycles >= 0 && instructions >= 0 ? "           IPC" : "");
+    for (const BenchmarkResult &result : results)
+    {
+        if (result.counters.empty())
+        {
+            continue;
+        }
+        std::printf("%-34s %-4s", result.name.c_str(), result.level.c_str());
+        for (double value : result.counters)
+        {
+            std::printf(" %13.4f", value);
+        }
+        if (cycles >= 0 && instructions >= 0 && result.counters[cycles] > 0.0)
+        {
+            std::printf(" %13.2f", result.counters[instructions] / result.counters[cycles]);
+        }
+        std::printf("\n");
+    }
+}
+
+bool BenchmarkRunner::writeCsv(const std::string &path) const
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        return false;
+    }
+    out << "benchmark,set,items,bytes,median_ns,mean_ns,stddev_ns,min_ns,repetitions,outliers";
+    for (size_t i = 0; i < counters.size(); ++i)
+    {
+        out << ',' << counters.getName(i) << "_per_item";
+    }
+    out << '\n';
+    for (const BenchmarkResult &result : results)
+    {
+        out << result.name << ',' << result.level << ',' << result.items << ',' << result.bytes << ',' << result.median << ','
+            << result.mean << ',' << result.stddev << ',' << result.min << ',' << result.repetitions << ',' << result.outliers;
+        for (double value : result.counters)
+        {
+            out << ',' << value;
+        }
+        out << '\n';
+    }
+    return static_cast<bool>(out);
+}
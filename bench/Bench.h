@@ -0,0 +1,78 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "PerfCounters.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Microbenchmark harness: warmup, timed repetitions, outlier rejection and a summary row per case.
+//
+// One repetition calls the body enough times to run for at least BENCH_MIN_REPETITION_NS, so small working
+// sets are not dominated by timer overhead. Repetitions further than BENCH_OUTLIER_MADS scaled median absolute
+// deviations from the median (interrupts, migrations) are dropped before the mean is taken.
+
+#define BENCH_DEFAULT_REPETITIONS 31
+#define BENCH_WARMUP_NS 20000000ull       // Per case, also brings the working set into its cache level
+#define BENCH_MIN_REPETITION_NS 200000ull
+#define BENCH_OUTLIER_MADS 3.0
+#define BENCH_MAX_WORKING_SET (256ull << 20) // Server LLCs report the whole socket, 4x of that would take minutes
+
+// Working-set targets: half of L1, L2 and the LLC, and four times the LLC for DRAM
+enum CacheLevel
+{
+    CACHE_L1,
+    CACHE_L2,
+    CACHE_LLC,
+    CACHE_DRAM,
+    CACHE_LEVEL_COUNT
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    std::string level;
+    size_t items;         // Per body call
+    size_t bytes;         // Working set touched by one body call
+    double median;        // ns per item
+    double mean;          // ns per item, outliers dropped
+    double stddev;
+    double min;
+    int repetitions;
+    int outliers;
+    std::vector<double> counters; // Per item over all repetitions, empty without --perf
+};
+
+class BenchmarkRunner
+{
+public:
+    BenchmarkRunner(int repetitions, const std::string &filter);
+
+    bool enableCounters(const std::vector<PerfEventSpec> &events); // Hardware counters next to the times
+
+    size_t workingSetBytes(CacheLevel level) const { return cacheTargets[level]; }
+    static const char *levelName(CacheLevel level);
+
+    // body processes `items` items touching `bytes` bytes; skipped when the name does not contain the filter
+    void run(const std::string &name, CacheLevel level, size_t items, size_t bytes, const std::function<void()> &body);
+
+    void printTable() const;
+    bool writeCsv(const std::string &path) const;
+
+private:
+    int repetitions;
+    std::string filter;
+    size_t cacheTargets[CACHE_LEVEL_COUNT];
+    std::vector<BenchmarkResult> results;
+    PerfCounters counters;
+};
+
+// Keeps the compiler from dropping work whose result is only written to memory
+inline void benchmarkClobber(const void *pointer)
+{
+    asm volatile("" : : "r"(pointer) : "memory");
+}
+
+#endif // BENCH_H
@@ -0,0 +1,203 @@
+/*
+ * File:        perf_gate.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Kernel regression gate - measures every ocean kernel per wave count and compares the timing
+ *              distributions against a stored baseline, exit status 1 on a significant slowdown
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "Baseline.h"
+#include "Ocean.h"
+#include "Timing.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#define GATE_DEFAULT_SAMPLES 300 // The reference kernel at 8 waves takes ~35 ms a run
+#define GATE_WARMUP_RUNS 20
+#define GATE_GRID_SIZE 200 // The game's ocean
+
+// Exit status
+#define GATE_PASS 0
+#define GATE_REGRESSION 1
+#define GATE_ERROR 2
+
+namespace
+{
+    void measure(Baseline &baseline, int maxWaves, int samples)
+    {
+        Ocean ocean(static_cast<int>(baseline.gridSize));
+        ocean.generate(); // Grid and LUT, no GL
+        std::vector<GerstnerWave> waves = Ocean::standardWaves();
+
+        for (int count = 1; count <= maxWaves; ++count)
+        {
+            ocean.setWaves(std::vector<GerstnerWave>(waves.begin(), waves.begin() + count));
+            for (int kernel = 0; kernel < OCEAN_KERNEL_COUNT; ++kernel)
+            {
+                OceanKernel oceanKernel = static_cast<OceanKernel>(kernel);
+                BaselineCase entry = {std::string(Ocean::kernelName(oceanKernel)) + "/" + std::to_string(count) + "waves", {}};
+                entry.samples.reserve(samples);
+                ocean.time = 0.0f;
+                for (int run = 0; run < GATE_WARMUP_RUNS + samples; ++run)
+                {
+                    ocean.time += 1.0f / 60.0f; // Phases move as in the game
+                    _mm_lfence();
+                    uint64_t begin = __rdtsc();
+                    ocean.runKernel(oceanKernel);
+                    _mm_lfence();
+                    uint64_t end = __rdtsc();
+                    if (run >= GATE_WARMUP_RUNS)
+                    {
+                        entry.samples.push_back(static_cast<uint64_t>(Timing::ticksToNanoseconds(end - begin)));
+                    }
+                }
+                std::printf("  %-20s %zu samples\n", entry.name.c_str(), entry.samples.size());
+                std::fflush(stdout);
+                baseline.cases.push_back(entry);
+            }
+        }
+    }
+
+    int compare(const Baseline &stored, const Baseline &current, double alpha, double threshold)
+    {
+        if (stored.host != current.host)
+        {
+            std::printf("Warning: baseline from '%s', running on '%s'\n", stored.host.c_str(), current.host.c_str());
+        }
+        if (stored.gridSize != current.gridSize)
+        {
+            std::printf("Warning: baseline grid %u, current grid %u\n", stored.gridSize, current.gridSize);
+        }
+
+        std::printf("\n%-20s %12s %12s %8s %10s  %s\n", "case", "base us", "now us", "ratio", "p(slower)", "verdict");
+        int regressions = 0;
+        for (const BaselineCase &entry : current.cases)
+        {
+            const BaselineCase *reference = stored.find(entry.name);
+            SampleComparison result = compareSamples(reference ? reference->samples : std::vector<uint64_t>(), entry.samples, alpha, threshold);
+            if (reference == nullptr)
+            {
+                std::printf("%-20s %12s %12.1f %8s %10s  not in baseline\n", entry.name.c_str(), "-", result.currentMedian / 1000.0, "-", "-");
+                continue;
+            }
+            const char *verdict = result.regression ? "REGRESSION" : (result.improvement ? "faster" : "ok");
+            std::printf("%-20s %12.1f %12.1f %8.3f %10.2g  %s\n", entry.name.c_str(), result.baselineMedian / 1000.0,
+                        result.currentMedian / 1000.0, result.ratio, result.pSlower, verdict);
+            regressions += result.regression ? 1 : 0;
+        }
+        std::printf("Medians; a regression needs p < %g and a median %.1f %% slower.\n", alpha, threshold * 100.0);
+        if (regressions > 0)
+        {
+            std::printf("%d regression(s)\n", regressions);
+            return GATE_REGRESSION;
+        }
+        return GATE_PASS;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int samples = GATE_DEFAULT_SAMPLES;
+    int maxWaves = static_cast<int>(Ocean::standardWaves().size());
+    int gridSize = GATE_GRID_SIZE;
+    double alpha = BASELINE_DEFAULT_ALPHA;
+    double threshold = BASELINE_DEFAULT_THRESHOLD;
+    std::string savePath, comparePath, importDirectory;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--samples" && i + 1 < argc)
+        {
+            samples = std::atoi(argv[++i]);
+        }
+        else if (argument == "--waves" && i + 1 < argc)
+        {
+            maxWaves = std::atoi(argv[++i]);
+        }
+        else if (argument == "--grid" && i + 1 < argc)
+        {
+            gridSize = std::atoi(argv[++i]);
+        }
+        else if (argument == "--alpha" && i + 1 < argc)
+        {
+            alpha = std::atof(argv[++i]);
+        }
+        else if (argument == "--threshold" && i + 1 < argc)
+        {
+            threshold = std::atof(argv[++i]);
+        }
+        else if (argument == "--save" && i + 1 < argc)
+        {
+            savePath = argv[++i];
+        }
+        else if (argument == "--compare" && i + 1 < argc)
+        {
+            comparePath = argv[++i];
+        }
+        else if (argument == "--import" && i + 1 < argc)
+        {
+            importDirectory = argv[++i];
+        }
+        else
+        {
+            savePath.clear();
+            comparePath.clear();
+            break;
+        }
+    }
+    if ((savePath.empty() && comparePath.empty()) || (!importDirectory.empty() && savePath.empty()))
+    {
+        std::fprintf(stderr, "Usage: %s [--compare BASELINE] [--save BASELINE] [--samples N] [--waves 1-%zu] [--grid N]\n"
+                             "       [--alpha P] [--threshold FRACTION]\n"
+                             "       %s --import docs/data --save BASELINE [--waves N]\n"
+                             "Exit status %d when a kernel got slower than the baseline, %d on errors.\n",
+                     argv[0], Ocean::standardWaves().size(), argv[0], GATE_REGRESSION, GATE_ERROR);
+        return GATE_ERROR;
+    }
+    if (samples < 20 || maxWaves < 1 || maxWaves > static_cast<int>(Ocean::standardWaves().size()) || gridSize < 8)
+    {
+        std::fprintf(stderr, "Need --samples >= 20, --waves 1-%zu and --grid >= 8\n", Ocean::standardWaves().size());
+        return GATE_ERROR;
+    }
+
+    Baseline stored; // Loaded first, a bad path should not cost a full measurement
+    if (!comparePath.empty() && !stored.load(comparePath))
+    {
+        return GATE_ERROR;
+    }
+
+    Timing::calibrate();
+    Baseline current;
+    current.host = Timing::cpuBrand();
+    current.gridSize = static_cast<uint32_t>(gridSize);
+    if (!importDirectory.empty())
+    {
+        // The plotted runs carry no host, keep the field empty so comparisons warn
+        current.host.clear();
+        if (!current.importPlotData(importDirectory, maxWaves))
+        {
+            return GATE_ERROR;
+        }
+    }
+    else
+    {
+        std::printf("Measuring on %s, grid %d, %d samples per case\n", current.host.c_str(), gridSize, samples);
+        measure(current, maxWaves, samples);
+    }
+
+    int status = GATE_PASS;
+    if (!comparePath.empty())
+    {
+        status = compare(stored, current, alpha, threshold);
+    }
+    if (!savePath.empty() && !current.save(savePath))
+    {
+        return GATE_ERROR;
+    }
+    return status;
+}
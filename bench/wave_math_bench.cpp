@@ -0,0 +1,259 @@
+/*
+ * File:        wave_math_bench.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Microbenchmarks of the ocean kernel building blocks across L1, L2, LLC and DRAM working sets
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "Bench.h"
+#include "Ocean.h"
+#include "WaveMath.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Item count for a working set, a multiple of the 8 AVX lanes
+    size_t itemsFor(const BenchmarkRunner &runner, CacheLevel level, size_t bytesPerItem)
+    {
+        size_t items = runner.workingSetBytes(level) / bytesPerItem;
+        return std::max<size_t>(8, items & ~size_t(7));
+    }
+
+    std::vector<float> randomFloats(size_t count, float low, float high, unsigned seed)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> distribution(low, high);
+        std::vector<float> values(count);
+        for (float &value : values)
+        {
+            value = distribution(generator);
+        }
+        return values;
+    }
+
+    void benchTrigonometry(BenchmarkRunner &runner, CacheLevel level)
+    {
+        // Phases the kernel sees: k * dot(direction, position) - w * time over a 200 m grid
+        size_t items = itemsFor(runner, level, 12);
+        std::vector<float> angles = randomFloats(items, -200.0f, 200.0f, 1);
+        std::vector<int> indices(items);
+        std::vector<float> sines(items), cosines(items);
+
+        runner.run("lut_idx", level, items, items * 8, [&]()
+                   {
+            for (size_t i = 0; i < items; i += 8)
+            {
+                __m256i index = WaveMath::lutIndex(_mm256_loadu_ps(&angles[i]), LUT_SIZE);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(&indices[i]), index);
+            }
+            benchmarkClobber(indices.data()); });
+
+        // The two tables add 2 * LUT_SIZE * 4 bytes of random access on top of the working set
+        runner.run("sincos LUT gather", level, items, items * 12, [&]()
+                   {
+            for (size_t i = 0; i < items; i += 8)
+            {
+                __m256 s, c;
+                WaveMath::sincosLut(_mm256_loadu_ps(&angles[i]), sin_lut.data(), cos_lut.data(), LUT_SIZE, s, c);
+                _mm256_storeu_ps(&sines[i], s);
+                _mm256_storeu_ps(&cosines[i], c);
+            }
+            benchmarkClobber(sines.data()); });
+
+        runner.run("sincos polynomial", level, items, items * 12, [&]()
+                   {
+            for (size_t i = 0; i < items; i += 8)
+            {
+                __m256 s, c;
+                WaveMath::sincosPolynomial(_mm256_loadu_ps(&angles[i]), s, c);
+                _mm256_storeu_ps(&sines[i], s);
+                _mm256_storeu_ps(&cosines[i], c);
+            }
+            benchmarkClobber(sines.data()); });
+
+        runner.run("sincos std::sin/std::cos", level, items, items * 12, [&]()
+                   {
+            for (size_t i = 0; i < items; ++i)
+            {
+                sines[i] = std::sin(angles[i]);
+                cosines[i] = std::cos(angles[i]);
+            }
+            benchmarkClobber(sines.data()); });
+    }
+
+    void benchNormalStore(BenchmarkRunner &runner, CacheLevel level)
+    {
+        size_t items = itemsFor(runner, level, 24);
+        std::vector<float> x = randomFloats(items, -1.0f, 1.0f, 2);
+        std::vector<float> y = randomFloats(items, -1.0f, 1.0f, 3);
+        std::vector<float> z = randomFloats(items, -1.0f, 1.0f, 4);
+        std::vector<float> normals(items * 3);
+
+        runner.run("normal store extract", level, items, items * 24, [&]()
+                   {
+            for (size_t i = 0; i < items; i += 8)
+            {
+                WaveMath::storeNormalsExtract(&normals[i * 3], _mm256_loadu_ps(&x[i]), _mm256_loadu_ps(&y[i]), _mm256_loadu_ps(&z[i]));
+            }
+            benchmarkClobber(normals.data()); });
+
+        runner.run("normal store shuffle", level, items, items * 24, [&]()
+                   {
+            for (size_t i = 0; i < items; i += 8)
+            {
+                WaveMath::storeNormalsShuffle(&normals[i * 3], _mm256_loadu_ps(&x[i]), _mm256_loadu_ps(&y[i]), _mm256_loadu_ps(&z[i]));
+            }
+            benchmarkClobber(normals.data()); });
+    }
+
+    void benchConversions(BenchmarkRunner &runner, CacheLevel level)
+    {
+        size_t items = itemsFor(runner, level, 24);
+        std::vector<glm::vec3> vertices(items, glm::vec3(1.0f, 2.0f, 3.0f));
+        std::vector<float> packed(items * 3);
+        std::vector<float> heights(items);
+
+        runner.run("convert_vec3_to_float_array", level, items, items * 24, [&]()
+                   {
+            convert_vec3_to_float_array(vertices, packed.data());
+            benchmarkClobber(packed.data()); });
+
+        runner.run("convert_float_array_to_vec3", level, items, items * 24, [&]()
+                   {
+            convert_float_array_to_vec3(packed.data(), vertices);
+            benchmarkClobber(vertices.data()); });
+
+        runner.run("convert_verts_y_to_float_array", level, items, items * 16, [&]()
+                   {
+            convert_verts_y_to_float_array(vertices, heights.data());
+            benchmarkClobber(heights.data()); });
+
+        runner.run("float_array_to_verts", level, items, items * 16, [&]()
+                   {
+            float_array_to_verts(heights.data(), packed.data(), items);
+            benchmarkClobber(packed.data()); });
+
+        size_t waveCount = itemsFor(runner, level, 2 * sizeof(GerstnerWave));
+        std::vector<GerstnerWave> waves(waveCount, GerstnerWave{1.0f, 10.0f, 1.0f, glm::vec2(1.0f, 0.0f), 0.0f});
+        std::vector<float> soa(waveCount * 6);
+        runner.run("convert_gerstner_aos_to_float_soa", level, waveCount, waveCount * 2 * sizeof(GerstnerWave), [&]()
+                   {
+            convert_gerstner_aos_to_float_soa(waves, soa.data());
+            benchmarkClobber(soa.data()); });
+    }
+
+    void benchPointQueries(BenchmarkRunner &runner, CacheLevel level, const Ocean &ocean)
+    {
+        // Boat-style queries at random points of the grid, 8 bytes in and the result out
+        size_t items = itemsFor(runner, level, 20);
+        std::vector<float> x = randomFloats(items, -100.0f, 100.0f, 5);
+        std::vector<float> z = randomFloats(items, -100.0f, 100.0f, 6);
+        std::vector<float> heights(items);
+        std::vector<glm::vec3> normals(items);
+        const float time = 12.5f;
+
+        runner.run("Ocean::getWaveHeight", level, items, items * 12, [&]()
+                   {
+            for (size_t i = 0; i < items; ++i)
+            {
+                heights[i] = ocean.getWaveHeight(x[i], z[i], time);
+            }
+            benchmarkClobber(heights.data()); });
+
+        runner.run("Ocean::getWaveNormal", level, items, items * 20, [&]()
+                   {
+            for (size_t i = 0; i < items; ++i)
+            {
+                normals[i] = ocean.getWaveNormal(x[i], z[i], time);
+            }
+            benchmarkClobber(normals.data()); });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int repetitions = BENCH_DEFAULT_REPETITIONS;
+    std::string filter;
+    std::string csvPath;
+    bool perf = false;
+    std::string perfEvents;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--reps" && i + 1 < argc)
+        {
+            repetitions = std::atoi(argv[++i]);
+        }
+        else if (argument == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (argument == "--csv" && i + 1 < argc)
+        {
+            csvPath = argv[++i];
+        }
+        else if (argument == "--perf")
+        {
+            perf = true;
+        }
+        else if (argument == "--perf-events" && i + 1 < argc)
+        {
+            perf = true;
+            perfEvents = argv[++i];
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [--reps N] [--filter SUBSTRING] [--csv FILE] [--perf] [--perf-events name=rUUEE,...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (repetitions < 3)
+    {
+        std::fprintf(stderr, "--reps must be at least 3\n");
+        return 1;
+    }
+
+    BenchmarkRunner runner(repetitions, filter);
+    if (perf)
+    {
+        std::vector<PerfEventSpec> events = PerfCounters::defaultEvents();
+        if (!PerfCounters::parseRawEvents(perfEvents, events))
+        {
+            return 1;
+        }
+        if (!runner.enableCounters(events))
+        {
+            std::fprintf(stderr, "No hardware counters available, timing only\n");
+        }
+    }
+    initializeSinCosLUT();
+    Ocean ocean(200); // Point queries only need the waves, no grid and no GL
+
+    for (int level = CACHE_L1; level < CACHE_LEVEL_COUNT; ++level)
+    {
+        CacheLevel cacheLevel = static_cast<CacheLevel>(level);
+        std::printf("%s working set\n", BenchmarkRunner::levelName(cacheLevel));
+        benchTrigonometry(runner, cacheLevel);
+        benchNormalStore(runner, cacheLevel);
+        benchConversions(runner, cacheLevel);
+        benchPointQueries(runner, cacheLevel, ocean);
+    }
+
+    runner.printTable();
+    if (!csvPath.empty() && !runner.writeCsv(csvPath))
+    {
+        std::fprintf(stderr, "Cannot write %s\n", csvPath.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include "Ocean.h"
+#include <string>
+#include <vector>
+
+// Picks the fastest surface kernel configuration for this host, grid and wave set.
+//
+// Every candidate (kernel x thread count x tile size) runs through Ocean::runKernel on the ocean's own grid
+// and waves, and the lowest median wins. The choice goes to a text cache keyed by the CPU brand, the
+// hardware thread count, the grid and a hash of the waves, so later starts with the same key only read it.
+// One line per key, the last one wins:  key <TAB> kernel threads tile nanoseconds
+
+#define AUTOTUNE_CACHE_PATH ".cache/ocean_autotune.txt"
+#define AUTOTUNE_VERSION 1 // Part of the key, bump when the kernels or candidates change
+
+#define AUTOTUNE_WARMUP_RUNS 3
+#define AUTOTUNE_MIN_SAMPLES 5
+#define AUTOTUNE_MAX_SAMPLES 25
+#define AUTOTUNE_CANDIDATE_NS 20000000ull // Sampling stops after this much time per candidate (MIN_SAMPLES first)
+
+struct OceanTuning
+{
+    OceanKernel kernel;
+    unsigned threads;
+    size_t tileVertices; // 0 = the whole grid in one task
+    double nanoseconds;  // Median per run, 0 before measuring
+};
+
+namespace Autotune
+{
+    std::string key(const Ocean &ocean);
+    std::vector<OceanTuning> candidates(const Ocean &ocean);
+
+    double measure(Ocean &ocean, const OceanTuning &candidate); // Median nanoseconds, leaves the configuration set
+    OceanTuning tune(Ocean &ocean, bool verbose);                // Fastest candidate, the ocean left configured with it
+
+    bool load(const std::string &path, const std::string &key, OceanTuning &tuning); // False when not cached
+    bool save(const std::string &path, const std::string &key, const OceanTuning &tuning);
+
+    // The cached choice for this ocean, or a new tuning stored for next time (always when retune); applied
+    // to the ocean either way
+    OceanTuning apply(Ocean &ocean, const std::string &path, bool retune);
+}
+
+#endif // AUTOTUNE_H
@@ -6,21 +6,31 @@
 #include <vector>
 #include "Input.h"
 #include "Ocean.h"
+#include "MeshOptimizer.h"
 #include <string>
 #include <tiny_obj_loader.h> // Include tinyobjloader
 
+#define BOAT_MAX_MATERIALS 64      // Size of the Materials uniform block (must match boat shaders)
+#define BOAT_MATERIALS_BINDING 1   // Uniform buffer binding point of the Materials block
+
 class Boat {
 public:
     Boat();
     ~Boat();
 
     bool init(const char* modelPath, const char* texturePath); // Pass model and texture paths
+    bool load(const char* modelPath, const char* texturePath); // CPU part of init, needs no GL context
     void cleanup();
     void update(const Input& input, const Ocean& ocean, float deltaTime);
 
     glm::vec3 getPosition() const { return position; }
     glm::quat getRotation() const { return rotation; }
 
+    // State between the last two simulation steps, alpha in [0, 1] (set by Game before rendering)
+    void interpolate(float alpha);
+    glm::vec3 getRenderPosition() const { return renderPosition; }
+    glm::quat getRenderRotation() const { return renderRotation; }
+
     glm::vec3 getBoundingBoxMin() const { return boundingBoxMin; } // **Getter for boundingBoxMin**
     glm::vec3 getBoundingBoxMax() const { return boundingBoxMax; } // **Getter for boundingBoxMax**
 
@@ -31,6 +41,14 @@ public:
     const std::string& getTexturePath() const { return boatTexturePath; } // Getter for texture path
     const std::vector<tinyobj::material_t>& getMaterials() const { return materials; } // Getter for materials
     const std::vector<int>& getMaterialIndices() const { return materialIndices; } // Getter for materials
+    const std::vector<unsigned int>& getIndices() const { return indices; } // Triangle list into the welded vertices
+    const std::vector<unsigned short>& getIndices16() const { return indices16; } // Same indices packed to 16 bits (empty if they do not fit)
+    bool usesShortIndices() const { return !indices16.empty(); }
+    const std::vector<MeshBatch>& getBatches() const { return batches; } // One draw call per material
+
+    GLuint getVAO() const { return vaoID; }
+    GLenum getIndexType() const { return usesShortIndices() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+    GLuint getMaterialBufferID() const { return materialBufferID; } // std140 block of material diffuse colors
 
     // New: Getter and Setter for boatScale
     float getScale() const { return boatScale; }
@@ -40,6 +58,10 @@ public:
 private:
     glm::vec3 position;
     glm::quat rotation;
+    glm::vec3 previousPosition; // State before the last update
+    glm::quat previousRotation;
+    glm::vec3 renderPosition;
+    glm::quat renderRotation;
     float speed;
     float steeringSpeed;
 
@@ -47,12 +69,23 @@ private:
     std::vector<glm::vec3> normals;
     std::vector<glm::vec2> texCoords;
     std::vector<int> materialIndices; // New: Store material indices per vertex
+    std::vector<unsigned int> indices; // Index buffer of the welded, cache-optimized mesh
+    std::vector<unsigned short> indices16; // 16-bit copy of indices when the vertex count allows it
     std::vector<tinyobj::material_t> materials; // New: Store materials
+    std::vector<MeshBatch> batches; // Index ranges grouped by material
+
+    GLuint vertexBufferID;
+    GLuint normalBufferID;
+    GLuint texCoordBufferID;
+    GLuint indexBufferID;
+    GLuint materialBufferID;
+    GLuint vaoID;
 
 
     void handleInput(const Input& input, float deltaTime);
-    void applyWaveMotion(const Ocean& ocean);
+    void applyWaveMotion(const Ocean& ocean, float deltaTime);
     bool loadModel(const char* path); // Function to load OBJ model
+    void createBuffers(); // Upload the indexed mesh and material colors once
     std::string boatTexturePath; // Store texture path for Renderer to access
     glm::vec3 boundingBoxMin;
     glm::vec3 boundingBoxMax;
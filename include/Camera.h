@@ -12,11 +12,16 @@ public:
 
     void init();
     void update(const Input& input, const glm::vec3& boatPosition);
-    void lookAt() const;
 
-    void setAspectRatio(float ratio) { aspectRatio = ratio; }
-    glm::vec3 getPosition() const { return position; } // Public getter for position
-    glm::mat4 getViewMatrix() const; // **Declare getViewMatrix() method**
+    void setAspectRatio(float ratio);
+    void interpolate(float alpha); // Eye between the last two updates, alpha in [0, 1] (set by Game before rendering)
+    glm::vec3 getPosition() const { return eyePosition; } // Eye used for rendering
+
+    // Computed once in update/interpolate/setAspectRatio, draws only read them
+    const glm::mat4& getViewMatrix() const { return viewMatrix; }
+    const glm::mat4& getProjectionMatrix() const { return projectionMatrix; }
+    const glm::mat4& getViewProjectionMatrix() const { return viewProjectionMatrix; }
+    float getFov() const { return fov; } // Vertical field of view in degrees
 
         // New: Camera Rotation Control
         void handleMouseInput(const Input& input, float deltaTime);
@@ -26,10 +31,17 @@ private:
     glm::vec3 position;
     glm::vec3 target; // Point to look at
     glm::vec3 up;
+    glm::vec3 previousPosition; // State before the last update
+    glm::vec3 previousTarget;
+    glm::vec3 eyePosition;      // Interpolated position of the rendered frame
     float aspectRatio;
     float fov;
     float nearPlane;
     float farPlane;
+    glm::mat4 viewMatrix;
+    glm::mat4 projectionMatrix;
+    glm::mat4 viewProjectionMatrix;
+
 
 
     // New: Camera Rotation State
@@ -0,0 +1,65 @@
+#ifndef DEBUG_DRAW_H
+#define DEBUG_DRAW_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "Shader.h"
+
+#define DEBUG_DRAW_NORMAL_LENGTH 0.5f
+#define DEBUG_DRAW_INITIAL_VERTICES (64 * 1024) // Grows when a frame needs more
+
+// Debug layers, toggled at runtime (see Game::keyboardCallback)
+enum DebugLayer
+{
+    DEBUG_LAYER_NORMALS = 1 << 0,
+    DEBUG_LAYER_GRID = 1 << 1,
+    DEBUG_LAYER_BOUNDING_BOXES = 1 << 2
+};
+
+// Collects debug lines during a frame and draws all of them with one glDrawArrays(GL_LINES).
+// The vertex buffer is orphaned and refilled every frame.
+class DebugDraw
+{
+public:
+    DebugDraw();
+    ~DebugDraw();
+
+    bool init(); // Needs a GL context
+    void cleanup();
+
+    void setLayers(unsigned layers) { enabledLayers = layers; }
+    void toggleLayer(DebugLayer layer) { enabledLayers ^= layer; }
+    bool isEnabled(DebugLayer layer) const { return (enabledLayers & layer) != 0; }
+    bool isActive() const { return enabledLayers != 0; }
+
+    void line(const glm::vec3 &from, const glm::vec3 &to, const glm::vec3 &color);
+
+    // Box given in model space, drawn with the model matrix applied on the CPU
+    void box(const glm::vec3 &boxMin, const glm::vec3 &boxMax, const glm::mat4 &model, const glm::vec3 &color);
+
+    // Grid vertices and normals in x * verticesZ + z order, as produced by the ocean kernel and the terrain
+    void gridNormals(const std::vector<glm::vec3> &positions, const std::vector<glm::vec3> &normals, const glm::vec3 &color);
+    void gridLines(const std::vector<glm::vec3> &positions, int verticesX, int verticesZ, const glm::vec3 &offset, const glm::vec3 &color);
+
+    // Upload and draw everything collected since the last flush, the shader reads view/projection from the Frame block
+    void flush(Shader &shader);
+
+private:
+    struct DebugVertex
+    {
+        glm::vec3 position;
+        uint32_t color; // RGBA8
+    };
+
+    unsigned enabledLayers;
+    std::vector<DebugVertex> vertices;
+    GLuint vaoID;
+    GLuint vertexBufferID;
+    size_t bufferCapacity; // In vertices
+
+    static uint32_t packColor(const glm::vec3 &color);
+};
+
+#endif // DEBUG_DRAW_H
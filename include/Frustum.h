@@ -0,0 +1,22 @@
+// Frustum.h
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// View frustum planes for culling, extracted from a projection * view matrix
+class Frustum {
+public:
+    Frustum() {}
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    void extract(const glm::mat4& viewProjection);
+
+    // False only when the box is completely outside one of the planes (conservative)
+    bool intersects(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+private:
+    glm::vec4 planes[6]; // left, right, bottom, top, near, far - normals point inside
+};
+
+#endif // FRUSTUM_H
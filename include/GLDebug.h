@@ -0,0 +1,38 @@
+#ifndef GL_DEBUG_H
+#define GL_DEBUG_H
+
+#include <GL/glew.h>
+
+// GL error reporting for debug builds (make debug, -DDEBUG). Release builds compile all of it out,
+// so nothing polls glGetError on the hot path.
+//
+// With KHR_debug the driver calls back synchronously from the failing call, the message names the innermost
+// GL_DEBUG_SCOPE labels and the groups show up in RenderDoc/apitrace. Without it each scope polls
+// glGetError once when it closes.
+
+#ifdef DEBUG
+
+void initGLDebug(); // Call once after glewInit
+
+class GLDebugScope
+{
+public:
+    explicit GLDebugScope(const char *label);
+    ~GLDebugScope();
+
+    GLDebugScope(const GLDebugScope &) = delete;
+    GLDebugScope &operator=(const GLDebugScope &) = delete;
+};
+
+#define GL_DEBUG_CONCAT_INNER(a, b) a##b
+#define GL_DEBUG_CONCAT(a, b) GL_DEBUG_CONCAT_INNER(a, b)
+#define GL_DEBUG_SCOPE(label) GLDebugScope GL_DEBUG_CONCAT(glDebugScope, __LINE__)(label)
+
+#else
+
+inline void initGLDebug() {}
+#define GL_DEBUG_SCOPE(label) ((void)0)
+
+#endif // DEBUG
+
+#endif // GL_DEBUG_H
@@ -10,7 +10,15 @@
 #include "Camera.h"
 #include <cstdio>
 #include <iostream>
+#include <chrono>
+#include <fstream>
+#include <string>
 #include "Terrain.h" // Include Terrain header
+#include "Replay.h"
+
+#define GAME_DEFAULT_SIM_RATE 60.0  // Simulation steps per second, --sim-rate overrides it
+#define GAME_MAX_FRAME_TIME 0.25    // Real time simulated per frame at most (seconds), longer stalls are dropped
+#define GAME_MAX_STEPS_PER_FRAME 8  // Spiral-of-death cap, the rest of the accumulator is dropped
 
 class Game {
 public:
@@ -29,6 +37,40 @@ private:
     Camera camera;
     Terrain terrain; // Add Terrain member
 
+    // Fixed-step loop: real time is accumulated and consumed in steps of 1 / simRate
+    double simRate;
+    double accumulator;
+    std::chrono::steady_clock::time_point lastFrameTime;
+
+    // --headless: no window and no GL context, the simulation steps in a plain loop
+    bool headless;
+    long headlessFrames;    // --frames, steps to run
+    double headlessSeconds; // --seconds, simulated time to run (used when --frames is not given)
+    bool realtime;          // --realtime, pace the steps to the wall clock instead of running flat out
+    std::string metricsPath; // --out, CSV with one row per step
+    std::ofstream metrics;
+
+    // --record / --replay: input and step length of every step (Replay.h); a replay runs one step per frame
+    // (or flat out headless) and ends the run when the recording does
+    ReplayWriter recorder;
+    ReplayReader replay;
+    std::chrono::steady_clock::time_point replayStart;
+
+    // Surface kernel, threads and tile from the autotuner (Autotune.h) unless --kernel picks one;
+    // --autotune measures again instead of reading the cached choice
+    bool autotune;
+    bool retune;
+
+    bool parseArguments(int argc, char** argv);
+    bool prepareStep(float& deltaTime); // Applies the replay and records, false when the replay has ended
+    bool initSimulation(); // Headless init: the CPU halves of Ocean, Boat and Terrain init
+    void tuneOcean();      // After the ocean grid exists
+    void runHeadless();
+    void writeMetrics(long frame, double stepMilliseconds);
+    void closeRecording(); // Writes out the buffered records, once
+
+    static void closeRecordingAtExit();
+
 
     static void displayCallback();
     static void reshapeCallback(int width, int height);
@@ -38,8 +80,8 @@ private:
     static void specialUpCallback(int key, int x, int y);
     static void mouseCallback(int button, int state, int x, int y);
     static void motionCallback(int x, int y);
-    static void timerCallback(int value);
-    static void updateGame();
+    static void idleCallback();
+    static void updateGame(float deltaTime);
 
     static Game* instance; // Singleton for callbacks to access game instance
 };
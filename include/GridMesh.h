@@ -0,0 +1,36 @@
+#ifndef GRID_MESH_H
+#define GRID_MESH_H
+
+#include <GL/glew.h>
+#include <vector>
+#include <cstddef>
+
+#define GRID_RESTART_INDEX_16 0xFFFFu
+#define GRID_RESTART_INDEX_32 0xFFFFFFFFu
+
+// Static index buffer of a regular vertex grid drawn as triangle strips (one strip per x row, primitive restart between them).
+// Vertices are laid out x * verticesZ + z. With skirts the grid is followed by a ring of skirt vertices:
+// z = 0 edge (verticesX), x = last edge (verticesZ), z = last edge (verticesX), x = 0 edge (verticesZ).
+struct GridIndexBuffer
+{
+    GLuint bufferID;
+    GLenum indexType;   // GL_UNSIGNED_SHORT whenever all vertices fit below the restart index
+    GLsizei indexCount;
+    GLuint restartIndex;
+};
+
+size_t gridVertexCount(int verticesX, int verticesZ, bool skirts);
+
+// Strip indices with GRID_RESTART_INDEX_32 between strips
+void buildGridStrips(int verticesX, int verticesZ, bool skirts, std::vector<unsigned int> &indices);
+
+// One shared buffer per grid size, created on first use. Bind it as GL_ELEMENT_ARRAY_BUFFER while the VAO is bound.
+const GridIndexBuffer *acquireGridIndexBuffer(int verticesX, int verticesZ, bool skirts);
+void releaseGridIndexBuffer(const GridIndexBuffer *grid); // The buffer is deleted with its last user
+
+// Primitive restart is only switched on around grid draws
+void beginGridDraw(const GridIndexBuffer &grid);
+void drawGrid(const GridIndexBuffer &grid, GLint baseVertex = 0);
+void endGridDraw();
+
+#endif // GRID_MESH_H
@@ -3,6 +3,20 @@
 #define INPUT_H
 
 #include <set>
+#include <vector>
+
+// Everything the simulation reads from Input in one step, recorded and replayed by Replay.h
+struct InputSnapshot {
+    std::vector<unsigned char> keys; // Sorted, as the sets iterate
+    std::vector<int> specialKeys;
+    unsigned char mouseButtons;      // Bit per button
+    int mouseX, mouseY;
+
+    bool operator==(const InputSnapshot& other) const {
+        return keys == other.keys && specialKeys == other.specialKeys && mouseButtons == other.mouseButtons &&
+               mouseX == other.mouseX && mouseY == other.mouseY;
+    }
+};
 
 class Input {
 public:
@@ -30,6 +44,10 @@ public:
     int getMouseDeltaX() const { return mouseDeltaX; }
     int getMouseDeltaY() const { return mouseDeltaY; }
 
+    // Held keys, buttons and pointer; restore replaces them, the next update derives the deltas as live input would
+    InputSnapshot snapshot() const;
+    void restore(const InputSnapshot& snapshot);
+
 
 private:
     std::set<unsigned char> keysDown;
@@ -0,0 +1,55 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+
+// Post-transform vertex cache size used for the triangle reordering and for the ACMR estimate
+#define VERTEX_CACHE_SIZE 32
+#define ACMR_FIFO_SIZE 16
+
+// Load-time statistics of the indexed mesh pipeline
+struct MeshStats
+{
+    size_t sourceVertices;   // Vertices before welding (3 per triangle)
+    size_t uniqueVertices;   // Vertices after welding
+    size_t triangles;
+    size_t bytesBefore;      // Non-indexed vertex data
+    size_t bytesAfter;       // Welded vertex data + index buffer
+    float acmrBefore;        // Average cache miss ratio (vertex shader runs per triangle)
+    float acmrAfter;
+    bool shortIndices;       // 16-bit index buffer is used
+};
+
+// Contiguous range of the index buffer drawn with one material
+struct MeshBatch
+{
+    int material;             // Index into the material list, -1 for none
+    unsigned int firstIndex;
+    unsigned int indexCount;
+};
+
+// Merge vertices with identical position/normal/uv/material and build the index buffer
+void weldVertices(std::vector<glm::vec3> &vertices, std::vector<glm::vec3> &normals, std::vector<glm::vec2> &texCoords,
+                  std::vector<int> &materialIndices, std::vector<unsigned int> &indices);
+
+// Reorder triangles for post-transform cache locality (Forsyth's linear-speed algorithm)
+void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount);
+
+// Stable-partition triangles by material (keeps the cache-optimized order inside each batch)
+void buildMaterialBatches(std::vector<unsigned int> &indices, const std::vector<int> &materialIndices, std::vector<MeshBatch> &batches);
+
+// Reorder vertices in order of first use so vertex fetch follows the index stream
+void optimizeVertexFetch(std::vector<glm::vec3> &vertices, std::vector<glm::vec3> &normals, std::vector<glm::vec2> &texCoords,
+                         std::vector<int> &materialIndices, std::vector<unsigned int> &indices);
+
+// Average number of vertex shader invocations per triangle with a FIFO cache
+float computeACMR(const std::vector<unsigned int> &indices, size_t vertexCount, int cacheSize = ACMR_FIFO_SIZE);
+
+// Copy indices into 16-bit buffer, returns false (and leaves dst empty) if vertexCount does not fit
+bool packIndices16(const std::vector<unsigned int> &indices, size_t vertexCount, std::vector<unsigned short> &dst);
+
+void printMeshStats(const char *name, const MeshStats &stats);
+
+#endif // MESH_OPTIMIZER_H
@@ -0,0 +1,15 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <string>
+#include <vector>
+#include <tiny_obj_loader.h>
+
+// Multithreaded Wavefront OBJ parser.
+// The file is memory-mapped, split into line-aligned chunks that are parsed in parallel and merged in file order,
+// so the result is identical to tinyobj::LoadObj with triangulation (all faces end up in a single shape).
+// Materials are read from the mtllib files with tinyobj::LoadMtl.
+bool loadObjParallel(tinyobj::attrib_t *attrib, std::vector<tinyobj::shape_t> *shapes, std::vector<tinyobj::material_t> *materials,
+                     std::string *warn, std::string *err, const char *filename, const char *mtlBaseDir);
+
+#endif // OBJ_LOADER_H
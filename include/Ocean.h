@@ -4,8 +4,13 @@
 
 #include <glm/glm.hpp>
 #include <vector>
+#include <array>
+#include <string>
 #include <GL/glew.h> // Include GLEW for OpenGL types like GLuint
 #include "utils.h"   // **Include utils.h to use checkGLError**
+#include "GridMesh.h"
+#include "OceanJit.h"
+#include "OceanKernel.h"
 #include <immintrin.h>
 #include <x86intrin.h>
 
@@ -14,6 +19,10 @@
 #define INTRINSIC 1
 #define CLEAR_ASM 2
 
+#ifndef LUT_SIZE
+#define LUT_SIZE (20384 * 16)
+#endif
+
 // Structure to hold parameters for a single Gerstner wave component
 struct GerstnerWave
 {
@@ -24,6 +33,27 @@ struct GerstnerWave
     float phase;         // Phase offset
 };
 
+// Sine/cosine tables of the SIMD kernel and the layout conversions around it, also driven by bench/
+extern std::array<float, LUT_SIZE> sin_lut;
+extern std::array<float, LUT_SIZE> cos_lut;
+extern std::array<float, PHASE_LUT_SIZE> phase_sin_lut; // Fixed-point kernel tables, see OceanKernel.h
+extern std::array<float, PHASE_LUT_SIZE> phase_cos_lut;
+void initializeSinCosLUT();
+void convert_gerstner_aos_to_float_soa(const std::vector<GerstnerWave> &waves, float *dst); // 6 arrays of waves.size()
+void convert_verts_y_to_float_array(const std::vector<glm::vec3> &verts, float *dst);
+void float_array_to_verts(const float *arr, float *dst, size_t size); // Heights into the y of xyz triples
+
+// Kernels Ocean::runKernel can run on their own, the perf gate (bench/perf_gate.cpp) measures each
+enum OceanKernel
+{
+    OCEAN_KERNEL_REFERENCE, // Ocean::updateVertices, glm and libm per vertex and wave
+    OCEAN_KERNEL_SIMD,      // updateVertices_simd in xhricma00.s
+    OCEAN_KERNEL_SPECIALIZED, // OceanKernel.h, unrolled per wave count
+    OCEAN_KERNEL_JIT,         // OceanJit.h, generated at run time for the current waves
+    OCEAN_KERNEL_FIXED_POINT, // OceanKernel.h, integer phases accumulated per step
+    OCEAN_KERNEL_COUNT
+};
+
 class Ocean
 {
 public:
@@ -31,18 +61,48 @@ public:
     ~Ocean();
 
     bool init();
+    bool generate(); // CPU part of init, needs no GL context (headless runs)
     void cleanup();
     void update(float deltaTime);
 
+    // Sea state; standardWaves() are the eight waves behind docs/data/<N>waves, the game starts with the first two
+    static std::vector<GerstnerWave> standardWaves();
+    void setWaves(const std::vector<GerstnerWave> &waves);
+    const std::vector<GerstnerWave> &getWaves() const { return gerstnerWaves; }
+
+    // One pass of a kernel at the current time into scratch buffers, without the other kernels or an upload
+    void runKernel(OceanKernel kernel);
+    static const char *kernelName(OceanKernel kernel);
+    static const char *traceZone(OceanKernel kernel); // TRACE_ZONE_OCEAN_* of the kernel
+    static bool parseKernel(const std::string &name, OceanKernel &kernel);
+
+    // Kernel whose output update uploads (SIMD, specialized, JIT or fixed point); the reference always runs next to it
+    void setSurfaceKernel(OceanKernel kernel) { surfaceKernel = kernel; }
+    OceanKernel getSurfaceKernel() const { return surfaceKernel; }
+
+    // Threads (ThreadPool) and vertices per task for the specialized, JIT and fixed-point kernels (not the
+    // assembly); tiles are rounded up to whole 8-vertex blocks, 1 thread or tile 0 runs the grid in one piece
+    void setSurfaceThreading(unsigned threads, size_t tileVertices);
+    unsigned getSurfaceThreads() const { return surfaceThreads; }
+    size_t getSurfaceTile() const { return surfaceTile; }
+    size_t getVertexCount() const { return vertices.size(); }
+
     glm::vec3 getVertex(int x, int z) const;
     float getWaveHeight(float x, float z, float time) const;
     glm::vec3 getWaveNormal(float x, float z, float time) const; // Calculate wave normal
+    // Same, at the time of the surface the kernels last drew: from the fixed-point phases, which every step
+    // advances whatever kernel is active, so what floats on the water does not drift away from it in long runs
+    float getSurfaceHeight(float x, float z) const;
+    glm::vec3 getSurfaceNormal(float x, float z) const;
 
     void setGridSize(int newGridSize); // Setter function
     int getGridSize() const { return gridSize; }
     float getGridSpacing() const { return gridSpacing; }
     GLuint getVAO() const;        // Get the Vertex Array Object ID
     GLuint getIndexCount() const; // Get the number of indices for rendering
+    const GridIndexBuffer &getGridIndices() const { return *gridIndices; } // Shared strip index buffer
+    const std::vector<glm::vec3> &getSurfaceVertices() const { return surfaceVertices; } // Last kernel output, empty before the first update
+    const std::vector<glm::vec3> &getSurfaceNormals() const { return surfaceNormals; }
     float time;
 
 private:
@@ -50,6 +110,8 @@ private:
     float gridSpacing;
     std::vector<glm::vec3> vertices;         // Store vertices for optimization (optional)
     std::vector<GerstnerWave> gerstnerWaves; // Vector to store multiple Gerstner wave components
+    std::vector<glm::vec3> surfaceVertices;  // Displaced vertices and normals uploaded by the last update
+    std::vector<glm::vec3> surfaceNormals;
 
     // Wave parameters (adjustable)
     float amplitude;
@@ -61,16 +123,29 @@ private:
     GLuint vertexBufferID;   // VBO ID for vertex positions
     GLuint normalBufferID;   // VBO ID for vertex normals
     GLuint texCoordBufferID; // VBO ID for texture coordinates
-    GLuint indexBufferID;    // IBO ID for indices
+    const GridIndexBuffer *gridIndices; // Shared IBO (triangle strips), owned by GridMesh
     GLuint vaoID;            // VAO ID (Vertex Array Object)
-    unsigned int indexCount; // Number of indices for rendering
+    OceanKernel surfaceKernel;
+    unsigned surfaceThreads;
+    size_t surfaceTile;
+    OceanJit jit; // Code for the current waves, regenerated when they change
+    std::vector<WavePhase> wavePhases; // Fixed-point phases, one per wave, advanced every step
+    float phasesTime;                  // time they were last advanced to; anything else resets them
 
     std::vector<float> originalWorldX; // Vector to store original undisplaced World X coordinates
     std::vector<float> originalWorldZ; // Vector to store original undisplaced World Z coordinates
 
     float baseAmplitude; // Base (maximum) wave amplitude for periodic modulation
 
+    // runKernel outputs, kept between calls so repeated runs do not allocate
+    std::vector<glm::vec3> kernelVertices;
+    std::vector<glm::vec3> kernelNormals;
+    std::vector<float> kernelHeights;
+    std::vector<float> kernelNormalArray;
+    std::vector<float> kernelWaves;
+
     void generateGrid();
+    void runVectorKernel(OceanKernel kernel, float *heights, float *normals); // Specialized, JIT or fixed point
     void createBuffers();                                                                                            // Create and populate VBOs and IBO
     void updateBuffers(const std::vector<glm::vec3> &updatedVertices, const std::vector<glm::vec3> &updatedNormals); // Update VBO data
     // void updateVertices(std::vector<glm::vec3> * updatedVertices, std::vector<glm::vec3> * updatedNormals, float time); // Update vertex Y positions based on wave function
@@ -85,6 +160,11 @@ private:
 
     int getGridIndex(int x, int z) const;                                                                // Helper function to get 1D index from 2D grid indices
     float getGerstnerWaveHeight(const GerstnerWave &wave, float x, float z, float time) const;           // Calculate height for a single Gerstner wave
+    // travel = w * time and swell = 2pi * time / wavelength, the only places time enters a wave
+    float getGerstnerWaveHeight(const GerstnerWave &wave, float x, float z, float travel, float swell) const;
+    void addGerstnerWaveTangents(const GerstnerWave &wave, float x, float z, float travel, float swell, glm::vec3 &tangentX, glm::vec3 &tangentZ) const;
+    void syncPhases(); // Resets wavePhases from time unless they are current
+    void getSurfaceAngles(size_t wave, float &travel, float &swell) const;
     glm::vec3 getGerstnerWaveDisplacement(const GerstnerWave &wave, float x, float z, float time) const; // Calculate horizontal displacement for a Gerstner wave
 };
 
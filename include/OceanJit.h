@@ -0,0 +1,57 @@
+#ifndef OCEAN_JIT_H
+#define OCEAN_JIT_H
+
+#include "OceanKernel.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// AVX2 ocean kernel generated at run time for the current wave set.
+//
+// prepare emits machine code with the waves unrolled and every per-wave term as a RIP-relative memory
+// operand, so the vertex loop has no wave loop, no parameter addressing and no loads other than the grid
+// and the LUT gathers. The code goes to its own mapping: the code page is made read+execute once written,
+// the constant page after it stays writable, and run only refreshes the terms that change with time
+// (offset, amplitude, slopes) before calling it. Code is regenerated only when the waves change.
+// The phase terms are stored in turns instead of radians, which drops the two divisions by 2pi per wave
+// and vertex of the LUT lookup; the index can then differ from the compiled kernels' by one LUT entry.
+// The partial last block and hosts without AVX2/FMA use the compiled kernels (OceanKernel.h).
+
+#define OCEAN_JIT_MAX_WAVES 64 // Code grows by 128 bytes per wave
+
+class OceanJit
+{
+public:
+    OceanJit();
+    ~OceanJit();
+
+    OceanJit(const OceanJit &) = delete;
+    OceanJit &operator=(const OceanJit &) = delete;
+
+    // False when no code could be generated (CPU, mapping or too many waves), run then falls back
+    bool prepare(const GerstnerWave *waves, size_t waveCount, int lutSize);
+    void run(const OceanKernelArgs &args, const GerstnerWave *waves, size_t waveCount, float time); // setTime, then all vertices
+
+    // Terms for this time, then any number of runs over vertex ranges, also from several threads at once
+    void setTime(const GerstnerWave *waves, size_t waveCount, float time, const float *sinLut, int lutSize);
+    void run(const OceanKernelArgs &args, size_t begin, size_t end) const;
+
+    size_t getCodeSize() const { return codeSize; }
+
+private:
+    typedef void (*Function)(const float *originalX, const float *originalZ, float *heights, float *normals,
+                             size_t blockCount, const float *sinLut, const float *cosLut);
+
+    void release();
+
+    uint8_t *mapping; // Code pages, then constant pages
+    size_t mappingSize;
+    size_t codeSize;
+    float *constants;  // 8-float splats, see the layout in OceanJit.cpp
+    Function function;
+    std::vector<float> key; // Waves and LUT size the code was generated for
+    std::vector<WaveTerms> terms; // Of the last setTime, for the blocks the code does not cover
+    bool generated;               // setTime found code for the waves
+};
+
+#endif // OCEAN_JIT_H
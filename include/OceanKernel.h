@@ -0,0 +1,99 @@
+#ifndef OCEAN_KERNEL_H
+#define OCEAN_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Gerstner kernel in intrinsics, specialized at compile time on the wave count.
+//
+// Same sums as updateVertices_simd (xhricma00.s), but everything that does not depend on the vertex is
+// folded into WaveTerms once per call: k * direction, the phase offset at this time and the periodic
+// amplitude, which the assembly recomputes with a LUT gather for every eight vertices. The specializations
+// for 1..OCEAN_KERNEL_MAX_WAVES waves unroll the wave loop and broadcast the terms into registers before
+// the vertex loop; more waves take the generic loop, which reads the terms from memory.
+// Built with -O3 -mavx2 -mfma (Makefile), like the assembly it needs AVX2 for the gathers.
+
+#define OCEAN_KERNEL_MAX_WAVES 16
+
+// Fixed-point phases: a full turn (2pi) is 2^32, so wrap-around is integer overflow and the index into a
+// table of PHASE_LUT_SIZE entries (entry i at i * 2pi / PHASE_LUT_SIZE) is just the top PHASE_LUT_BITS bits
+#define PHASE_LUT_BITS 18
+#define PHASE_LUT_SIZE (1 << PHASE_LUT_BITS)
+#define PHASE_ROUNDING (1u << (31 - PHASE_LUT_BITS)) // Half a table entry, rounds the index to nearest
+
+struct GerstnerWave;
+
+// Per wave, per call. phase(x, z) = kx * x + kz * z + offset
+struct WaveTerms
+{
+    float kx, kz, offset;
+    float amplitude;          // Periodic amplitude at this time
+    float slopeX, slopeZ;     // amplitude * k * direction.x / .y, the tangent y terms
+    float slopeXX, slopeXZ, slopeZZ; // The same times direction again, the tangent x/z terms
+};
+
+struct OceanKernelArgs
+{
+    const float *originalX; // Undisplaced grid, numVertices each
+    const float *originalZ;
+    float *heights;         // numVertices, written
+    float *normals;         // numVertices xyz triples, written
+    size_t numVertices;
+    const float *sinLut;
+    const float *cosLut;
+    int lutSize;
+};
+
+// Per wave, per call, for the fixed-point kernel. phase(row, column) = origin + row * stepX + column * stepZ,
+// all modulo 2^32, so the per-vertex phase is built from integer increments across the lattice
+struct FixedWaveTerms
+{
+    uint32_t stepX, stepZ; // Phase per lattice step along x (rows) and z (columns)
+    uint32_t origin;       // Phase of vertex (0, 0) at this time, plus PHASE_ROUNDING
+    float amplitude, slopeX, slopeZ, slopeXX, slopeXZ, slopeZZ; // As in WaveTerms
+};
+
+// Time-dependent phases of one wave in turns, 2^64 per turn, advanced by the step length instead of being
+// recomputed from the float time, so they keep their precision however long the simulation runs
+struct WavePhase
+{
+    uint64_t travel; // speed * time / wavelength, subtracted from the spatial phase
+    uint64_t swell;  // time / wavelength, drives the periodic amplitude
+};
+
+// Vertex row * columns + column lies at (originX + row * spacing, originZ + column * spacing), Ocean's grid
+struct OceanLattice
+{
+    size_t columns;
+    float originX, originZ, spacing;
+};
+
+// Vertices [begin, end), begin a multiple of 8; the last partial block goes through a padded copy
+typedef void (*OceanKernelFunction)(const OceanKernelArgs &args, const WaveTerms *terms, size_t waveCount, size_t begin, size_t end);
+
+namespace OceanKernels
+{
+    // terms needs waveCount entries
+    void computeWaveTerms(const GerstnerWave *waves, size_t waveCount, float time, const float *sinLut, int lutSize, WaveTerms *terms);
+
+    OceanKernelFunction select(size_t waveCount); // Dispatch table, generic beyond OCEAN_KERNEL_MAX_WAVES
+
+    // Terms plus the selected kernel over all vertices
+    void run(const OceanKernelArgs &args, const GerstnerWave *waves, size_t waveCount, float time);
+
+    uint32_t toPhase(double turns); // Fixed point, 2^32 per turn, any sign and magnitude
+
+    // phases needs waveCount entries; reset derives them from a time, advance adds a step
+    void resetPhases(const GerstnerWave *waves, size_t waveCount, double time, WavePhase *phases);
+    void advancePhases(const GerstnerWave *waves, size_t waveCount, double deltaTime, WavePhase *phases);
+
+    // terms needs waveCount entries; the amplitude is looked up in sinLut (PHASE_LUT_SIZE) with the swell phase
+    void computeFixedWaveTerms(const GerstnerWave *waves, size_t waveCount, const WavePhase *phases, const OceanLattice &lattice,
+                               const float *sinLut, FixedWaveTerms *terms);
+
+    // Fixed-point kernel over vertices [begin, end) of the lattice, begin a multiple of 8. Reads no vertex
+    // positions (args.originalX/Z unused); args.sinLut/cosLut are the PHASE_LUT_SIZE tables.
+    void runFixed(const OceanKernelArgs &args, const OceanLattice &lattice, const FixedWaveTerms *terms, size_t waveCount, size_t begin, size_t end);
+}
+
+#endif // OCEAN_KERNEL_H
@@ -0,0 +1,76 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hardware performance counters of the calling thread through Linux perf_event_open, no perf tool needed.
+//
+// Events are opened in small groups so every group fits the PMU at once; when there are more groups than
+// counters the kernel multiplexes them. read() returns the raw totals with the time each group was enabled and
+// running, and delta() scales the difference of two reads by the enabled / running time between them.
+// User space only (exclude_kernel), which works with the default perf_event_paranoid of 2.
+
+#define PERF_MAX_EVENTS 16
+
+// Running totals of every opened event, with the times of its group (nanoseconds)
+struct PerfSample
+{
+    uint64_t values[PERF_MAX_EVENTS];
+    uint64_t enabled[PERF_MAX_EVENTS];
+    uint64_t running[PERF_MAX_EVENTS];
+};
+
+struct PerfEventSpec
+{
+    std::string name;
+    uint32_t type;   // PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE or PERF_TYPE_RAW
+    uint64_t config;
+    int group;       // Events with the same group are scheduled together
+};
+
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    // Cycles, instructions, branch misses, L1D/LLC misses, plus L2 misses and vector port uops on CPUs
+    // whose raw encodings are known (Intel Haswell to the Skylake derivatives, AMD Zen)
+    static std::vector<PerfEventSpec> defaultEvents();
+
+    // "name=rUUEE,name=rUUEE": raw PMU events (umask/event as perf list shows them), e.g. gather uops
+    static bool parseRawEvents(const std::string &list, std::vector<PerfEventSpec> &events);
+
+    // Opens what the CPU and kernel allow, warns about the rest. False if nothing could be opened.
+    bool open(const std::vector<PerfEventSpec> &events);
+    void close();
+    bool isOpen() const { return !names.empty(); }
+
+    size_t size() const { return names.size(); }
+    const std::string &getName(size_t index) const { return names[index]; }
+    int findEvent(const char *name) const; // -1 when not opened
+
+    // Raw totals since open, size() entries filled
+    bool read(PerfSample &sample) const;
+    // Count of event index between two reads, scaled for the share of that time its group was on the PMU
+    // (0 when it never ran in between)
+    static double delta(const PerfSample &begin, const PerfSample &end, size_t index);
+
+private:
+    struct Group
+    {
+        int leaderFd;
+        std::vector<int> fds;
+        size_t firstValue; // Index of the leader's value in read()
+    };
+
+    std::vector<Group> groups;
+    std::vector<std::string> names;
+};
+
+#endif // PERF_COUNTERS_H
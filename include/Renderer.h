@@ -9,12 +9,31 @@
 #include "Camera.h"
 #include "Shader.h" // Optional Shader class
 #include "Terrain.h" // Include Terrain header
+#include "TextureLoader.h"
+#include "DebugDraw.h"
 
-
+// Debug layers enabled at startup, toggled at runtime with g / n / b
 #define SHOW_GRID 0
 #define SHOW_NORM 0
 #define SHOW_BOUDING_BOX 1
 
+#define FRAME_UNIFORMS_BINDING 0 // Uniform buffer binding point of the Frame block
+
+// std140 layout of the Frame block declared in every shader
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 viewPosWorld; // vec3 in the shader, std140 pads it to 16 bytes
+    glm::vec4 lightDir;
+    glm::vec4 lightColor;
+};
+
+// Per-draw uniforms of one program, resolved once after linking
+struct MeshUniformLocations {
+    GLint model = -1;
+    GLint normalMatrix = -1;
+};
+
 class Renderer {
 public:
     Renderer();
@@ -25,10 +44,12 @@ public:
     GLuint heightMapTextureID; // **Add heightMapTextureID**
     bool init();
     void cleanup();
-    void renderScene(const Ocean &ocean, const Boat &boat, const Camera &camera, const Terrain &Terrain);
+    void renderScene(const Ocean &ocean, const Boat &boat, const Camera &camera, Terrain &Terrain);
     void reshape(int width, int height);
     void drawOcean(const Ocean& ocean, const Camera& camera); // Camera argument added
     GLuint getTerrainTextureID() const { return terrainTextureID; } // Getter for terrain texture ID
+    void setHeightMap(const Image& heightMap); // Upload the terrain's decoded heightmap
+    DebugDraw& getDebugDraw() { return debugDraw; }
 
 private:
 
@@ -36,18 +57,33 @@ private:
     GLuint normalMapTextureID; 
     Shader oceanShader; // Shader program for ocean
     Shader terrainShader; // **Add terrainShader member variable**
+    Shader boatShader; // Shader program for the retained-mode boat mesh
+    Shader debugShader; // Unlit lines of DebugDraw
+    DebugDraw debugDraw;
+    MeshUniformLocations oceanUniforms;
+    MeshUniformLocations terrainUniforms;
+    MeshUniformLocations boatUniforms;
+    GLint boatMaterialLocation = -1;
+    GLuint frameUniformBufferID = 0; // Camera and light, shared by all programs
 
+    TextureLoader textureLoader; // Decodes on worker threads, uploads a slice per frame
     std::string lastBoatTexturePath = "";
+    GLuint pendingBoatTextureID = 0; // Replaces boatTextureID once fully uploaded
+    std::string pendingBoatTexturePath = "";
 
-    bool loadTexture(const char* filename, GLuint& textureID);
+    void updateBoatTexture(const Boat& boat);
     void setupLighting();
-    void drawBoat(const Boat& boat);
-    void drawMesh(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals, const std::vector<glm::vec2>& texCoords,
-                  const std::vector<int>& materialIndices, const std::vector<tinyobj::material_t>& materials); // Modified drawMesh
+    bool setupShaderUniforms(); // Block bindings, cached locations and sampler units
+    void updateFrameUniforms(const Camera& camera);
+    void drawBoat(const Boat& boat, const Camera& camera);
+    void drawMeshBoatVBO(const Boat& boat); // One draw call per material batch
 
     void drawMeshVBO(const Ocean& ocean); // **Declare drawMeshVBO**
-    void drawTerrain(const Terrain& terrain, const Camera& camera);
-    void drawMeshTerainVBO(const Terrain& terrain);
+    void drawTerrain(Terrain& terrain, const Camera& camera);
+    void drawMeshTerainVBO(Terrain& terrain, const Camera& camera); // Quadtree LOD tiles, streamed to the GPU on demand
+    int viewportHeight; // For the terrain screen-space error
+    std::vector<int> terrainTiles;           // Nodes of the tiles selected this frame
+    std::vector<GLint> terrainBaseVertices;  // Their base vertices in the resident tile buffers
 };
 
 #endif // RENDERER_H
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "Input.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// Input and step length of every simulation step, recorded with --record and fed back with --replay, so two
+// runs of the same file simulate exactly the same steps (A/B comparisons of whole frames).
+//
+// File format, little endian: "IPAR"  u32 version  f64 simRate, then one record per step:
+//   u8 flags, then only what changed since the previous step, in flag order:
+//   REPLAY_DT f32 deltaTime | REPLAY_KEYS u8 n, n keys | REPLAY_SPECIAL u8 n, n u16 keys |
+//   REPLAY_BUTTONS u8 mask | REPLAY_MOUSE zigzag varint dx, dy
+// A step with unchanged input at the fixed step length is one byte. There is no step count, a recording
+// cut short by a crash still replays up to its last flushed record.
+
+#define REPLAY_VERSION 1
+#define REPLAY_MAX_KEYS 255    // Held keys per list a record can hold (u8 count), the rest are not recorded
+#define REPLAY_FLUSH_STEPS 256 // Records buffered between flushes, close() writes the rest
+
+#define REPLAY_DT 0x01
+#define REPLAY_KEYS 0x02
+#define REPLAY_SPECIAL 0x04
+#define REPLAY_BUTTONS 0x08
+#define REPLAY_MOUSE 0x10
+
+struct ReplayStep
+{
+    float deltaTime;
+    InputSnapshot input;
+};
+
+class ReplayWriter
+{
+public:
+    ReplayWriter();
+
+    bool open(const std::string& path, double simRate);
+    bool isOpen() const { return file.is_open(); }
+    void write(const ReplayStep& step);
+    bool close(); // False when any write failed
+    long getStepCount() const { return steps; }
+
+private:
+    std::ofstream file;
+    std::string path;
+    ReplayStep previous; // Records hold the difference to it
+    long steps;
+};
+
+class ReplayReader
+{
+public:
+    ReplayReader();
+
+    bool open(const std::string& path);
+    bool isOpen() const { return opened; }
+    bool next(ReplayStep& step); // False at the end of the recording
+    double getSimRate() const { return simRate; }
+    long getStepCount() const { return steps; } // Steps read so far
+
+private:
+    std::string data;
+    size_t position;
+    bool opened;
+    double simRate;
+    ReplayStep previous;
+    long steps;
+};
+
+#endif // REPLAY_H
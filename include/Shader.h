@@ -2,11 +2,13 @@
 #define SHADER_H
 
 #include <string>
+#include <unordered_map>
 #include <GL/glew.h> // Include GLEW for OpenGL types
 #include <glm/glm.hpp> // **ADD THIS LINE - Include GLM header!**
 #include <glm/gtc/type_ptr.hpp>
 
-
+#define SHADER_CACHE_DIR ".cache/shaders/"
+#define SHADER_CACHE_VERSION 1
 
 class Shader {
 public:
@@ -14,12 +16,24 @@ public:
     ~Shader(); // Destructor
 
     bool loadShader(const char* vertexShaderPath, const char* fragmentShaderPath); // Load and compile shaders from files
+
+    // Two-step loading so several programs compile at once: beginLoad takes the program binary from the cache or only
+    // starts compiling and linking (asynchronous with KHR_parallel_shader_compile), finishLoad waits for the driver,
+    // reports errors and stores the binary.
+    bool beginLoad(const char* vertexShaderPath, const char* fragmentShaderPath);
+    bool finishLoad();
+    static void enableParallelCompile(); // Let the driver compile on its own threads, call once after glewInit
     bool isLoaded() const { return programID != 0; } // Check if shader program is loaded
+    GLuint getProgramID() const { return programID; }
 
     void use();       // Use (activate) the shader program
     void unuse();     // Unuse (deactivate) the shader program
     void cleanup();   // Release shader resources
 
+    // Locations of all active uniforms are cached when the program links, -1 if the name is not active
+    GLint getUniformLocation(const std::string& name) const;
+    bool bindUniformBlock(const char* blockName, GLuint binding) const; // Attach a uniform block to a buffer binding point
+
     // Uniform setting functions (add more as needed for different uniform types)
     void setInt(const std::string& name, int value) const;
     void setFloat(const std::string& name, float value) const;
@@ -27,13 +41,31 @@ public:
     void setMat4(const std::string& name, const glm::mat4& mat) const;
     void setMat3(const std::string& name, const glm::mat3& mat) const;
 
+    // Same setters for a location resolved once with getUniformLocation (no lookup per draw)
+    void setInt(GLint location, int value) const;
+    void setFloat(GLint location, float value) const;
+    void setVec3(GLint location, const glm::vec3& value) const;
+    void setMat4(GLint location, const glm::mat4& mat) const;
+    void setMat3(GLint location, const glm::mat3& mat) const;
+
 private:
     GLuint vertexShaderID;   // Vertex shader object ID
     GLuint fragmentShaderID; // Fragment shader object ID
     GLuint programID;        // Shader program ID
+    std::unordered_map<std::string, GLint> uniformLocations; // Filled after linking
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::string binaryCachePath; // Empty when the driver cannot return program binaries
+    bool linkPending;            // Compiled from source, not checked yet
+
+    void cacheUniformLocations();
 
-    bool compileShader(GLuint& shaderID, GLenum shaderType, const char* shaderPath);
-    bool linkShaderProgram();
+    static bool readSource(const char* shaderPath, std::string& source);
+    void compileShader(GLuint& shaderID, GLenum shaderType, const std::string& source); // Only queues the compile
+    bool checkCompile(GLuint shaderID, const std::string& shaderPath) const;
+    void linkShaderProgram();
+    bool loadProgramBinary();
+    void saveProgramBinary() const;
 };
 
 #endif // SHADER_H
\ No newline at end of file
@@ -6,12 +6,36 @@
 #include <vector>
 #include <GL/glew.h> // Include GLEW for OpenGL types like GLuint
 #include "Shader.h"
+#include "TextureLoader.h" // Image
+#include "Frustum.h"
+#include "GridMesh.h"
+
+// Chunked LOD: every quadtree node is a tile of TERRAIN_TILE_QUADS^2 quads sampled with a step of 2^level
+#define TERRAIN_TILE_QUADS 16
+#define TERRAIN_TILE_GRID_VERTICES ((TERRAIN_TILE_QUADS + 1) * (TERRAIN_TILE_QUADS + 1))
+#define TERRAIN_TILE_VERTICES (TERRAIN_TILE_GRID_VERTICES + 4 * (TERRAIN_TILE_QUADS + 1)) // Grid + skirt ring, GridMesh layout
+#define TERRAIN_MAX_PIXEL_ERROR 2.0f // Screen-space error that makes a tile split
+#define TERRAIN_MAX_TILES 256        // Triangle budget, in tiles
+#define TERRAIN_RESIDENT_TILES (2 * TERRAIN_MAX_TILES) // Tile slots kept on the GPU, the least recently drawn ones are reused
+#define TERRAIN_SKIRT_MIN_DEPTH 0.5f
+
+struct TerrainNode {
+    glm::vec3 boundsMin;  // World space, skirts included
+    glm::vec3 boundsMax;
+    float error;          // Largest height difference to the full-resolution grid, children included
+    int slot;             // Slot in the resident tile buffers, -1 when the tile is not uploaded
+    int level;
+    int originX, originZ; // Grid index of the tile corner
+    int children[4];      // -1 at level 0 or outside the grid
+};
+
 class Terrain {
 public:
     Terrain(int gridSize, float gridSpacing);
     ~Terrain();
 
-    bool init(GLuint heightMapTextureID);
+    bool init(const char* heightMapPath);
+    bool generate(const char* heightMapPath); // CPU part of init, needs no GL context
     void cleanup();
 
     glm::vec3 getVertex(int x, int z) const; // Get vertex position at grid index (x, z)
@@ -19,24 +43,56 @@ public:
     int getGridSize() const { return gridSize; }
     float getGridSpacing() const { return gridSpacing; }
     GLuint getVAO() const { return vaoID; }
-    GLuint getIndexCount() const { return indexCount; }
+    const GridIndexBuffer& getTileIndices() const { return *tileIndices; } // Strips of one tile, shared by all tiles
     glm::vec3 getNormal(float x, float z) const;
+    const std::vector<glm::vec3>& getVertices() const { return vertices; } // Full-resolution grid, x * gridSize + z
+    const std::vector<glm::vec3>& getNormals() const { return normals; }
+    const Image& getHeightMap() const { return heightMap; } // Decoded heightmap, the renderer uploads the same pixels
+
+    // Baked with the normals, indexed like the vertices (x * gridSize + z)
+    float getSlope(int x, int z) const { return slopes[x * gridSize + z]; }         // Gradient magnitude (rise over run)
+    float getCurvature(int x, int z) const { return curvatures[x * gridSize + z]; } // Laplacian of the height, > 0 in hollows
+    const std::vector<float>& getSlopeMap() const { return slopes; }
+    const std::vector<float>& getCurvatureMap() const { return curvatures; }
+
+    // Pick the tiles to draw: split while the screen-space error is above TERRAIN_MAX_PIXEL_ERROR and the tile budget allows.
+    // pixelScale = viewport height / (2 * tan(fov / 2)). Writes the node index of every visible tile.
+    void selectTiles(const Frustum& frustum, const glm::vec3& eye, float pixelScale, std::vector<int>& tiles) const;
+    // Upload the selected tiles that are not resident yet into the least recently drawn slots, write their base vertices
+    void streamTiles(const std::vector<int>& tiles, std::vector<GLint>& baseVertices);
+    const std::vector<TerrainNode>& getNodes() const { return nodes; }
 private:
     int gridSize;
     float gridSpacing;
     std::vector<glm::vec3> vertices;
     std::vector<glm::vec3> normals;
     std::vector<glm::vec2> texCoords;
+    std::vector<float> heights;    // Vertex heights, x * gridSize + z
+    std::vector<float> slopes;
+    std::vector<float> curvatures;
     GLuint vertexBufferID;
     GLuint normalBufferID;
     GLuint texCoordBufferID;
-    GLuint indexBufferID;
+    const GridIndexBuffer* tileIndices;
     GLuint vaoID;
-    unsigned int indexCount;
+    Image heightMap;
+
+    std::vector<TerrainNode> nodes; // nodes[0] is the root
+    float skirtDepth;
+    std::vector<int> slotNodes;         // Node in every resident slot, -1 when free
+    std::vector<unsigned> slotFrames;   // Last streamTiles call that drew the slot, 0 when free
+    unsigned streamFrame;
+    std::vector<glm::vec3> tilePositions; // Staging for the tile being uploaded
+    std::vector<glm::vec3> tileNormals;
+    std::vector<glm::vec2> tileTexCoords;
 
 
-    void generateGrid(GLuint heightMapTextureID); // Generate the initial grid of vertices
-    void createBuffers(); // Create and populate VBOs and IBO
+    void generateGrid(); // Generate the initial grid of vertices from heightMap
+    void bakeNormals();  // Normals, slope and curvature from central differences of heights
+    void buildLOD();     // Quadtree, tile errors and bounds
+    int buildNode(int level, int originX, int originZ);
+    void buildTile(const TerrainNode& node); // Tile vertices into the staging vectors
+    void createBuffers(); // Create the resident tile VBOs and the IBO, the tiles are uploaded by streamTiles
     void updateBuffers();   // Update VBO data (not needed for static terrain in this example, but good to have)
 };
 
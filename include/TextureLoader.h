@@ -0,0 +1,102 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#define TEXTURE_DECODE_THREADS 2
+#define TEXTURE_CACHE_DIR ".cache/textures/"
+#define TEXTURE_CACHE_VERSION 1
+#define TEXTURE_UPLOAD_SLICE_BYTES (256 * 1024) // Largest single glTexSubImage2D call
+#define TEXTURE_UPLOAD_BUDGET_MS 2.0            // Upload time per frame
+#define TEXTURE_COMPRESS 1                      // BC1 (DXT1) for opaque colour textures
+
+// Decoded 8-bit RGBA image, row 0 is the bottom row (OpenGL convention)
+struct Image
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0; // Channels in the source file, pixels are always RGBA
+    std::vector<unsigned char> pixels;
+};
+
+// Decode PNG/JPG with SOIL on the calling thread
+bool decodeImage(const char *filename, Image &image);
+
+enum class TextureState
+{
+    Pending,   // Decoding on a worker thread
+    Uploading, // Decoded, levels are uploaded in slices
+    Ready,     // All mip levels are on the GPU
+    Failed
+};
+
+// Loads textures off the GL thread.
+// Worker threads decode the image (or read the mip chain from the cache), the GL thread uploads it
+// from smallest to largest level within a per-frame time budget.
+class TextureLoader
+{
+public:
+    TextureLoader();
+    ~TextureLoader();
+
+    // Must be called on the GL thread. The returned name is valid at once, it has no image until the upload starts.
+    GLuint request(const std::string &filename, bool compress);
+
+    // Same for an image that is already decoded (no cache, never compressed), the pixels are copied
+    GLuint request(const Image &image, const std::string &name);
+
+    // Upload decoded data for at most budgetMs, call once per frame on the GL thread
+    void pumpUploads(double budgetMs = TEXTURE_UPLOAD_BUDGET_MS);
+
+    // Block until the texture is fully uploaded, returns false if it failed to load
+    bool waitFor(GLuint textureID);
+
+    TextureState getState(GLuint textureID) const;
+    void release(GLuint textureID); // Delete the GL texture, an unfinished decode is dropped
+    void cleanup();
+
+private:
+    struct MipLevel
+    {
+        int width;
+        int height;
+        std::vector<unsigned char> data; // RGBA8 or BC1 blocks
+    };
+
+    struct TextureEntry
+    {
+        GLuint id;
+        std::string filename;
+        bool compress;
+        TextureState state = TextureState::Pending;
+        bool released = false;
+        Image source; // Already decoded image, empty when loading from filename
+        std::vector<MipLevel> levels;
+        int uploadLevel = -1; // Level being uploaded, counts down to 0
+        int uploadRow = 0;    // Next pixel row (block row for BC1) of that level
+    };
+
+    std::vector<std::thread> decoders;
+    mutable std::mutex mutex;
+    std::condition_variable workCondition;
+    std::condition_variable decodedCondition;
+    std::deque<std::shared_ptr<TextureEntry>> decodeQueue;
+    std::deque<std::shared_ptr<TextureEntry>> uploadQueue; // Decoded, in upload order
+    std::map<GLuint, std::shared_ptr<TextureEntry>> entries;
+    bool stopping;
+
+    GLuint queueEntry(const std::shared_ptr<TextureEntry> &entry);
+    void decoderLoop();
+    static bool loadLevels(TextureEntry &entry);
+    bool uploadSlice(TextureEntry &entry); // Returns true once the last level is done
+};
+
+#endif // TEXTURE_LOADER_H
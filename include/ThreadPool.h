@@ -0,0 +1,51 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+
+// Persistent pool of worker threads for data-parallel loops.
+// The calling thread takes part in the work; parallelFor blocks until all tasks are done.
+// There is one job slot, so only the thread that created the pool hands out jobs: parallelFor called from
+// any other thread (a worker, a texture decoder) runs its tasks serially on that thread.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned threadCount = 0); // 0 = one thread per hardware thread
+    ~ThreadPool();
+
+    static ThreadPool &instance(); // Shared pool sized to the machine
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Run fn(task) for every task in [0, taskCount). Called from a worker or another thread it runs serially.
+    void parallelFor(size_t taskCount, const std::function<void(size_t)> &fn);
+
+    // Same, but only uses the first maxThreads threads (including the caller)
+    void parallelFor(size_t taskCount, unsigned maxThreads, const std::function<void(size_t)> &fn);
+
+private:
+    std::vector<std::thread> workers;
+    std::thread::id owner;                   // The only thread that may start a parallel job
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    const std::function<void(size_t)> *job; // Current job, valid while a parallelFor is running
+    size_t jobTaskCount;
+    unsigned jobThreads;                     // Workers allowed to join the current job
+    std::atomic<size_t> nextTask;
+    unsigned busyWorkers;
+    unsigned long generation;                // Incremented for every job so workers do not run one twice
+    bool stopping;
+
+    void workerLoop(unsigned workerIndex);
+    void runTasks();
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,92 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <x86intrin.h>
+
+// Calibrated TSC timing and latency histograms per named zone.
+//
+// Timing::calibrate measures the TSC rate against steady_clock once at startup and checks CPUID for an
+// invariant TSC (constant rate across P-states, ticking in sleep states), without which cycle counts are
+// not time. LATENCY_SCOPE zones are always on: two rdtsc and a few relaxed atomic adds per pass, safe
+// from any thread. Percentiles come from log-linear buckets (HDR style) with about 3 % value error;
+// max is exact. A table is printed at exit and, with Timing::setReportInterval, every N seconds.
+// Render zones measure CPU submission only, the GPU shows up in "Swap buffers".
+
+#define LATENCY_SUB_BUCKET_BITS 6                                // Exact below 64 ns, then 32 steps per power of two
+#define LATENCY_SUB_BUCKETS (1u << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAX_BITS 40                                      // Values are clamped to 2^40 ns (18 min)
+#define LATENCY_BUCKETS (LATENCY_SUB_BUCKETS + (LATENCY_MAX_BITS - LATENCY_SUB_BUCKET_BITS) * (LATENCY_SUB_BUCKETS / 2))
+
+struct LatencySummary
+{
+    uint64_t count;
+    uint64_t p50, p99, p999, max; // Nanoseconds, percentiles are bucket upper bounds
+};
+
+class LatencyHistogram
+{
+public:
+    explicit LatencyHistogram(const char *name);
+
+    void record(uint64_t nanoseconds);
+    const char *getName() const { return name; }
+
+    // Counts since the last takeInterval (or since start), max included; used by the periodic report
+    LatencySummary takeInterval();
+    LatencySummary summarizeTotal() const;
+
+    static unsigned bucketIndex(uint64_t nanoseconds);
+    static uint64_t bucketUpperBound(unsigned index);
+
+private:
+    const char *name;
+    std::atomic<uint64_t> buckets[LATENCY_BUCKETS];
+    std::atomic<uint64_t> max;
+    std::atomic<uint64_t> intervalMax;
+    uint64_t reported[LATENCY_BUCKETS]; // Bucket counts at the last takeInterval, reporter thread only
+
+    static void updateMax(std::atomic<uint64_t> &target, uint64_t value);
+    static LatencySummary summarize(const uint64_t *counts, uint64_t max);
+};
+
+namespace Timing
+{
+    extern double nanosecondsPerTick;
+
+    void calibrate(); // Once, before any zone runs; also schedules the report at exit
+    bool hasInvariantTsc();
+    std::string cpuBrand(); // CPUID brand string, keys measurements stored on disk
+    inline double ticksToNanoseconds(uint64_t ticks) { return ticks * nanosecondsPerTick; }
+
+    LatencyHistogram &histogram(const char *name); // Created on first use, lives until exit
+
+    void setReportInterval(double seconds); // 0 = report only at exit
+    void pollReport();                      // Print the interval table when it is due, call once per frame
+    void report(bool interval);             // interval: since the previous interval report, otherwise the whole run
+}
+
+class LatencyScope
+{
+public:
+    explicit LatencyScope(LatencyHistogram &histogram) : histogram(histogram), beginTicks(__rdtsc()) {}
+    ~LatencyScope() { histogram.record(static_cast<uint64_t>(Timing::ticksToNanoseconds(__rdtsc() - beginTicks))); }
+
+    LatencyScope(const LatencyScope &) = delete;
+    LatencyScope &operator=(const LatencyScope &) = delete;
+
+private:
+    LatencyHistogram &histogram;
+    uint64_t beginTicks;
+};
+
+#define LATENCY_CONCAT_INNER(a, b) a##b
+#define LATENCY_CONCAT(a, b) LATENCY_CONCAT_INNER(a, b)
+// The histogram lookup runs once per call site (function-local static)
+#define LATENCY_SCOPE(name)                                                                          \
+    static LatencyHistogram &LATENCY_CONCAT(latencyHistogram, __LINE__) = Timing::histogram(name); \
+    LatencyScope LATENCY_CONCAT(latencyScope, __LINE__)(LATENCY_CONCAT(latencyHistogram, __LINE__))
+
+#endif // TIMING_H
@@ -0,0 +1,88 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "PerfCounters.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <x86intrin.h>
+
+// Scoped timing zones for the hot path. Every thread writes TSC begin/end pairs into its own ring buffer,
+// with no lock and no I/O while recording. The rings are written out at exit, or on SIGUSR1, as
+//   <base>.json  Chrome trace events (chrome://tracing, Perfetto)
+//   <base>.txt   "ns cycles" lines of the reference and assembly (SIMD) ocean kernels, alternating, as read by
+//                docs/script/main.py and perf_gate --import
+//   <base>.<kernel>.txt  the same pairs for the other surface kernels, only for those that ran
+// Recording is off until Trace::enable; a disabled TRACE_SCOPE costs one relaxed load and a branch.
+// With Trace::enableCounters every zone also reads the hardware counters of its thread (two read() calls per
+// group, microseconds) and the per-zone totals are printed at exit next to the wall time.
+
+#define TRACE_RING_CAPACITY 16384 // Events kept per thread, the oldest are overwritten
+
+// Zones paired into the two-column files, one per surface kernel so different code never shares a name
+#define TRACE_ZONE_OCEAN_REFERENCE "Ocean::update reference"
+#define TRACE_ZONE_OCEAN_SIMD "Ocean::update SIMD" // The assembly kernel only
+#define TRACE_ZONE_OCEAN_SPECIALIZED "Ocean::update specialized"
+#define TRACE_ZONE_OCEAN_JIT "Ocean::update jit"
+#define TRACE_ZONE_OCEAN_FIXED_POINT "Ocean::update fixed"
+
+namespace Trace
+{
+    extern std::atomic<bool> enabled;
+    extern std::atomic<bool> countersEnabled;
+
+    void enable(const std::string &basePath); // Start recording, dump to basePath.{json,txt} at exit and on SIGUSR1
+    inline bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // name must outlive the trace (a string literal)
+    void record(const char *name, uint64_t beginTicks, uint64_t endTicks);
+
+    void enableCounters(const std::vector<PerfEventSpec> &events); // After enable; each thread opens its own on first use
+    inline bool areCountersEnabled() { return countersEnabled.load(std::memory_order_relaxed); }
+    bool readCounters(PerfSample &sample); // This thread's counters, false when they could not be opened
+    void recordCounters(const char *name, uint64_t ticks, const PerfSample &begin);
+
+    bool dump();            // Write both files now, recording continues
+    void pollDumpRequest(); // Dump if SIGUSR1 arrived since the last call, the handler itself only sets a flag
+}
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name) : name(Trace::isEnabled() ? name : nullptr), counting(false), beginTicks(0)
+    {
+        if (this->name != nullptr)
+        {
+            counting = Trace::areCountersEnabled() && Trace::readCounters(beginCounters);
+            beginTicks = __rdtsc();
+        }
+    }
+    ~TraceScope()
+    {
+        if (name != nullptr)
+        {
+            uint64_t endTicks = __rdtsc();
+            Trace::record(name, beginTicks, endTicks);
+            if (counting)
+            {
+                Trace::recordCounters(name, endTicks - beginTicks, beginCounters);
+            }
+        }
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name; // nullptr while recording is off
+    bool counting;
+    uint64_t beginTicks;
+    PerfSample beginCounters; // Only filled when counting
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif // TRACE_H
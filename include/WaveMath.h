@@ -0,0 +1,93 @@
+#ifndef WAVE_MATH_H
+#define WAVE_MATH_H
+
+#include <immintrin.h>
+#include <cstddef>
+
+// The building blocks of the AVX2 ocean kernel (src/xhricma00.s) as inline intrinsics, eight lanes at a time,
+// so they can be measured one by one (bench/). Each function names the assembly it mirrors.
+// Needs -mavx2 -mfma.
+
+namespace WaveMath
+{
+    // lut_idx macro: reduce to [0, 2pi) with x - 2pi * floor(x / 2pi), then round(x * (N - 1) / 2pi).
+    // Clamped to [0, N - 1]: next to a multiple of 2pi the reduction can land just outside the range (more
+    // so once the compiler contracts it into an FMA), and the gather would read past the table.
+    inline __m256i lutIndex(__m256 angle, int lutSize)
+    {
+        const __m256 twoPi = _mm256_set1_ps(6.283185307f);
+        __m256 turns = _mm256_floor_ps(_mm256_div_ps(angle, twoPi));
+        __m256 reduced = _mm256_sub_ps(angle, _mm256_mul_ps(turns, twoPi));
+        __m256 scaled = _mm256_div_ps(_mm256_mul_ps(reduced, _mm256_set1_ps(static_cast<float>(lutSize - 1))), twoPi);
+        __m256i index = _mm256_cvtps_epi32(_mm256_round_ps(scaled, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+        return _mm256_max_epi32(_mm256_min_epi32(index, _mm256_set1_epi32(lutSize - 1)), _mm256_setzero_si256());
+    }
+
+    // sin/cos macros: lut_idx followed by a full-mask vgatherdps
+    inline void sincosLut(__m256 angle, const float *sinLut, const float *cosLut, int lutSize, __m256 &sinOut, __m256 &cosOut)
+    {
+        __m256i index = lutIndex(angle, lutSize);
+        sinOut = _mm256_i32gather_ps(sinLut, index, 4);
+        cosOut = _mm256_i32gather_ps(cosLut, index, 4);
+    }
+
+    // Gather-free alternative: quadrant reduction (Cody-Waite, three parts of pi/2) and Cephes minimax
+    // polynomials on [-pi/4, pi/4]. About 1e-7 absolute error for |angle| < 8192, the LUT is about 3e-5.
+    inline void sincosPolynomial(__m256 angle, __m256 &sinOut, __m256 &cosOut)
+    {
+        __m256 quadrant = _mm256_round_ps(_mm256_mul_ps(angle, _mm256_set1_ps(0.636619772f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(quadrant, _mm256_set1_ps(1.5703125f), angle);
+        r = _mm256_fnmadd_ps(quadrant, _mm256_set1_ps(4.837512969970703125e-4f), r);
+        r = _mm256_fnmadd_ps(quadrant, _mm256_set1_ps(7.549789948768648e-8f), r);
+        __m256 r2 = _mm256_mul_ps(r, r);
+
+        __m256 s = _mm256_fmadd_ps(r2, _mm256_set1_ps(-1.9515295891e-4f), _mm256_set1_ps(8.3321608736e-3f));
+        s = _mm256_fmadd_ps(r2, s, _mm256_set1_ps(-1.6666654611e-1f));
+        s = _mm256_fmadd_ps(_mm256_mul_ps(r2, r), s, r);
+
+        __m256 c = _mm256_fmadd_ps(r2, _mm256_set1_ps(2.443315711809948e-5f), _mm256_set1_ps(-1.388731625493765e-3f));
+        c = _mm256_fmadd_ps(r2, c, _mm256_set1_ps(4.166664568298827e-2f));
+        c = _mm256_fmadd_ps(_mm256_mul_ps(r2, r2), c, _mm256_fnmadd_ps(r2, _mm256_set1_ps(0.5f), _mm256_set1_ps(1.0f)));
+
+        // Quadrant q: odd swaps sin and cos, sin is negated for q & 2, cos for (q + 1) & 2
+        __m256i q = _mm256_cvtps_epi32(quadrant);
+        __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+        __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+        __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+        sinOut = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sinSign);
+        cosOut = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosSign);
+    }
+
+    // Normal tail of z_loop: eight SoA normals stored as xyz triples one lane at a time (vextractf128 + pextrd)
+    inline void storeNormalsExtract(float *dst, __m256 x, __m256 y, __m256 z)
+    {
+        alignas(32) float lanes[3][8];
+        _mm256_store_ps(lanes[0], x);
+        _mm256_store_ps(lanes[1], y);
+        _mm256_store_ps(lanes[2], z);
+        for (int i = 0; i < 8; ++i)
+        {
+            dst[i * 3 + 0] = lanes[0][i];
+            dst[i * 3 + 1] = lanes[1][i];
+            dst[i * 3 + 2] = lanes[2][i];
+        }
+    }
+
+    // Same result with an in-register 3x8 transpose and three full-width stores
+    inline void storeNormalsShuffle(float *dst, __m256 x, __m256 y, __m256 z)
+    {
+        // Per 128-bit half: x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+        __m256 xy = _mm256_unpacklo_ps(x, y);                                   // x0 y0 x1 y1 | x4 y4 x5 y5
+        __m256 xyHigh = _mm256_unpackhi_ps(x, y);                               // x2 y2 x3 y3 | x6 y6 x7 y7
+        __m256 zx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));          // z0 z2 x1 x3 | z4 z6 x5 x7
+        __m256 yz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));          // y1 y3 z1 z3 | y5 y7 z5 z7
+        __m256 a = _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 1, 0));         // x0 y0 z0 x1 | x4 y4 z4 x5
+        __m256 b = _mm256_shuffle_ps(yz, xyHigh, _MM_SHUFFLE(1, 0, 2, 0));     // y1 z1 x2 y2 | y5 z5 x6 y6
+        __m256 c = _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));         // z2 x3 y3 z3 | z6 x7 y7 z7
+        _mm256_storeu_ps(dst + 0, _mm256_permute2f128_ps(a, b, 0x20));
+        _mm256_storeu_ps(dst + 8, _mm256_permute2f128_ps(c, a, 0x30));
+        _mm256_storeu_ps(dst + 16, _mm256_permute2f128_ps(b, c, 0x31));
+    }
+}
+
+#endif // WAVE_MATH_H
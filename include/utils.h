@@ -6,6 +6,7 @@
 #include <glm/glm.hpp>
 #include <x86intrin.h>
 #include <vector>
+#include <string>
 
 // Helper function to check for OpenGL errors and print a message
 void checkGLError(const char* operation);
@@ -13,4 +14,5 @@ float perlinNoise(float x, float y); // Placeholder declaration
 void convert_vec3_to_float_array(const std::vector<glm::vec3>& src, float * dst);
 void convert_float_array_to_vec3(float * src, std::vector<glm::vec3>& dst);
 uint64_t rdtsc();
+bool makeParentDirectories(const std::string& path); // mkdir -p of everything before the last '/', existing ones are fine
 #endif // UTILS_H
\ No newline at end of file
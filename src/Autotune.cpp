@@ -0,0 +1,241 @@
+/*
+ * File:        Autotune.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Startup autotuner of the ocean surface kernel, thread count and tile size, cached per host
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "Autotune.h"
+#include "ThreadPool.h"
+#include "Timing.h"
+#include "utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <x86intrin.h>
+
+namespace
+{
+    // The assembly is left out, it cannot run on tiles
+    const OceanKernel TUNED_KERNELS[] = {OCEAN_KERNEL_SPECIALIZED, OCEAN_KERNEL_JIT, OCEAN_KERNEL_FIXED_POINT};
+    const size_t TILE_SIZES[] = {1024, 4096}; // Besides one tile per thread, smaller tiles balance better
+
+    // FNV-1a over the wave parameters
+    uint64_t hashWaves(const std::vector<GerstnerWave> &waves)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (const GerstnerWave &wave : waves)
+        {
+            const float values[] = {wave.amplitude, wave.wavelength, wave.speed, wave.direction.x, wave.direction.y, wave.phase};
+            const unsigned char *bytes = reinterpret_cast<const unsigned char *>(values);
+            for (size_t i = 0; i < sizeof(values); ++i)
+            {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+        }
+        return hash;
+    }
+
+    std::string describe(const OceanTuning &tuning)
+    {
+        std::ostringstream text;
+        text << Ocean::kernelName(tuning.kernel) << ", " << tuning.threads << (tuning.threads == 1 ? " thread" : " threads");
+        if (tuning.threads > 1)
+        {
+            text << ", " << tuning.tileVertices << " vertices per tile";
+        }
+        return text.str();
+    }
+}
+
+std::string Autotune::key(const Ocean &ocean)
+{
+    std::string brand = Timing::cpuBrand();
+    std::replace(brand.begin(), brand.end(), '\t', ' ');
+    char waves[32];
+    std::snprintf(waves, sizeof(waves), "%016llx", static_cast<unsigned long long>(hashWaves(ocean.getWaves())));
+
+    std::ostringstream text;
+    text << 'v' << AUTOTUNE_VERSION << '|' << brand << '|' << ThreadPool::instance().getThreadCount() << " threads|grid "
+         << ocean.getGridSize() << '|' << ocean.getWaves().size() << " waves " << waves;
+    return text.str();
+}
+
+std::vector<OceanTuning> Autotune::candidates(const Ocean &ocean)
+{
+    unsigned maxThreads = ThreadPool::instance().getThreadCount();
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < maxThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::vector<OceanTuning> result;
+    size_t vertexCount = ocean.getVertexCount();
+    for (OceanKernel kernel : TUNED_KERNELS)
+    {
+        for (unsigned threads : threadCounts)
+        {
+            if (threads == 1)
+            {
+                result.push_back({kernel, 1, 0, 0.0});
+                continue;
+            }
+            size_t perThread = (vertexCount + threads - 1) / threads;
+            result.push_back({kernel, threads, (perThread + 7) / 8 * 8, 0.0});
+            for (size_t tile : TILE_SIZES)
+            {
+                if (tile < perThread)
+                {
+                    result.push_back({kernel, threads, tile, 0.0});
+                }
+            }
+        }
+    }
+    return result;
+}
+
+double Autotune::measure(Ocean &ocean, const OceanTuning &candidate)
+{
+    ocean.setSurfaceThreading(candidate.threads, candidate.tileVertices);
+    for (int run = 0; run < AUTOTUNE_WARMUP_RUNS; ++run) // Code generation, page faults, waking the workers
+    {
+        ocean.runKernel(candidate.kernel);
+    }
+
+    std::vector<double> samples;
+    double total = 0.0;
+    while (samples.size() < AUTOTUNE_MAX_SAMPLES && (samples.size() < AUTOTUNE_MIN_SAMPLES || total < AUTOTUNE_CANDIDATE_NS))
+    {
+        _mm_lfence();
+        uint64_t begin = __rdtsc();
+        ocean.runKernel(candidate.kernel);
+        _mm_lfence();
+        uint64_t end = __rdtsc();
+        samples.push_back(Timing::ticksToNanoseconds(end - begin));
+        total += samples.back();
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+OceanTuning Autotune::tune(Ocean &ocean, bool verbose)
+{
+    if (Timing::nanosecondsPerTick == 0.0)
+    {
+        Timing::calibrate();
+    }
+
+    std::vector<OceanTuning> all = candidates(ocean);
+    OceanTuning best = all.front();
+    for (OceanTuning &candidate : all)
+    {
+        candidate.nanoseconds = measure(ocean, candidate);
+        if (verbose)
+        {
+            std::cerr << "Autotune: " << describe(candidate) << ": " << candidate.nanoseconds / 1000.0 << " us" << std::endl;
+        }
+        if (best.nanoseconds == 0.0 || candidate.nanoseconds < best.nanoseconds)
+        {
+            best = candidate;
+        }
+    }
+    ocean.setSurfaceKernel(best.kernel);
+    ocean.setSurfaceThreading(best.threads, best.tileVertices);
+    return best;
+}
+
+bool Autotune::load(const std::string &path, const std::string &key, OceanTuning &tuning)
+{
+    std::ifstream file(path);
+    bool found = false;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos || line.compare(0, tab, key) != 0)
+        {
+            continue;
+        }
+        std::istringstream fields(line.substr(tab + 1));
+        std::string name;
+        OceanTuning entry;
+        if (fields >> name >> entry.threads >> entry.tileVertices >> entry.nanoseconds && Ocean::parseKernel(name, entry.kernel) &&
+            entry.kernel != OCEAN_KERNEL_REFERENCE && entry.threads > 0)
+        {
+            tuning = entry; // The last line of a key wins
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool Autotune::save(const std::string &path, const std::string &key, const OceanTuning &tuning)
+{
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.compare(0, key.size() + 1, key + '\t') != 0)
+            {
+                lines.push_back(line);
+            }
+        }
+    }
+    std::ostringstream entry;
+    entry << key << '\t' << Ocean::kernelName(tuning.kernel) << ' ' << tuning.threads << ' ' << tuning.tileVertices << ' ' << tuning.nanoseconds;
+    lines.push_back(entry.str());
+
+    if (!makeParentDirectories(path))
+    {
+        std::cerr << "Autotune: cannot create the directory of " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    std::string temporary = path + ".tmp"; // Renamed over the cache, a crash never leaves half a file
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        for (const std::string &line : lines)
+        {
+            file << line << '\n';
+        }
+        if (!file)
+        {
+            std::cerr << "Autotune: cannot write " << temporary << std::endl;
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Autotune: cannot replace " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+OceanTuning Autotune::apply(Ocean &ocean, const std::string &path, bool retune)
+{
+    std::string cacheKey = key(ocean);
+    OceanTuning tuning;
+    if (!retune && load(path, cacheKey, tuning))
+    {
+        ocean.setSurfaceKernel(tuning.kernel);
+        ocean.setSurfaceThreading(tuning.threads, tuning.tileVertices);
+        std::cerr << "Autotune: " << describe(tuning) << " (cached in " << path << ")" << std::endl;
+        return tuning;
+    }
+
+    tuning = tune(ocean, true);
+    std::cerr << "Autotune: picked " << describe(tuning) << ", " << tuning.nanoseconds / 1000.0 << " us per update" << std::endl;
+    save(path, cacheKey, tuning); // Still applied when the cache cannot be written
+    return tuning;
+}
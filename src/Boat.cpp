@@ -12,15 +12,31 @@
 
 
 #include "Boat.h"
+#include "GLDebug.h"
+#include "MeshOptimizer.h"
+#include "ObjLoader.h" // Must come before the tinyobj implementation below
+#include "Trace.h"
 #include <iostream>
+#include <cmath>
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h> // Include tinyobjloader
 #include <glm/gtc/type_ptr.hpp> // For value_ptr (if needed for debugging)
 
-Boat::Boat() : position(0.0f, 0.5f, 0.0f), rotation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f)), speed(0.0f), steeringSpeed(1.0f), materials(), boatScale(1.0f) {} // Initialize boatScale to 1.0f
+Boat::Boat() : position(0.0f, 0.5f, 0.0f), rotation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f)), previousPosition(position), previousRotation(rotation),
+               renderPosition(position), renderRotation(rotation), speed(0.0f), steeringSpeed(1.0f), materials(),
+               vertexBufferID(0), normalBufferID(0), texCoordBufferID(0), indexBufferID(0), materialBufferID(0), vaoID(0),
+               boatScale(1.0f) {} // Initialize boatScale to 1.0f
 Boat::~Boat() {}
 
 bool Boat::init(const char* modelPath, const char* texturePath) {
+    if (!load(modelPath, texturePath)) {
+        return false;
+    }
+    createBuffers();
+    return true;
+}
+
+bool Boat::load(const char* modelPath, const char* texturePath) {
     materials.clear(); // Explicitly clear materials before loading model
     if (!loadModel(modelPath)) {
         std::cerr << "Error loading boat model: " << modelPath << std::endl;
@@ -31,12 +47,81 @@ bool Boat::init(const char* modelPath, const char* texturePath) {
 }
 
 void Boat::cleanup() {
-    // No dynamic memory cleanup in this simple example, but if you used dynamic allocation in loadModel, clean it up here.
+    if (vaoID == 0) {
+        return;
+    }
+    glDeleteBuffers(1, &vertexBufferID);
+    glDeleteBuffers(1, &normalBufferID);
+    glDeleteBuffers(1, &texCoordBufferID);
+    glDeleteBuffers(1, &indexBufferID);
+    glDeleteBuffers(1, &materialBufferID);
+    glDeleteVertexArrays(1, &vaoID);
+    vertexBufferID = normalBufferID = texCoordBufferID = indexBufferID = materialBufferID = vaoID = 0;
+}
+
+void Boat::createBuffers() {
+    GL_DEBUG_SCOPE("Boat::createBuffers");
+    glGenVertexArrays(1, &vaoID);
+    glBindVertexArray(vaoID);
+
+    glGenBuffers(1, &vertexBufferID);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(0);
+
+    glGenBuffers(1, &normalBufferID);
+    glBindBuffer(GL_ARRAY_BUFFER, normalBufferID);
+    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(1);
+
+    glGenBuffers(1, &texCoordBufferID);
+    glBindBuffer(GL_ARRAY_BUFFER, texCoordBufferID);
+    glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(2);
+
+    glGenBuffers(1, &indexBufferID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
+    if (usesShortIndices()) {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices16.size() * sizeof(unsigned short), indices16.data(), GL_STATIC_DRAW);
+    } else {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    // Material diffuse colors, std140 vec4 array - the last slot is white for faces without a material
+    std::vector<glm::vec4> diffuseColors(BOAT_MAX_MATERIALS, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+    for (size_t i = 0; i < materials.size() && i < BOAT_MAX_MATERIALS - 1; ++i) {
+        diffuseColors[i] = glm::vec4(materials[i].diffuse[0], materials[i].diffuse[1], materials[i].diffuse[2], 1.0f);
+    }
+    glGenBuffers(1, &materialBufferID);
+    glBindBuffer(GL_UNIFORM_BUFFER, materialBufferID);
+    glBufferData(GL_UNIFORM_BUFFER, diffuseColors.size() * sizeof(glm::vec4), diffuseColors.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // Batches refer to uniform buffer slots from now on
+    for (MeshBatch& batch : batches) {
+        if (batch.material < 0 || batch.material >= BOAT_MAX_MATERIALS - 1 || static_cast<size_t>(batch.material) >= materials.size()) {
+            batch.material = BOAT_MAX_MATERIALS - 1;
+        }
+    }
 }
 
 void Boat::update(const Input& input, const Ocean& ocean, float deltaTime) {
+    previousPosition = position;
+    previousRotation = rotation;
     handleInput(input, deltaTime);
-    applyWaveMotion(ocean);
+    applyWaveMotion(ocean, deltaTime);
+}
+
+void Boat::interpolate(float alpha) {
+    renderPosition = glm::mix(previousPosition, position, alpha);
+    renderRotation = glm::slerp(previousRotation, rotation, alpha);
 }
 
 void Boat::handleInput(const Input& input, float deltaTime) {
@@ -64,12 +149,12 @@ void Boat::handleInput(const Input& input, float deltaTime) {
     position += forwardVector * speed * deltaTime;
 }
 
-void Boat::applyWaveMotion(const Ocean& ocean) {
-    // Sample wave height at boat's position
-    position.y = ocean.getWaveHeight(position.x, position.z, ocean.time);
+void Boat::applyWaveMotion(const Ocean& ocean, float deltaTime) {
+    // Sample wave height at boat's position, at the time of the drawn surface
+    position.y = ocean.getSurfaceHeight(position.x, position.z);
 
     // Get wave normal
-    glm::vec3 waveNormal = ocean.getWaveNormal(position.x, position.z, ocean.time);
+    glm::vec3 waveNormal = ocean.getSurfaceNormal(position.x, position.z);
     //std::cout << "Wave Normal: (" << waveNormal.x << ", " << waveNormal.y << ", " << waveNormal.z << ")" << std::endl;
 
     // Get current boat forward direction
@@ -92,7 +177,9 @@ void Boat::applyWaveMotion(const Ocean& ocean) {
     glm::mat3 targetRotationMatrix(targetRight, targetUp, -targetForward); // Boat forward is -Z
     glm::quat targetRotation = glm::quat_cast(targetRotationMatrix);
 
-    rotation = glm::slerp(rotation, targetRotation, 0.1f);
+    // 10 % per 1/60 s step, scaled so the settling speed does not depend on the simulation rate
+    float blend = 1.0f - std::pow(0.9f, deltaTime * 60.0f);
+    rotation = glm::slerp(rotation, targetRotation, blend);
 }
 
 
@@ -110,7 +197,11 @@ bool Boat::loadModel(const char* path) {
         inputfile_dir = path_str.substr(0, last_slash_pos + 1); // Include the last slash
     }
 
-    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path, inputfile_dir.c_str()); // Pass mtl_basepath
+    bool ret;
+    {
+        TRACE_SCOPE("Boat::loadModel OBJ parse"); // Parse time shows up in the --trace output
+        ret = loadObjParallel(&attrib, &shapes, &materials, &warn, &err, path, inputfile_dir.c_str()); // Pass mtl_basepath
+    }
 
     if (!warn.empty()) {
         std::cout << "tinyobjloader warning: " << warn << std::endl;
@@ -128,6 +219,9 @@ bool Boat::loadModel(const char* path) {
     normals.clear();
     texCoords.clear();
     materialIndices.clear(); // Clear material indices
+    indices.clear();
+    indices16.clear();
+    batches.clear();
     // Loop through each shape in the OBJ file
     for (const auto& shape : shapes) {
         // Loop over faces(polygon)
@@ -164,6 +258,25 @@ bool Boat::loadModel(const char* path) {
         }
     }
 
+    // Weld duplicated face vertices into an indexed mesh and reorder it for the post-transform cache
+    MeshStats stats;
+    stats.sourceVertices = vertices.size();
+    stats.triangles = vertices.size() / 3;
+    stats.bytesBefore = vertices.size() * (sizeof(glm::vec3) * 2 + sizeof(glm::vec2) + sizeof(int));
+    stats.acmrBefore = 3.0f; // Every triangle transforms its own three vertices
+
+    weldVertices(vertices, normals, texCoords, materialIndices, indices);
+    optimizeVertexCache(indices, vertices.size());
+    buildMaterialBatches(indices, materialIndices, batches);
+    optimizeVertexFetch(vertices, normals, texCoords, materialIndices, indices);
+    stats.shortIndices = packIndices16(indices, vertices.size(), indices16);
+
+    stats.uniqueVertices = vertices.size();
+    stats.bytesAfter = vertices.size() * (sizeof(glm::vec3) * 2 + sizeof(glm::vec2) + sizeof(int)) +
+                       indices.size() * (stats.shortIndices ? sizeof(unsigned short) : sizeof(unsigned int));
+    stats.acmrAfter = computeACMR(indices, vertices.size());
+    printMeshStats("Boat", stats);
+
     if (ret) {
 
         glm::quat modelRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f); // Identity quaternion (no rotation initially)
@@ -14,7 +14,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 Camera::Camera() : position(10.0f, 10.0f, 10.0f), target(0.0f, 0.0f, 0.0f), up(0.0f, 1.0f, 0.0f),
-                   aspectRatio(1.0f), fov(45.0f), nearPlane(0.1f), farPlane(100.0f) {}
+                   previousPosition(position), previousTarget(target), eyePosition(position),
+                   aspectRatio(1.0f), fov(45.0f), nearPlane(0.1f), farPlane(100.0f) {
+    projectionMatrix = glm::perspective(glm::radians(fov), aspectRatio, nearPlane, farPlane);
+    interpolate(1.0f);
+}
 
 Camera::~Camera() {}
 
@@ -23,6 +27,8 @@ void Camera::init() {
 }
 
 void Camera::update(const Input& input, const glm::vec3& boatPosition) {
+    previousPosition = position;
+    previousTarget = target;
     target = boatPosition;
 
     glm::vec3 lookDirection;
@@ -41,24 +47,24 @@ void Camera::update(const Input& input, const glm::vec3& boatPosition) {
 
     glm::vec3 forward = glm::normalize(target - position);
     glm::vec3 right = glm::normalize(glm::cross(forward, up));
-    // Recalculate up to ensure orthogonality (important for gluLookAt)
+    // Recalculate up to ensure orthogonality
     up = glm::normalize(glm::cross(right, forward));
+    interpolate(1.0f); // Newest state until the renderer asks for an in-between one
 
     handleMouseInput(input, 1.0f/60.0f); // Example deltaTime (fixed 60fps for now) 
 }
 
-void Camera::lookAt() const {
-    gluLookAt(position.x, position.y, position.z,
-              target.x, target.y, target.z,
-              up.x, up.y, up.z);
+void Camera::setAspectRatio(float ratio) {
+    aspectRatio = ratio;
+    projectionMatrix = glm::perspective(glm::radians(fov), aspectRatio, nearPlane, farPlane);
+    viewProjectionMatrix = projectionMatrix * viewMatrix;
 }
 
-glm::mat4 Camera::getViewMatrix() const { // Keep `const` method
-    // Recalculate camera position and up vector based on yawAngle and pitchAngle
-
-
-    // **Calculate view matrix based on CURRENT position, target, up - NO MODIFICATION of members in getViewMatrix**
-    return glm::lookAt(position, target, up); // Use current position, target, up
+void Camera::interpolate(float alpha) {
+    eyePosition = glm::mix(previousPosition, position, alpha);
+    glm::vec3 eyeTarget = glm::mix(previousTarget, target, alpha);
+    viewMatrix = glm::lookAt(eyePosition, eyeTarget, up);
+    viewProjectionMatrix = projectionMatrix * viewMatrix;
 }
 
 
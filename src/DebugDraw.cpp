@@ -0,0 +1,150 @@
+/*
+ * File:        DebugDraw.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Batched debug lines (normals, grid wireframe, bounding boxes) in a streaming vertex buffer
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "DebugDraw.h"
+#include "GLDebug.h"
+#include <algorithm>
+#include <cstddef>
+
+DebugDraw::DebugDraw() : enabledLayers(0), vaoID(0), vertexBufferID(0), bufferCapacity(0) {}
+
+DebugDraw::~DebugDraw() {}
+
+bool DebugDraw::init()
+{
+    GL_DEBUG_SCOPE("DebugDraw::init");
+    glGenVertexArrays(1, &vaoID);
+    glBindVertexArray(vaoID);
+
+    glGenBuffers(1, &vertexBufferID);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+    bufferCapacity = DEBUG_DRAW_INITIAL_VERTICES;
+    glBufferData(GL_ARRAY_BUFFER, bufferCapacity * sizeof(DebugVertex), nullptr, GL_STREAM_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void *)offsetof(DebugVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DebugVertex), (void *)offsetof(DebugVertex, color));
+    glEnableVertexAttribArray(1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    vertices.reserve(bufferCapacity);
+    return vaoID != 0 && vertexBufferID != 0;
+}
+
+void DebugDraw::cleanup()
+{
+    glDeleteBuffers(1, &vertexBufferID);
+    glDeleteVertexArrays(1, &vaoID);
+    vertexBufferID = vaoID = 0;
+    bufferCapacity = 0;
+    vertices.clear();
+}
+
+uint32_t DebugDraw::packColor(const glm::vec3 &color)
+{
+    uint32_t r = static_cast<uint32_t>(glm::clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+    uint32_t g = static_cast<uint32_t>(glm::clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+    uint32_t b = static_cast<uint32_t>(glm::clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+    return r | (g << 8) | (b << 16) | (0xFFu << 24); // Bytes in memory: R, G, B, A
+}
+
+void DebugDraw::line(const glm::vec3 &from, const glm::vec3 &to, const glm::vec3 &color)
+{
+    uint32_t packed = packColor(color);
+    vertices.push_back({from, packed});
+    vertices.push_back({to, packed});
+}
+
+void DebugDraw::box(const glm::vec3 &boxMin, const glm::vec3 &boxMax, const glm::mat4 &model, const glm::vec3 &color)
+{
+    // Corner i has x from bit 0, y from bit 1, z from bit 2
+    glm::vec3 corners[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        glm::vec3 corner((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z);
+        corners[i] = glm::vec3(model * glm::vec4(corner, 1.0f));
+    }
+
+    static const int edges[12][2] = {{0, 1}, {2, 3}, {4, 5}, {6, 7}, {0, 2}, {1, 3}, {4, 6}, {5, 7}, {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+    for (const auto &edge : edges)
+    {
+        line(corners[edge[0]], corners[edge[1]], color);
+    }
+}
+
+void DebugDraw::gridNormals(const std::vector<glm::vec3> &positions, const std::vector<glm::vec3> &normals, const glm::vec3 &color)
+{
+    size_t count = std::min(positions.size(), normals.size());
+    uint32_t packed = packColor(color);
+    size_t first = vertices.size();
+    vertices.resize(first + 2 * count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        vertices[first + 2 * i] = {positions[i], packed};
+        vertices[first + 2 * i + 1] = {positions[i] + normals[i] * DEBUG_DRAW_NORMAL_LENGTH, packed};
+    }
+}
+
+void DebugDraw::gridLines(const std::vector<glm::vec3> &positions, int verticesX, int verticesZ, const glm::vec3 &offset,
+                          const glm::vec3 &color)
+{
+    if (positions.size() < static_cast<size_t>(verticesX) * verticesZ)
+    {
+        return; // Not produced yet (or the grid was just resized)
+    }
+
+    uint32_t packed = packColor(color);
+    vertices.reserve(vertices.size() + 4 * static_cast<size_t>(verticesX) * verticesZ);
+    for (int x = 0; x < verticesX; ++x)
+    {
+        for (int z = 0; z < verticesZ; ++z)
+        {
+            glm::vec3 v = positions[x * verticesZ + z] + offset;
+            if (x + 1 < verticesX)
+            {
+                vertices.push_back({v, packed});
+                vertices.push_back({positions[(x + 1) * verticesZ + z] + offset, packed});
+            }
+            if (z + 1 < verticesZ)
+            {
+                vertices.push_back({v, packed});
+                vertices.push_back({positions[x * verticesZ + z + 1] + offset, packed});
+            }
+        }
+    }
+}
+
+void DebugDraw::flush(Shader &shader)
+{
+    GL_DEBUG_SCOPE("DebugDraw::flush");
+    if (vertices.empty())
+    {
+        return;
+    }
+
+    // Orphan the old storage so the driver never waits for last frame's draw
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+    if (vertices.size() > bufferCapacity)
+    {
+        bufferCapacity = std::max(vertices.size(), 2 * bufferCapacity);
+    }
+    glBufferData(GL_ARRAY_BUFFER, bufferCapacity * sizeof(DebugVertex), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(DebugVertex), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    shader.use();
+    glBindVertexArray(vaoID);
+    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(vertices.size()));
+    glBindVertexArray(0);
+    shader.unuse();
+
+    vertices.clear(); // Keeps the capacity for the next frame
+}
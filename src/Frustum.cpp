@@ -0,0 +1,47 @@
+/*
+ * File:        Frustum.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: View frustum plane extraction and box culling
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "Frustum.h"
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+    extract(viewProjection);
+}
+
+void Frustum::extract(const glm::mat4& viewProjection) {
+    // Gribb-Hartmann: each plane is the last row of the matrix plus or minus one of the others
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i) {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[3] + rows[2];
+    planes[5] = rows[3] - rows[2];
+
+    for (glm::vec4& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+bool Frustum::intersects(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+    for (const glm::vec4& plane : planes) {
+        // Box corner furthest along the plane normal
+        glm::vec3 corner(plane.x >= 0.0f ? boxMax.x : boxMin.x,
+                         plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                         plane.z >= 0.0f ? boxMax.z : boxMin.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
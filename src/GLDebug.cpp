@@ -0,0 +1,117 @@
+/*
+ * File:        GLDebug.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: KHR_debug message callback and scoped debug groups, compiled only in debug builds
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "GLDebug.h"
+
+#ifdef DEBUG
+
+#include "utils.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // GL calls only come from the main thread
+    std::vector<const char *> scopeStack;
+    bool callbackInstalled = false;
+
+    std::string scopePath()
+    {
+        std::string path;
+        for (const char *label : scopeStack)
+        {
+            if (!path.empty())
+            {
+                path += " > ";
+            }
+            path += label;
+        }
+        return path.empty() ? "<no scope>" : path;
+    }
+
+    const char *typeName(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_DEBUG_TYPE_ERROR: return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+        case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+        default: return "other";
+        }
+    }
+
+    const char *severityName(GLenum severity)
+    {
+        switch (severity)
+        {
+        case GL_DEBUG_SEVERITY_HIGH: return "high";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+        case GL_DEBUG_SEVERITY_LOW: return "low";
+        default: return "notification";
+        }
+    }
+
+    void GLAPIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                  const GLchar *message, const void *userParam)
+    {
+        (void)source;
+        (void)length;
+        (void)userParam;
+        std::cerr << "GL " << typeName(type) << " (" << severityName(severity) << ", id " << id << ") in " << scopePath()
+                  << ": " << message << std::endl;
+    }
+}
+
+void initGLDebug()
+{
+    if (!GLEW_KHR_debug)
+    {
+        std::cerr << "KHR_debug not available, GL errors are polled at the end of every debug scope" << std::endl;
+        return;
+    }
+
+    // Synchronous output runs the callback inside the failing call, so the scope stack is still the caller's
+    glEnable(GL_DEBUG_OUTPUT);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(debugCallback, nullptr);
+
+    // Group push/pop and driver chatter would drown the real messages
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+    glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    callbackInstalled = true;
+}
+
+GLDebugScope::GLDebugScope(const char *label)
+{
+    scopeStack.push_back(label);
+    if (callbackInstalled)
+    {
+        glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, label);
+    }
+}
+
+GLDebugScope::~GLDebugScope()
+{
+    if (callbackInstalled)
+    {
+        glPopDebugGroup();
+    }
+    else
+    {
+        checkGLError(scopePath().c_str());
+    }
+    scopeStack.pop_back();
+}
+
+#endif // DEBUG
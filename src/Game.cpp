@@ -9,10 +9,20 @@
  */
 
 #include "Game.h"
+#include "Autotune.h"
+#include "GLDebug.h"
+#include "Trace.h"
+#include "Timing.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <thread>
 
 Game* Game::instance = nullptr;
 
-Game::Game() : renderer(), input(), ocean(200), boat(), camera(), terrain(150, 1.0f)  {
+Game::Game() : renderer(), input(), ocean(200), boat(), camera(), terrain(150, 1.0f), simRate(GAME_DEFAULT_SIM_RATE), accumulator(0.0),
+               headless(false), headlessFrames(0), headlessSeconds(0.0), realtime(false), autotune(true), retune(false)  {
     instance = this;
 }
 
@@ -21,9 +31,26 @@ Game::~Game() {
 }
 
 bool Game::init(int argc, char** argv) {
-    glutInit(&argc, argv);
+    Timing::calibrate(); // Before the first LATENCY_SCOPE
+    // Checked before glutInit, which already needs a display
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--headless") {
+            headless = true;
+        }
+    }
+    if (headless) {
+        return parseArguments(argc, argv) && initSimulation();
+    }
+
+    glutInit(&argc, argv); // Removes the GLUT options, the rest is ours
+    if (!parseArguments(argc, argv)) {
+        return false;
+    }
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(1200, 800);
+#ifdef DEBUG
+    glutInitContextFlags(GLUT_DEBUG); // Lets the driver validate every call for the KHR_debug callback
+#endif
     glutCreateWindow("3D Boat Simulation");
 
     // **Initialize GLEW AFTER creating the window:**
@@ -31,6 +58,7 @@ bool Game::init(int argc, char** argv) {
         //std::cerr << "GLEW initialization failed!" << std::endl;
         return false;
     }
+    initGLDebug(); // No-op in release builds
 
 
 
@@ -42,13 +70,14 @@ bool Game::init(int argc, char** argv) {
     glutSpecialUpFunc(specialUpCallback);
     glutMouseFunc(mouseCallback);
     glutMotionFunc(motionCallback);
-    glutTimerFunc(16, timerCallback, 0); // ~60 FPS
+    glutIdleFunc(idleCallback); // Renders as often as the display allows, simulates at simRate
 
     glEnable(GL_DEPTH_TEST);
     renderer.init();
     //int oceanGridSize = 1000; // Default gridSize (you can change this)
     //ocean = Ocean(oceanGridSize); // Pass gridSize to constructor
     ocean.init();
+    tuneOcean();
 
     if (!boat.init("assets/models/boat.obj", "assets/models/boat.jpg")) {
         std::cerr << "Boat initialization failed!" << std::endl;
@@ -62,10 +91,11 @@ bool Game::init(int argc, char** argv) {
     std::cerr << "Terrain init" << std::endl;
 
     // Initialize Terrain
-    if (!terrain.init(renderer.heightMapTextureID)) {
+    if (!terrain.init("assets/textures/terain.png")) {
         std::cerr << "Terrain initialization failed!" << std::endl;
         return false;
     }
+    renderer.setHeightMap(terrain.getHeightMap());
     std::cerr << "Camera init" << std::endl;
 
     camera.init();
@@ -75,21 +105,274 @@ bool Game::init(int argc, char** argv) {
     return true;
 }
 
+bool Game::parseArguments(int argc, char** argv) {
+    std::string recordPath, replayPath;
+    bool perf = false;
+    std::vector<PerfEventSpec> perfEvents = PerfCounters::defaultEvents();
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--sim-rate" && i + 1 < argc) {
+            simRate = std::atof(argv[++i]);
+            if (simRate < 1.0 || simRate > 10000.0) {
+                std::cerr << "--sim-rate must be between 1 and 10000 Hz" << std::endl;
+                return false;
+            }
+        } else if (argument == "--headless") {
+            // Handled by init
+        } else if (argument == "--frames" && i + 1 < argc) {
+            headlessFrames = std::atol(argv[++i]);
+            if (headlessFrames <= 0) {
+                std::cerr << "--frames must be a positive step count" << std::endl;
+                return false;
+            }
+        } else if (argument == "--seconds" && i + 1 < argc) {
+            headlessSeconds = std::atof(argv[++i]);
+            if (headlessSeconds <= 0.0) {
+                std::cerr << "--seconds must be positive" << std::endl;
+                return false;
+            }
+        } else if (argument == "--realtime") {
+            realtime = true;
+        } else if (argument == "--out" && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else if (argument == "--kernel" && i + 1 < argc) {
+            OceanKernel kernel;
+            if (!Ocean::parseKernel(argv[++i], kernel) || kernel == OCEAN_KERNEL_REFERENCE) {
+                std::cerr << "--kernel must be simd, specialized, jit or fixed" << std::endl;
+                return false;
+            }
+            ocean.setSurfaceKernel(kernel);
+            autotune = false;
+        } else if (argument == "--autotune") {
+            retune = true;
+        } else if (argument == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (argument == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (argument == "--trace" && i + 1 < argc) {
+            Trace::enable(argv[++i]);
+        } else if (argument == "--perf") {
+            perf = true;
+        } else if (argument == "--perf-events" && i + 1 < argc) {
+            perf = true;
+            if (!PerfCounters::parseRawEvents(argv[++i], perfEvents)) {
+                return false;
+            }
+        } else if (argument == "--latency-report" && i + 1 < argc) {
+            double interval = std::atof(argv[++i]);
+            if (interval <= 0.0) {
+                std::cerr << "--latency-report must be a positive number of seconds" << std::endl;
+                return false;
+            }
+            Timing::setReportInterval(interval);
+        } else {
+            std::cerr << "Unknown argument: " << argument << "\n"
+                      << "Usage: " << argv[0] << " [--sim-rate HZ] [--kernel NAME | --autotune] [--record FILE | --replay FILE] [--trace BASE] [--latency-report SECONDS]\n"
+                      << "       " << argv[0] << " --headless (--frames N | --seconds S | --replay FILE) [--realtime] [--out FILE.csv] [--sim-rate HZ] [--kernel NAME | --autotune] [--record FILE] [--trace BASE] [--latency-report SECONDS]\n"
+                      << "--kernel simd|specialized|jit|fixed picks the ocean kernel whose surface is shown, otherwise the fastest\n"
+                      << "  kernel, thread count and tile are measured once per host and grid and cached in " AUTOTUNE_CACHE_PATH "\n"
+                      << "--autotune measures them again and replaces the cached choice\n"
+                      << "--record writes the input and step length of every step, --replay runs them again (at the recorded rate)\n"
+                      << "--trace records timing zones and writes BASE.json and BASE.txt (the simd kernel, as in docs/data) at exit and on SIGUSR1,\n"
+                      << "  and BASE.KERNEL.txt for the other kernels\n"
+                      << "--latency-report prints zone latency percentiles every SECONDS, they are always printed at exit\n"
+                      << "--perf [--perf-events name=rUUEE,...] adds hardware counters to the --trace zones, printed at exit" << std::endl;
+            return false;
+        }
+    }
+
+    if (perf) {
+        if (!Trace::isEnabled()) {
+            std::cerr << "--perf counts per trace zone and needs --trace" << std::endl;
+            return false;
+        }
+        Trace::enableCounters(perfEvents);
+    }
+
+    bool headlessOptions = headlessFrames > 0 || headlessSeconds > 0.0 || realtime || !metricsPath.empty();
+    if (!headless && headlessOptions) {
+        std::cerr << "--frames, --seconds, --realtime and --out need --headless" << std::endl;
+        return false;
+    }
+    if (!replayPath.empty()) {
+        if (!replay.open(replayPath)) {
+            return false;
+        }
+        simRate = replay.getSimRate(); // Recorded steps are replayed as they were
+    }
+    if (!recordPath.empty()) {
+        if (!recorder.open(recordPath, simRate)) {
+            return false;
+        }
+        std::atexit(closeRecordingAtExit); // glutMainLoop leaves through exit(), past cleanup()
+    }
+    if (!autotune && retune) {
+        std::cerr << "--autotune and --kernel exclude each other" << std::endl;
+        return false;
+    }
+    if (headless && headlessFrames == 0 && headlessSeconds == 0.0 && !replay.isOpen()) {
+        std::cerr << "--headless needs --frames, --seconds or --replay" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Game::prepareStep(float& deltaTime) {
+    if (replay.isOpen()) {
+        ReplayStep step;
+        if (!replay.next(step)) {
+            return false;
+        }
+        input.restore(step.input); // Live events of this frame are overwritten
+        deltaTime = step.deltaTime;
+    }
+    if (recorder.isOpen()) {
+        recorder.write({deltaTime, input.snapshot()});
+    }
+    return true;
+}
+
+bool Game::initSimulation() {
+    if (!ocean.generate()) {
+        std::cerr << "Ocean initialization failed!" << std::endl;
+        return false;
+    }
+    tuneOcean();
+    // The mesh gives the bounding box, the texture is only a path until the renderer loads it
+    if (!boat.load("assets/models/boat.obj", "assets/models/boat.jpg")) {
+        std::cerr << "Boat initialization failed!" << std::endl;
+        return false;
+    }
+    boat.setScale(0.01f);
+    if (!terrain.generate("assets/textures/terain.png")) {
+        std::cerr << "Terrain initialization failed!" << std::endl;
+        return false;
+    }
+    camera.init();
+    input.init();
+
+    if (!metricsPath.empty()) {
+        metrics.open(metricsPath);
+        if (!metrics) {
+            std::cerr << "Cannot write metrics to " << metricsPath << std::endl;
+            return false;
+        }
+        metrics << "step,time,step_ms,boat_x,boat_y,boat_z,boat_qw,boat_qx,boat_qy,boat_qz,wave_min,wave_max,wave_mean\n";
+    }
+    return true;
+}
+
+void Game::tuneOcean() {
+    if (autotune) {
+        Autotune::apply(ocean, AUTOTUNE_CACHE_PATH, retune);
+    }
+}
+
+void Game::runHeadless() {
+    long steps = headlessFrames > 0 ? headlessFrames : static_cast<long>(std::ceil(headlessSeconds * simRate));
+    if (headlessFrames == 0 && headlessSeconds == 0.0) {
+        steps = -1; // --replay alone, the whole recording
+    }
+    double step = 1.0 / simRate;
+    double simulated = 0.0;
+    double slowestMilliseconds = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    long frame = 0;
+    for (; steps < 0 || frame < steps; ++frame) {
+        float deltaTime = static_cast<float>(step);
+        if (!prepareStep(deltaTime)) {
+            break;
+        }
+        if (realtime) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                      std::chrono::duration<double>(simulated + deltaTime)));
+        }
+        simulated += deltaTime;
+        auto stepStart = std::chrono::steady_clock::now();
+        updateGame(deltaTime);
+        double stepMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stepStart).count();
+        slowestMilliseconds = std::max(slowestMilliseconds, stepMilliseconds);
+        if (metrics.is_open()) {
+            writeMetrics(frame, stepMilliseconds);
+        }
+        Trace::pollDumpRequest();
+        Timing::pollReport();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Headless: " << frame << " steps (" << simulated << " s simulated) in " << elapsed << " s, "
+              << elapsed * 1000.0 / std::max(frame, 1L) << " ms/step mean, " << slowestMilliseconds << " ms slowest" << std::endl;
+    if (metrics.is_open()) {
+        metrics.flush();
+        if (!metrics) {
+            std::cerr << "Writing " << metricsPath << " failed" << std::endl;
+        }
+    }
+}
+
+void Game::writeMetrics(long frame, double stepMilliseconds) {
+    const std::vector<glm::vec3>& surface = ocean.getSurfaceVertices();
+    float waveMin = 0.0f, waveMax = 0.0f;
+    double waveSum = 0.0;
+    if (!surface.empty()) {
+        waveMin = waveMax = surface[0].y;
+        for (const glm::vec3& vertex : surface) {
+            waveMin = std::min(waveMin, vertex.y);
+            waveMax = std::max(waveMax, vertex.y);
+            waveSum += vertex.y;
+        }
+    }
+    glm::vec3 position = boat.getPosition();
+    glm::quat rotation = boat.getRotation();
+    metrics << frame << ',' << ocean.time << ',' << stepMilliseconds << ','
+            << position.x << ',' << position.y << ',' << position.z << ','
+            << rotation.w << ',' << rotation.x << ',' << rotation.y << ',' << rotation.z << ','
+            << waveMin << ',' << waveMax << ',' << (surface.empty() ? 0.0 : waveSum / surface.size()) << '\n';
+}
+
 void Game::run() {
+    std::cout << "Simulation rate: " << simRate << " Hz" << std::endl;
+    if (headless) {
+        runHeadless();
+        return;
+    }
+    lastFrameTime = std::chrono::steady_clock::now();
+    replayStart = lastFrameTime;
     glutMainLoop();
 }
 
 void Game::cleanup() {
-    renderer.cleanup();
+    if (!headless) {
+        renderer.cleanup(); // Nothing was created headless, and GL is not loaded
+    }
+    closeRecording();
     ocean.cleanup();
     boat.cleanup();
     terrain.cleanup(); // Cleanup terrain
 
 }
 
+void Game::closeRecording() {
+    if (recorder.isOpen()) {
+        long steps = recorder.getStepCount();
+        if (recorder.close()) {
+            std::cout << "Recorded " << steps << " steps" << std::endl;
+        }
+    }
+}
+
+void Game::closeRecordingAtExit() {
+    if (instance) {
+        instance->closeRecording();
+    }
+}
+
 void Game::displayCallback() {
+    TRACE_SCOPE("Game::render");
     instance->renderer.renderScene(instance->ocean, instance->boat, instance->camera, instance->terrain); // **Pass instance->terrain**
-        glutSwapBuffers();
+    LATENCY_SCOPE("Swap buffers"); // Blocks on the GPU and vsync
+    glutSwapBuffers();
 }
 
 void Game::reshapeCallback(int width, int height) {
@@ -98,6 +381,15 @@ void Game::reshapeCallback(int width, int height) {
 }
 
 void Game::keyboardCallback(unsigned char key, int x, int y) {
+    // Debug layers toggle on the press, not on key repeat
+    if (!instance->input.isKeyDown(key)) {
+        DebugDraw& debugDraw = instance->renderer.getDebugDraw();
+        switch (key) {
+            case 'n': debugDraw.toggleLayer(DEBUG_LAYER_NORMALS); break;
+            case 'g': debugDraw.toggleLayer(DEBUG_LAYER_GRID); break;
+            case 'b': debugDraw.toggleLayer(DEBUG_LAYER_BOUNDING_BOXES); break;
+        }
+    }
     instance->input.handleKeyPress(key);
 }
 
@@ -121,17 +413,68 @@ void Game::motionCallback(int x, int y) {
     instance->input.handleMouseMove(x, y);
 }
 
-void Game::updateGame() {
-    float deltaTime = 1.0f / 60.0f; // Fixed timestep for simplicity
+void Game::updateGame(float deltaTime) {
+    TRACE_SCOPE("Game::updateGame");
+    LATENCY_SCOPE("Simulation step");
     instance->input.update();
-    instance->boat.update(instance->input, instance->ocean, deltaTime);
+    {
+        LATENCY_SCOPE("Boat update");
+        instance->boat.update(instance->input, instance->ocean, deltaTime);
+    }
     instance->camera.update(instance->input, instance->boat.getPosition()); // Camera follows boat (optional)
     instance->ocean.update(deltaTime);
 }
 
-void Game::timerCallback(int value) {
-    instance->updateGame();
-    glutTimerFunc(16, timerCallback, 0); // Re-register timer
+void Game::idleCallback() {
+    Game& game = *instance;
+    auto now = std::chrono::steady_clock::now();
+    double frameTime = std::chrono::duration<double>(now - game.lastFrameTime).count();
+    game.lastFrameTime = now;
+    static LatencyHistogram& frameHistogram = Timing::histogram("Frame"); // Real time between idle callbacks
+    frameHistogram.record(static_cast<uint64_t>(frameTime * 1e9));
+
+    // A replay renders every recorded step once, as fast as the frames go
+    if (game.replay.isOpen()) {
+        float deltaTime = static_cast<float>(1.0 / game.simRate);
+        if (!game.prepareStep(deltaTime)) {
+            double elapsed = std::chrono::duration<double>(now - game.replayStart).count();
+            long steps = game.replay.getStepCount();
+            std::cout << "Replay: " << steps << " frames in " << elapsed << " s, "
+                      << elapsed * 1000.0 / std::max(steps, 1L) << " ms/frame mean" << std::endl;
+            glutLeaveMainLoop();
+            return;
+        }
+        updateGame(deltaTime);
+        game.boat.interpolate(1.0f);
+        game.camera.interpolate(1.0f);
+        Trace::pollDumpRequest();
+        Timing::pollReport();
+        glutPostRedisplay();
+        return;
+    }
+
+    // Long stalls (window drag, breakpoint) are not caught up
+    game.accumulator += std::min(frameTime, GAME_MAX_FRAME_TIME);
+
+    double step = 1.0 / game.simRate;
+    int steps = 0;
+    while (game.accumulator >= step && steps < GAME_MAX_STEPS_PER_FRAME) {
+        float deltaTime = static_cast<float>(step);
+        game.prepareStep(deltaTime); // Records, the replay took the branch above
+        updateGame(deltaTime);
+        game.accumulator -= step;
+        steps++;
+    }
+    if (steps == GAME_MAX_STEPS_PER_FRAME && game.accumulator >= step) {
+        game.accumulator = std::fmod(game.accumulator, step); // Simulation cannot keep up, run slower than real time
+    }
+
+    // Render the state between the last two steps
+    float alpha = static_cast<float>(game.accumulator / step);
+    game.boat.interpolate(alpha);
+    game.camera.interpolate(alpha);
+    Trace::pollDumpRequest();
+    Timing::pollReport();
     glutPostRedisplay(); // Request redraw
 }
 
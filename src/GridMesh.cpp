@@ -0,0 +1,158 @@
+/*
+ * File:        GridMesh.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Shared triangle strip index buffers for the ocean grid and the terrain tiles
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "GridMesh.h"
+#include "GLDebug.h"
+#include <map>
+#include <tuple>
+
+namespace
+{
+    struct SharedGrid
+    {
+        GridIndexBuffer buffer;
+        int users;
+    };
+
+    std::map<std::tuple<int, int, bool>, SharedGrid> sharedGrids;
+}
+
+size_t gridVertexCount(int verticesX, int verticesZ, bool skirts)
+{
+    size_t count = static_cast<size_t>(verticesX) * verticesZ;
+    if (skirts)
+    {
+        count += 2 * static_cast<size_t>(verticesX) + 2 * static_cast<size_t>(verticesZ);
+    }
+    return count;
+}
+
+void buildGridStrips(int verticesX, int verticesZ, bool skirts, std::vector<unsigned int> &indices)
+{
+    indices.clear();
+
+    // (x, z), (x + 1, z) pairs keep the winding of the old (v00, v10, v11, v01) quads
+    for (int x = 0; x + 1 < verticesX; ++x)
+    {
+        if (x > 0)
+        {
+            indices.push_back(GRID_RESTART_INDEX_32);
+        }
+        for (int z = 0; z < verticesZ; ++z)
+        {
+            indices.push_back(x * verticesZ + z);
+            indices.push_back((x + 1) * verticesZ + z);
+        }
+    }
+
+    if (!skirts)
+    {
+        return;
+    }
+
+    // Every skirt edge is a strip between the border vertices and their lowered copies
+    unsigned int ringStart = static_cast<unsigned int>(verticesX * verticesZ);
+    for (int edge = 0; edge < 4; ++edge)
+    {
+        int edgeLength = (edge % 2 == 0) ? verticesX : verticesZ;
+        indices.push_back(GRID_RESTART_INDEX_32);
+        for (int k = 0; k < edgeLength; ++k)
+        {
+            unsigned int top;
+            switch (edge)
+            {
+            case 0: top = k * verticesZ; break;
+            case 1: top = (verticesX - 1) * verticesZ + k; break;
+            case 2: top = k * verticesZ + (verticesZ - 1); break;
+            default: top = k; break;
+            }
+            indices.push_back(ringStart + k);
+            indices.push_back(top);
+        }
+        ringStart += edgeLength;
+    }
+}
+
+const GridIndexBuffer *acquireGridIndexBuffer(int verticesX, int verticesZ, bool skirts)
+{
+    GL_DEBUG_SCOPE("acquireGridIndexBuffer");
+    auto key = std::make_tuple(verticesX, verticesZ, skirts);
+    auto found = sharedGrids.find(key);
+    if (found != sharedGrids.end())
+    {
+        found->second.users++;
+        return &found->second.buffer;
+    }
+
+    std::vector<unsigned int> indices;
+    buildGridStrips(verticesX, verticesZ, skirts, indices);
+
+    SharedGrid &shared = sharedGrids[key];
+    shared.users = 1;
+    shared.buffer.indexCount = static_cast<GLsizei>(indices.size());
+    glGenBuffers(1, &shared.buffer.bufferID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shared.buffer.bufferID);
+
+    // 16-bit indices need every vertex index below the restart value
+    if (gridVertexCount(verticesX, verticesZ, skirts) <= GRID_RESTART_INDEX_16)
+    {
+        std::vector<unsigned short> shortIndices(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            shortIndices[i] = indices[i] == GRID_RESTART_INDEX_32 ? GRID_RESTART_INDEX_16 : static_cast<unsigned short>(indices[i]);
+        }
+        shared.buffer.indexType = GL_UNSIGNED_SHORT;
+        shared.buffer.restartIndex = GRID_RESTART_INDEX_16;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(unsigned short), shortIndices.data(), GL_STATIC_DRAW);
+    }
+    else
+    {
+        shared.buffer.indexType = GL_UNSIGNED_INT;
+        shared.buffer.restartIndex = GRID_RESTART_INDEX_32;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    }
+
+    // The caller binds it again inside its VAO
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    return &shared.buffer;
+}
+
+void releaseGridIndexBuffer(const GridIndexBuffer *grid)
+{
+    for (auto it = sharedGrids.begin(); it != sharedGrids.end(); ++it)
+    {
+        if (&it->second.buffer == grid)
+        {
+            if (--it->second.users == 0)
+            {
+                glDeleteBuffers(1, &it->second.buffer.bufferID);
+                sharedGrids.erase(it);
+            }
+            return;
+        }
+    }
+}
+
+void beginGridDraw(const GridIndexBuffer &grid)
+{
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(grid.restartIndex);
+}
+
+void drawGrid(const GridIndexBuffer &grid, GLint baseVertex)
+{
+    // The restart index is compared before baseVertex is added, so tiles can share the buffer
+    glDrawElementsBaseVertex(GL_TRIANGLE_STRIP, grid.indexCount, grid.indexType, 0, baseVertex);
+}
+
+void endGridDraw()
+{
+    glDisable(GL_PRIMITIVE_RESTART);
+}
@@ -56,6 +56,29 @@ void Input::handleMouseMove(int x, int y) {
     mouseY = y;
 }
 
+InputSnapshot Input::snapshot() const {
+    InputSnapshot snapshot;
+    snapshot.keys.assign(keysDown.begin(), keysDown.end());
+    snapshot.specialKeys.assign(specialKeysDown.begin(), specialKeysDown.end());
+    snapshot.mouseButtons = 0;
+    for (int button = 0; button < 5; ++button) {
+        snapshot.mouseButtons |= mouseButtonsDown[button] ? (1 << button) : 0;
+    }
+    snapshot.mouseX = mouseX;
+    snapshot.mouseY = mouseY;
+    return snapshot;
+}
+
+void Input::restore(const InputSnapshot& snapshot) {
+    keysDown = std::set<unsigned char>(snapshot.keys.begin(), snapshot.keys.end());
+    specialKeysDown = std::set<int>(snapshot.specialKeys.begin(), snapshot.specialKeys.end());
+    for (int button = 0; button < 5; ++button) {
+        mouseButtonsDown[button] = (snapshot.mouseButtons >> button) & 1;
+    }
+    mouseX = snapshot.mouseX;
+    mouseY = snapshot.mouseY;
+}
+
 bool Input::isKeyDown(unsigned char key) const {
     return keysDown.count(key);
 }
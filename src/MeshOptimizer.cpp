@@ -0,0 +1,371 @@
+/*
+ * File:        MeshOptimizer.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Load-time mesh pipeline - vertex welding, index buffer and vertex cache optimization
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "MeshOptimizer.h"
+#include <unordered_map>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <iomanip>
+#include <map>
+
+namespace
+{
+    // Full vertex tuple, compared bitwise so only exact duplicates are merged
+    struct VertexKey
+    {
+        float attributes[8]; // position, normal, uv - tightly packed, no padding
+        int material;
+
+        bool operator==(const VertexKey &other) const
+        {
+            return memcmp(this, &other, sizeof(VertexKey)) == 0;
+        }
+    };
+
+    struct VertexKeyHash
+    {
+        size_t operator()(const VertexKey &key) const
+        {
+            // FNV-1a over the raw bytes
+            const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&key);
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < sizeof(VertexKey); ++i)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    // Forsyth scoring constants (https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html)
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRI_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    float forsythVertexScore(int cachePosition, int remainingValence)
+    {
+        if (remainingValence <= 0)
+        {
+            return -1.0f; // No triangles left to use this vertex
+        }
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+            {
+                // Vertices of the last triangle get a fixed score so the next triangle does not just reuse its edge
+                score = LAST_TRI_SCORE;
+            }
+            else
+            {
+                float scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+                score = powf(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+
+        // Prefer vertices with few remaining triangles to get rid of them
+        score += VALENCE_BOOST_SCALE * powf(static_cast<float>(remainingValence), -VALENCE_BOOST_POWER);
+        return score;
+    }
+}
+
+void weldVertices(std::vector<glm::vec3> &vertices, std::vector<glm::vec3> &normals, std::vector<glm::vec2> &texCoords,
+                  std::vector<int> &materialIndices, std::vector<unsigned int> &indices)
+{
+    size_t sourceCount = vertices.size();
+
+    std::unordered_map<VertexKey, unsigned int, VertexKeyHash> lookup;
+    lookup.reserve(sourceCount);
+
+    std::vector<glm::vec3> weldedVertices;
+    std::vector<glm::vec3> weldedNormals;
+    std::vector<glm::vec2> weldedTexCoords;
+    std::vector<int> weldedMaterials;
+    weldedVertices.reserve(sourceCount);
+    weldedNormals.reserve(sourceCount);
+    weldedTexCoords.reserve(sourceCount);
+    weldedMaterials.reserve(sourceCount);
+
+    indices.clear();
+    indices.reserve(sourceCount);
+
+    for (size_t i = 0; i < sourceCount; ++i)
+    {
+        VertexKey key = {{vertices[i].x, vertices[i].y, vertices[i].z,
+                          normals[i].x, normals[i].y, normals[i].z,
+                          texCoords[i].x, texCoords[i].y},
+                         materialIndices[i]};
+
+        auto inserted = lookup.emplace(key, static_cast<unsigned int>(weldedVertices.size()));
+        if (inserted.second)
+        {
+            weldedVertices.push_back(vertices[i]);
+            weldedNormals.push_back(normals[i]);
+            weldedTexCoords.push_back(texCoords[i]);
+            weldedMaterials.push_back(materialIndices[i]);
+        }
+        indices.push_back(inserted.first->second);
+    }
+
+    vertices.swap(weldedVertices);
+    normals.swap(weldedNormals);
+    texCoords.swap(weldedTexCoords);
+    materialIndices.swap(weldedMaterials);
+}
+
+void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+    {
+        return;
+    }
+
+    // Vertex -> triangle adjacency in CSR layout, active entries are kept at the front of each list
+    std::vector<int> remainingValence(vertexCount, 0);
+    for (unsigned int index : indices)
+    {
+        remainingValence[index]++;
+    }
+
+    std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + remainingValence[v];
+    }
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = indices[t * 3 + k];
+            adjacency[fill[v]++] = static_cast<unsigned int>(t);
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        vertexScore[v] = forsythVertexScore(-1, remainingValence[v]);
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    unsigned int cache[VERTEX_CACHE_SIZE + 3];
+    int cacheCount = 0;
+
+    long bestTriangle = -1;
+    size_t scanPosition = 0; // Fallback when nothing in the cache has triangles left
+
+    for (size_t n = 0; n < triangleCount; ++n)
+    {
+        if (bestTriangle < 0)
+        {
+            while (emitted[scanPosition])
+            {
+                scanPosition++;
+            }
+            bestTriangle = static_cast<long>(scanPosition);
+        }
+
+        const unsigned int *triangle = &indices[bestTriangle * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[bestTriangle] = true;
+
+        // Put the triangle's vertices to the front of the LRU cache
+        unsigned int newCache[VERTEX_CACHE_SIZE + 3];
+        int newCount = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = triangle[k];
+
+            // Drop the emitted triangle from the vertex's active adjacency
+            unsigned int begin = adjacencyOffset[v];
+            unsigned int end = begin + remainingValence[v];
+            for (unsigned int a = begin; a < end; ++a)
+            {
+                if (adjacency[a] == static_cast<unsigned int>(bestTriangle))
+                {
+                    std::swap(adjacency[a], adjacency[end - 1]);
+                    remainingValence[v]--;
+                    break;
+                }
+            }
+
+            bool duplicate = false;
+            for (int c = 0; c < newCount; ++c)
+            {
+                duplicate |= newCache[c] == v;
+            }
+            if (!duplicate)
+            {
+                newCache[newCount++] = v;
+            }
+        }
+        for (int c = 0; c < cacheCount; ++c)
+        {
+            unsigned int v = cache[c];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            {
+                newCache[newCount++] = v;
+            }
+        }
+
+        // Rescore everything that moved (including vertices that just fell out of the cache)
+        for (int c = 0; c < newCount; ++c)
+        {
+            unsigned int v = newCache[c];
+            cachePosition[v] = c < VERTEX_CACHE_SIZE ? c : -1;
+            vertexScore[v] = forsythVertexScore(cachePosition[v], remainingValence[v]);
+        }
+
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (int c = 0; c < newCount; ++c)
+        {
+            unsigned int v = newCache[c];
+            unsigned int begin = adjacencyOffset[v];
+            unsigned int end = begin + remainingValence[v];
+            for (unsigned int a = begin; a < end; ++a)
+            {
+                unsigned int t = adjacency[a];
+                float score = vertexScore[indices[t * 3 + 0]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                if (c < VERTEX_CACHE_SIZE && score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cacheCount = newCount < VERTEX_CACHE_SIZE ? newCount : VERTEX_CACHE_SIZE;
+        memcpy(cache, newCache, cacheCount * sizeof(unsigned int));
+    }
+
+    indices.swap(output);
+}
+
+void buildMaterialBatches(std::vector<unsigned int> &indices, const std::vector<int> &materialIndices, std::vector<MeshBatch> &batches)
+{
+    // Welding keys on the material, so the first vertex decides the material of the whole triangle
+    std::map<int, std::vector<unsigned int>> groups;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::vector<unsigned int> &group = groups[materialIndices[indices[i]]];
+        group.insert(group.end(), indices.begin() + i, indices.begin() + i + 3);
+    }
+
+    batches.clear();
+    indices.clear();
+    for (const auto &group : groups)
+    {
+        batches.push_back({group.first, static_cast<unsigned int>(indices.size()), static_cast<unsigned int>(group.second.size())});
+        indices.insert(indices.end(), group.second.begin(), group.second.end());
+    }
+}
+
+void optimizeVertexFetch(std::vector<glm::vec3> &vertices, std::vector<glm::vec3> &normals, std::vector<glm::vec2> &texCoords,
+                         std::vector<int> &materialIndices, std::vector<unsigned int> &indices)
+{
+    const unsigned int unused = std::numeric_limits<unsigned int>::max();
+    size_t vertexCount = vertices.size();
+    std::vector<unsigned int> remap(vertexCount, unused);
+
+    unsigned int next = 0;
+    for (unsigned int &index : indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+    // Unreferenced vertices go to the end
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        if (remap[v] == unused)
+        {
+            remap[v] = next++;
+        }
+    }
+
+    std::vector<glm::vec3> newVertices(vertexCount);
+    std::vector<glm::vec3> newNormals(vertexCount);
+    std::vector<glm::vec2> newTexCoords(vertexCount);
+    std::vector<int> newMaterials(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        newVertices[remap[v]] = vertices[v];
+        newNormals[remap[v]] = normals[v];
+        newTexCoords[remap[v]] = texCoords[v];
+        newMaterials[remap[v]] = materialIndices[v];
+    }
+
+    vertices.swap(newVertices);
+    normals.swap(newNormals);
+    texCoords.swap(newTexCoords);
+    materialIndices.swap(newMaterials);
+}
+
+float computeACMR(const std::vector<unsigned int> &indices, size_t vertexCount, int cacheSize)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return 0.0f;
+    }
+
+    // A vertex stays in a FIFO cache until cacheSize further misses happen
+    std::vector<size_t> insertedAt(vertexCount, 0);
+    size_t misses = 0;
+    for (unsigned int index : indices)
+    {
+        if (insertedAt[index] == 0 || misses - insertedAt[index] >= static_cast<size_t>(cacheSize))
+        {
+            misses++;
+            insertedAt[index] = misses;
+        }
+    }
+    return static_cast<float>(misses) / triangleCount;
+}
+
+bool packIndices16(const std::vector<unsigned int> &indices, size_t vertexCount, std::vector<unsigned short> &dst)
+{
+    dst.clear();
+    if (vertexCount > std::numeric_limits<unsigned short>::max())
+    {
+        return false;
+    }
+
+    dst.assign(indices.begin(), indices.end());
+    return true;
+}
+
+void printMeshStats(const char *name, const MeshStats &stats)
+{
+    std::cout << std::fixed << std::setprecision(2)
+              << name << " mesh: " << stats.triangles << " triangles, vertices " << stats.sourceVertices << " -> " << stats.uniqueVertices
+              << ", memory " << stats.bytesBefore / 1024.0f << " KiB -> " << stats.bytesAfter / 1024.0f << " KiB ("
+              << (stats.shortIndices ? "16" : "32") << "-bit indices)"
+              << ", ACMR " << stats.acmrBefore << " -> " << stats.acmrAfter << std::endl;
+    std::cout.unsetf(std::ios_base::floatfield);
+    std::cout << std::setprecision(6);
+}
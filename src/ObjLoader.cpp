@@ -0,0 +1,555 @@
+/*
+ * File:        ObjLoader.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Multithreaded OBJ parser - mmap, line-aligned chunks parsed in parallel, deterministic merge
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "ObjLoader.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define OBJ_MIN_CHUNK_SIZE (256 * 1024) // Smaller chunks are not worth the merge
+
+namespace
+{
+    const int INHERIT_MATERIAL = -2; // Face uses the material active at the end of the previous chunk
+
+    // Bits of ObjChunk::relative - the index was negative (relative to the current element count)
+    const unsigned char RELATIVE_VERTEX = 1;
+    const unsigned char RELATIVE_TEXCOORD = 2;
+    const unsigned char RELATIVE_NORMAL = 4;
+
+    // Parse result of one line-aligned part of the file, indices are local to the chunk
+    struct ObjChunk
+    {
+        const char *begin;
+        const char *end;
+
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> texcoords;
+        std::vector<tinyobj::index_t> indices; // Polygon corners, triangulated during the merge
+        std::vector<unsigned char> relative;   // One per index, RELATIVE_* bits
+        std::vector<int> faceSizes;            // Corner count of every polygon
+        std::vector<int> materialTokens;       // One per polygon, index into materialNames or INHERIT_MATERIAL
+        size_t triangleCount = 0;
+        std::vector<std::string> materialNames;
+        std::vector<std::string> mtllibs;
+        int lastMaterialToken = INHERIT_MATERIAL;
+    };
+
+    inline const char *skipSpaces(const char *p, const char *end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t'))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    inline bool isLineEnd(const char *p, const char *end)
+    {
+        return p >= end || *p == '\r' || *p == '\n' || *p == '#';
+    }
+
+    inline const char *parseFloat(const char *p, const char *end, float &value)
+    {
+        p = skipSpaces(p, end);
+        if (p < end && *p == '+')
+        {
+            ++p; // from_chars does not accept an explicit plus sign
+        }
+        std::from_chars_result result = std::from_chars(p, end, value);
+        if (result.ec != std::errc())
+        {
+            value = 0.0f;
+            while (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+            {
+                ++p;
+            }
+            return p;
+        }
+        return result.ptr;
+    }
+
+    inline const char *parseInt(const char *p, const char *end, int &value)
+    {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            ++p;
+        }
+        value = 0;
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            value = value * 10 + (*p - '0');
+            ++p;
+        }
+        if (negative)
+        {
+            value = -value;
+        }
+        return p;
+    }
+
+    // OBJ indices are 1-based, negative ones count back from the last element
+    inline int resolveIndex(int raw, size_t count, unsigned char relativeBit, unsigned char &relative)
+    {
+        if (raw > 0)
+        {
+            return raw - 1;
+        }
+        if (raw < 0)
+        {
+            relative |= relativeBit;
+            return static_cast<int>(count) + raw;
+        }
+        return -1; // Missing component
+    }
+
+    std::string readName(const char *p, const char *end)
+    {
+        p = skipSpaces(p, end);
+        const char *nameEnd = p;
+        while (nameEnd < end && *nameEnd != '\r' && *nameEnd != '\n')
+        {
+            ++nameEnd;
+        }
+        while (nameEnd > p && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t'))
+        {
+            --nameEnd;
+        }
+        return std::string(p, nameEnd);
+    }
+
+    void parseFace(ObjChunk &chunk, const char *p, const char *end, std::vector<tinyobj::index_t> &polygon, std::vector<unsigned char> &polygonRelative)
+    {
+        polygon.clear();
+        polygonRelative.clear();
+
+        size_t positionCount = chunk.positions.size() / 3;
+        size_t texcoordCount = chunk.texcoords.size() / 2;
+        size_t normalCount = chunk.normals.size() / 3;
+
+        for (;;)
+        {
+            p = skipSpaces(p, end);
+            if (isLineEnd(p, end))
+            {
+                break;
+            }
+
+            tinyobj::index_t index;
+            unsigned char relative = 0;
+            int raw = 0;
+
+            p = parseInt(p, end, raw);
+            index.vertex_index = resolveIndex(raw, positionCount, RELATIVE_VERTEX, relative);
+            index.texcoord_index = -1;
+            index.normal_index = -1;
+
+            if (p < end && *p == '/')
+            {
+                ++p;
+                if (p < end && *p != '/')
+                {
+                    p = parseInt(p, end, raw);
+                    index.texcoord_index = resolveIndex(raw, texcoordCount, RELATIVE_TEXCOORD, relative);
+                }
+                if (p < end && *p == '/')
+                {
+                    ++p;
+                    p = parseInt(p, end, raw);
+                    index.normal_index = resolveIndex(raw, normalCount, RELATIVE_NORMAL, relative);
+                }
+            }
+
+            polygon.push_back(index);
+            polygonRelative.push_back(relative);
+
+            while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+            {
+                ++p; // Skip anything unexpected up to the next vertex
+            }
+        }
+
+        if (polygon.size() < 3)
+        {
+            return; // Degenerate face, tinyobj drops it too
+        }
+
+        // Quads are split later, the diagonal depends on positions that may live in other chunks
+        chunk.indices.insert(chunk.indices.end(), polygon.begin(), polygon.end());
+        chunk.relative.insert(chunk.relative.end(), polygonRelative.begin(), polygonRelative.end());
+        chunk.faceSizes.push_back(static_cast<int>(polygon.size()));
+        chunk.materialTokens.push_back(chunk.lastMaterialToken);
+        chunk.triangleCount += polygon.size() - 2;
+    }
+
+    // Same split as tinyobjloader - quads along the shorter diagonal, larger polygons as a fan
+    size_t triangulate(const tinyobj::index_t *polygon, int size, const std::vector<tinyobj::real_t> &positions, tinyobj::index_t *out)
+    {
+        if (size == 4)
+        {
+            size_t v[4];
+            bool valid = true;
+            for (int k = 0; k < 4; ++k)
+            {
+                v[k] = static_cast<size_t>(polygon[k].vertex_index);
+                valid = valid && 3 * v[k] + 2 < positions.size();
+            }
+
+            if (valid)
+            {
+                float sqr02 = 0.0f, sqr13 = 0.0f;
+                for (int c = 0; c < 3; ++c)
+                {
+                    float e02 = positions[3 * v[2] + c] - positions[3 * v[0] + c];
+                    float e13 = positions[3 * v[3] + c] - positions[3 * v[1] + c];
+                    sqr02 += e02 * e02;
+                    sqr13 += e13 * e13;
+                }
+
+                static const int split02[6] = {0, 1, 2, 0, 2, 3};
+                static const int split13[6] = {0, 1, 3, 1, 2, 3};
+                const int *corners = sqr02 < sqr13 ? split02 : split13;
+                for (int k = 0; k < 6; ++k)
+                {
+                    out[k] = polygon[corners[k]];
+                }
+                return 2;
+            }
+        }
+
+        for (int k = 1; k + 1 < size; ++k)
+        {
+            out[0] = polygon[0];
+            out[1] = polygon[k];
+            out[2] = polygon[k + 1];
+            out += 3;
+        }
+        return static_cast<size_t>(size - 2);
+    }
+
+    void parseChunk(ObjChunk &chunk)
+    {
+        std::vector<tinyobj::index_t> polygon;
+        std::vector<unsigned char> polygonRelative;
+
+        const char *p = chunk.begin;
+        while (p < chunk.end)
+        {
+            const char *lineEnd = static_cast<const char *>(memchr(p, '\n', chunk.end - p));
+            if (lineEnd == nullptr)
+            {
+                lineEnd = chunk.end;
+            }
+
+            const char *q = skipSpaces(p, lineEnd);
+            size_t length = lineEnd - q;
+
+            if (length >= 2 && q[0] == 'v' && (q[1] == ' ' || q[1] == '\t'))
+            {
+                float x, y, z;
+                q = parseFloat(q + 2, lineEnd, x);
+                q = parseFloat(q, lineEnd, y);
+                parseFloat(q, lineEnd, z);
+                chunk.positions.insert(chunk.positions.end(), {x, y, z});
+            }
+            else if (length >= 3 && q[0] == 'v' && q[1] == 'n' && (q[2] == ' ' || q[2] == '\t'))
+            {
+                float x, y, z;
+                q = parseFloat(q + 3, lineEnd, x);
+                q = parseFloat(q, lineEnd, y);
+                parseFloat(q, lineEnd, z);
+                chunk.normals.insert(chunk.normals.end(), {x, y, z});
+            }
+            else if (length >= 3 && q[0] == 'v' && q[1] == 't' && (q[2] == ' ' || q[2] == '\t'))
+            {
+                float u, v = 0.0f;
+                q = parseFloat(q + 3, lineEnd, u);
+                if (!isLineEnd(skipSpaces(q, lineEnd), lineEnd))
+                {
+                    parseFloat(q, lineEnd, v);
+                }
+                chunk.texcoords.insert(chunk.texcoords.end(), {u, v});
+            }
+            else if (length >= 2 && q[0] == 'f' && (q[1] == ' ' || q[1] == '\t'))
+            {
+                parseFace(chunk, q + 2, lineEnd, polygon, polygonRelative);
+            }
+            else if (length >= 7 && strncmp(q, "usemtl", 6) == 0 && (q[6] == ' ' || q[6] == '\t'))
+            {
+                chunk.materialNames.push_back(readName(q + 7, lineEnd));
+                chunk.lastMaterialToken = static_cast<int>(chunk.materialNames.size()) - 1;
+            }
+            else if (length >= 7 && strncmp(q, "mtllib", 6) == 0 && (q[6] == ' ' || q[6] == '\t'))
+            {
+                chunk.mtllibs.push_back(readName(q + 7, lineEnd));
+            }
+
+            p = lineEnd + 1;
+        }
+    }
+
+    void loadMaterials(const std::vector<std::string> &mtllibs, const char *mtlBaseDir, std::map<std::string, int> &materialMap,
+                       std::vector<tinyobj::material_t> *materials, std::string *warn, std::string *err)
+    {
+        for (const std::string &line : mtllibs)
+        {
+            // One mtllib line may list several files, the first one that opens is used
+            size_t start = 0;
+            bool loaded = false;
+            while (!loaded && start < line.size())
+            {
+                size_t stop = line.find_first_of(" \t", start);
+                std::string name = line.substr(start, stop == std::string::npos ? std::string::npos : stop - start);
+                start = stop == std::string::npos ? line.size() : stop + 1;
+                if (name.empty())
+                {
+                    continue;
+                }
+
+                std::ifstream stream(std::string(mtlBaseDir ? mtlBaseDir : "") + name);
+                if (!stream)
+                {
+                    if (warn)
+                    {
+                        *warn += "Material file [ " + name + " ] not found.\n";
+                    }
+                    continue;
+                }
+                tinyobj::LoadMtl(&materialMap, materials, &stream, warn, err);
+                loaded = true;
+            }
+        }
+    }
+}
+
+bool loadObjParallel(tinyobj::attrib_t *attrib, std::vector<tinyobj::shape_t> *shapes, std::vector<tinyobj::material_t> *materials,
+                     std::string *warn, std::string *err, const char *filename, const char *mtlBaseDir)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        if (err)
+        {
+            *err += "Cannot open file [" + std::string(filename) + "]\n";
+        }
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(fd);
+        if (err)
+        {
+            *err += "Empty or unreadable file [" + std::string(filename) + "]\n";
+        }
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(fileStat.st_size);
+    void *mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        if (err)
+        {
+            *err += "Cannot map file [" + std::string(filename) + "]\n";
+        }
+        return false;
+    }
+    madvise(mapping, fileSize, MADV_WILLNEED);
+
+    const char *data = static_cast<const char *>(mapping);
+    const char *dataEnd = data + fileSize;
+
+    // Split into line-aligned chunks, a few per thread so uneven chunks even out
+    ThreadPool &pool = ThreadPool::instance();
+    size_t chunkCount = fileSize / OBJ_MIN_CHUNK_SIZE + 1;
+    if (chunkCount > pool.getThreadCount() * 4)
+    {
+        chunkCount = pool.getThreadCount() * 4;
+    }
+
+    std::vector<ObjChunk> chunks;
+    const char *chunkBegin = data;
+    for (size_t i = 1; i <= chunkCount && chunkBegin < dataEnd; ++i)
+    {
+        const char *chunkEnd = i == chunkCount ? dataEnd : data + fileSize * i / chunkCount;
+        if (chunkEnd < chunkBegin)
+        {
+            chunkEnd = chunkBegin;
+        }
+        const char *newline = static_cast<const char *>(memchr(chunkEnd, '\n', dataEnd - chunkEnd));
+        chunkEnd = newline ? newline + 1 : dataEnd;
+
+        chunks.emplace_back();
+        chunks.back().begin = chunkBegin;
+        chunks.back().end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    pool.parallelFor(chunks.size(), [&](size_t i)
+                     { parseChunk(chunks[i]); });
+
+    munmap(mapping, fileSize);
+
+    // Materials are needed before usemtl names can be resolved
+    std::vector<std::string> mtllibs;
+    for (const ObjChunk &chunk : chunks)
+    {
+        mtllibs.insert(mtllibs.end(), chunk.mtllibs.begin(), chunk.mtllibs.end());
+    }
+    std::map<std::string, int> materialMap;
+    loadMaterials(mtllibs, mtlBaseDir, materialMap, materials, warn, err);
+
+    // Prefix sums give every chunk its global offsets - this is what keeps the merge deterministic
+    struct ChunkBase
+    {
+        size_t position, normal, texcoord, triangle;
+        int incomingMaterial;
+        std::vector<int> materialIds;
+    };
+    std::vector<ChunkBase> bases(chunks.size());
+    size_t positionTotal = 0, normalTotal = 0, texcoordTotal = 0, triangleTotal = 0;
+    int currentMaterial = -1;
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        bases[i].position = positionTotal;
+        bases[i].normal = normalTotal;
+        bases[i].texcoord = texcoordTotal;
+        bases[i].triangle = triangleTotal;
+        bases[i].incomingMaterial = currentMaterial;
+
+        for (const std::string &name : chunks[i].materialNames)
+        {
+            auto found = materialMap.find(name);
+            if (found == materialMap.end() && warn)
+            {
+                *warn += "material [ '" + name + "' ] not found in .mtl\n";
+            }
+            bases[i].materialIds.push_back(found == materialMap.end() ? -1 : found->second);
+        }
+        if (chunks[i].lastMaterialToken != INHERIT_MATERIAL)
+        {
+            currentMaterial = bases[i].materialIds[chunks[i].lastMaterialToken];
+        }
+
+        positionTotal += chunks[i].positions.size();
+        normalTotal += chunks[i].normals.size();
+        texcoordTotal += chunks[i].texcoords.size();
+        triangleTotal += chunks[i].triangleCount;
+    }
+
+    attrib->vertices.resize(positionTotal);
+    attrib->normals.resize(normalTotal);
+    attrib->texcoords.resize(texcoordTotal);
+    attrib->colors.clear();
+
+    shapes->clear();
+    shapes->emplace_back();
+    tinyobj::mesh_t &mesh = shapes->back().mesh;
+    mesh.indices.resize(triangleTotal * 3);
+    mesh.material_ids.resize(triangleTotal);
+    mesh.num_face_vertices.assign(triangleTotal, 3);
+    mesh.smoothing_group_ids.assign(triangleTotal, 0);
+
+    pool.parallelFor(chunks.size(), [&](size_t i)
+                     {
+        const ObjChunk &chunk = chunks[i];
+        const ChunkBase &base = bases[i];
+
+        std::copy(chunk.positions.begin(), chunk.positions.end(), attrib->vertices.begin() + base.position);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), attrib->normals.begin() + base.normal);
+        std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), attrib->texcoords.begin() + base.texcoord); });
+
+    // Triangulation needs all positions in place, so it is a second pass
+    const int positionCount = static_cast<int>(positionTotal / 3);
+    const int normalCount = static_cast<int>(normalTotal / 3);
+    const int texcoordCount = static_cast<int>(texcoordTotal / 2);
+    std::vector<unsigned char> invalidChunks(chunks.size(), 0);
+    pool.parallelFor(chunks.size(), [&](size_t i)
+                     {
+        const ObjChunk &chunk = chunks[i];
+        const ChunkBase &base = bases[i];
+
+        int positionOffset = static_cast<int>(base.position / 3);
+        int normalOffset = static_cast<int>(base.normal / 3);
+        int texcoordOffset = static_cast<int>(base.texcoord / 2);
+        std::vector<tinyobj::index_t> polygon;
+        tinyobj::index_t *out = mesh.indices.data() + base.triangle * 3;
+        size_t triangle = base.triangle;
+        size_t corner = 0;
+        int material = base.incomingMaterial;
+
+        for (size_t f = 0; f < chunk.faceSizes.size(); ++f)
+        {
+            int size = chunk.faceSizes[f];
+            polygon.assign(chunk.indices.begin() + corner, chunk.indices.begin() + corner + size);
+            for (int k = 0; k < size; ++k)
+            {
+                unsigned char relative = chunk.relative[corner + k];
+                if (relative & RELATIVE_VERTEX)
+                {
+                    polygon[k].vertex_index += positionOffset;
+                }
+                if (relative & RELATIVE_TEXCOORD)
+                {
+                    polygon[k].texcoord_index += texcoordOffset;
+                }
+                if (relative & RELATIVE_NORMAL)
+                {
+                    polygon[k].normal_index += normalOffset;
+                }
+
+                // Every index is used unchecked by the mesh builder, the position is required, the others may be missing (-1)
+                if (polygon[k].vertex_index < 0 || polygon[k].vertex_index >= positionCount ||
+                    polygon[k].texcoord_index < -1 || polygon[k].texcoord_index >= texcoordCount ||
+                    polygon[k].normal_index < -1 || polygon[k].normal_index >= normalCount)
+                {
+                    invalidChunks[i] = 1;
+                    return;
+                }
+            }
+            corner += size;
+
+            if (chunk.materialTokens[f] != INHERIT_MATERIAL)
+            {
+                material = base.materialIds[chunk.materialTokens[f]];
+            }
+
+            size_t emitted = triangulate(polygon.data(), size, attrib->vertices, out);
+            out += emitted * 3;
+            for (size_t t = 0; t < emitted; ++t)
+            {
+                mesh.material_ids[triangle++] = material;
+            }
+        } });
+
+    if (std::find(invalidChunks.begin(), invalidChunks.end(), 1) != invalidChunks.end())
+    {
+        shapes->clear();
+        if (err)
+        {
+            *err += "Face index out of range in file [" + std::string(filename) + "]\n";
+        }
+        return false;
+    }
+    return true;
+}
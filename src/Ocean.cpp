@@ -9,6 +9,13 @@
  */
 
 #include "Ocean.h"
+#include "OceanKernel.h"
+#include "GLDebug.h"
+#include "Trace.h"
+#include "Timing.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <functional>
 #include <cmath>
 #include <glm/gtc/constants.hpp> // For pi
 #include <chrono>
@@ -32,7 +39,9 @@ void Ocean::updateVertices_simd(float *updatedVertices_array, float *updatedNorm
 
 Ocean::Ocean(int gridSize) : time(0.0f), gridSize(gridSize), gridSpacing(1.0f),
                              amplitude(0.8f), wavelength(10.0f), frequency(1.0f), // Adjusted amplitude slightly
-                             direction(glm::vec2(1.0f, 0.0f)), phase(0.0f)
+                             direction(glm::vec2(1.0f, 0.0f)), phase(0.0f),
+                             vertexBufferID(0), normalBufferID(0), texCoordBufferID(0), gridIndices(nullptr), vaoID(0),
+                             surfaceKernel(OCEAN_KERNEL_FIXED_POINT), surfaceThreads(1), surfaceTile(0), phasesTime(0.0f)
 {
     gerstnerWaves.push_back({1.0f, 10.0f, 1.0f, glm::normalize(glm::vec2(1.0f, 0.0f)), 0.0f});
     gerstnerWaves.push_back({0.3f, 5.0f, 2.0f, glm::normalize(glm::vec2(1.0f, 1.0f)), 0.0f});
@@ -44,15 +53,143 @@ Ocean::Ocean(int gridSize) : time(0.0f), gridSize(gridSize), gridSpacing(1.0f),
     //gerstnerWaves.push_back({0.5f, 1.2f, 2.0f, glm::normalize(glm::vec2(0.9f, 0.8f)), 0.0f});
 }
 
-#ifndef LUT_SIZE
-#define LUT_SIZE (20384 * 16)
-#endif
-
 #include <tuple>
 #include <array>
 
+std::vector<GerstnerWave> Ocean::standardWaves()
+{
+    return {
+        {1.0f, 10.0f, 1.0f, glm::normalize(glm::vec2(1.0f, 0.0f)), 0.0f},
+        {0.3f, 5.0f, 2.0f, glm::normalize(glm::vec2(1.0f, 1.0f)), 0.0f},
+        {1.0f, 3.0f, 1.0f, glm::normalize(glm::vec2(1.0f, 0.5f)), 0.0f},
+        {0.3f, 5.0f, 2.0f, glm::normalize(glm::vec2(0.5f, 0.5f)), 0.0f},
+        {1.0f, 10.0f, 1.0f, glm::normalize(glm::vec2(1.0f, 0.0f)), 0.0f},
+        {0.5f, 2.0f, 3.0f, glm::normalize(glm::vec2(1.0f, 1.0f)), 0.0f},
+        {1.0f, 1.0f, 0.2f, glm::normalize(glm::vec2(0.7f, 0.2f)), 0.0f},
+        {0.5f, 1.2f, 2.0f, glm::normalize(glm::vec2(0.9f, 0.8f)), 0.0f},
+    };
+}
+
+void Ocean::setWaves(const std::vector<GerstnerWave> &waves)
+{
+    gerstnerWaves = waves;
+    wavePhases.clear(); // Reset from time on the next step or fixed-point run
+}
+
+const char *Ocean::kernelName(OceanKernel kernel)
+{
+    static const char *const names[OCEAN_KERNEL_COUNT] = {"reference", "simd", "specialized", "jit", "fixed"};
+    return names[kernel];
+}
+
+const char *Ocean::traceZone(OceanKernel kernel)
+{
+    static const char *const zones[OCEAN_KERNEL_COUNT] = {TRACE_ZONE_OCEAN_REFERENCE, TRACE_ZONE_OCEAN_SIMD, TRACE_ZONE_OCEAN_SPECIALIZED,
+                                                          TRACE_ZONE_OCEAN_JIT, TRACE_ZONE_OCEAN_FIXED_POINT};
+    return zones[kernel];
+}
+
+bool Ocean::parseKernel(const std::string &name, OceanKernel &kernel)
+{
+    for (int candidate = 0; candidate < OCEAN_KERNEL_COUNT; ++candidate)
+    {
+        if (name == kernelName(static_cast<OceanKernel>(candidate)))
+        {
+            kernel = static_cast<OceanKernel>(candidate);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Ocean::runKernel(OceanKernel kernel)
+{
+    size_t numVertices = vertices.size();
+    switch (kernel)
+    {
+    case OCEAN_KERNEL_REFERENCE:
+        if (kernelVertices.size() != numVertices)
+        {
+            kernelVertices = vertices; // The kernel only writes y, x and z stay valid between runs
+        }
+        kernelNormals.resize(numVertices);
+        updateVertices(&kernelVertices, &kernelNormals, originalWorldX.data(), originalWorldZ.data(), gridSize, time);
+        break;
+    case OCEAN_KERNEL_SIMD:
+        kernelHeights.resize(numVertices); // Written, not accumulated
+        kernelNormalArray.resize(numVertices * 3);
+        kernelWaves.resize(gerstnerWaves.size() * 6);
+        convert_gerstner_aos_to_float_soa(gerstnerWaves, kernelWaves.data());
+        updateVertices_simd(kernelHeights.data(), kernelNormalArray.data(), numVertices, originalWorldX.data(), originalWorldZ.data(), gridSize, time,
+                            kernelWaves.data(), gerstnerWaves.size(), sin_lut.data(), cos_lut.data(), LUT_SIZE);
+        break;
+    case OCEAN_KERNEL_SPECIALIZED:
+    case OCEAN_KERNEL_JIT:
+    case OCEAN_KERNEL_FIXED_POINT:
+        kernelHeights.resize(numVertices);
+        kernelNormalArray.resize(numVertices * 3);
+        runVectorKernel(kernel, kernelHeights.data(), kernelNormalArray.data());
+        break;
+    default:
+        break;
+    }
+}
+
+void Ocean::setSurfaceThreading(unsigned threads, size_t tileVertices)
+{
+    surfaceThreads = threads > 0 ? threads : 1;
+    surfaceTile = (tileVertices + 7) / 8 * 8; // Tiles start on whole blocks
+}
+
+void Ocean::runVectorKernel(OceanKernel kernel, float *heights, float *normals)
+{
+    size_t numVertices = vertices.size();
+    OceanKernelArgs args = {originalWorldX.data(), originalWorldZ.data(), heights, normals,
+                            numVertices, sin_lut.data(), cos_lut.data(), LUT_SIZE};
+    size_t waveCount = gerstnerWaves.size();
+
+    // Per-call terms once, then the vertex loop over tiles
+    std::function<void(size_t, size_t)> runRange;
+    std::vector<WaveTerms> terms;
+    std::vector<FixedWaveTerms> fixedTerms;
+    OceanLattice lattice = {static_cast<size_t>(gridSize), -gridSize / 2.0f * gridSpacing, -gridSize / 2.0f * gridSpacing, gridSpacing};
+    switch (kernel)
+    {
+    case OCEAN_KERNEL_JIT:
+        jit.setTime(gerstnerWaves.data(), waveCount, time, sin_lut.data(), LUT_SIZE);
+        runRange = [&](size_t begin, size_t end) { jit.run(args, begin, end); };
+        break;
+    case OCEAN_KERNEL_FIXED_POINT:
+        syncPhases();
+        args.sinLut = phase_sin_lut.data();
+        args.cosLut = phase_cos_lut.data();
+        args.lutSize = PHASE_LUT_SIZE;
+        fixedTerms.resize(waveCount);
+        OceanKernels::computeFixedWaveTerms(gerstnerWaves.data(), waveCount, wavePhases.data(), lattice, phase_sin_lut.data(), fixedTerms.data());
+        runRange = [&](size_t begin, size_t end) { OceanKernels::runFixed(args, lattice, fixedTerms.data(), waveCount, begin, end); };
+        break;
+    default:
+        terms.resize(waveCount);
+        OceanKernels::computeWaveTerms(gerstnerWaves.data(), waveCount, time, sin_lut.data(), LUT_SIZE, terms.data());
+        runRange = [&](size_t begin, size_t end) { OceanKernels::select(waveCount)(args, terms.data(), waveCount, begin, end); };
+        break;
+    }
+
+    size_t tile = surfaceThreads > 1 && surfaceTile > 0 ? surfaceTile : numVertices;
+    size_t tiles = tile > 0 ? (numVertices + tile - 1) / tile : 0;
+    if (tiles <= 1)
+    {
+        runRange(0, numVertices);
+        return;
+    }
+    ThreadPool::instance().parallelFor(tiles, surfaceThreads, [&](size_t index)
+                                       { runRange(index * tile, std::min(numVertices, (index + 1) * tile)); });
+}
+
 std::array<float, LUT_SIZE> sin_lut;
 std::array<float, LUT_SIZE> cos_lut;
+std::array<float, PHASE_LUT_SIZE> phase_sin_lut;
+std::array<float, PHASE_LUT_SIZE> phase_cos_lut;
 
 void initializeSinCosLUT()
 {
@@ -64,14 +201,29 @@ void initializeSinCosLUT()
         sin_lut[i] = std::sin(angle);
         cos_lut[i] = std::cos(angle);
     }
+
+    for (size_t i = 0; i < PHASE_LUT_SIZE; ++i)
+    {
+        double angle = i * (2.0 * M_PI / PHASE_LUT_SIZE);
+        phase_sin_lut[i] = static_cast<float>(std::sin(angle));
+        phase_cos_lut[i] = static_cast<float>(std::cos(angle));
+    }
 }
 
 bool Ocean::init()
 {
-    generateGrid();
+    if (!generate())
+    {
+        return false;
+    }
     createBuffers(); // Create VBOs and IBO
-    initializeSinCosLUT();
+    return true;
+}
 
+bool Ocean::generate()
+{
+    generateGrid();
+    initializeSinCosLUT();
     return true;
 }
 
@@ -117,7 +269,11 @@ void float_array_to_verts(const float *arr, float *dst, size_t size)
 
 void Ocean::update(float deltaTime)
 {
+    // Advanced whatever kernel draws, so the boat floats on the same phases after a kernel switch
+    syncPhases();
     time += deltaTime;
+    OceanKernels::advancePhases(gerstnerWaves.data(), gerstnerWaves.size(), deltaTime, wavePhases.data());
+    phasesTime = time;
     std::vector<glm::vec3> updatedVertices_vec = vertices;      // Create a copy to update (vector version)
     std::vector<glm::vec3> updatedNormals_vec(vertices.size()); // Vector to store updated normals (vector version)
 
@@ -128,18 +284,14 @@ void Ocean::update(float deltaTime)
     size_t numVertices = vertices.size();
     size_t floatArraySize = numVertices * 3;
 
-    // Reference C++ part
-    auto start_time = std::chrono::high_resolution_clock::now();
-    uint64_t start = rdtsc();
-    // --- Call C++ version for comparison (using vector) ---
-    // updateVertices(&updatedVertices_vec, &updatedNormals_vec, time);
-    updateVertices(&updatedVertices_vec, &updatedNormals_vec, originalWorldX.data(), originalWorldZ.data(), gridSize, time);
-    //updateBuffers(updatedVertices_vec, updatedNormals_vec); // Use vectors for updateBuffers
-    uint64_t end = rdtsc();
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
-
-    std::cout << "Ocean::update        took " << duration.count() << "ns " << "CPU cycles: " << (end - start) << "\n";
+    // Reference C++ part, timed by the trace (--trace) instead of printing every frame
+    {
+        TRACE_SCOPE(TRACE_ZONE_OCEAN_REFERENCE);
+        // --- Call C++ version for comparison (using vector) ---
+        // updateVertices(&updatedVertices_vec, &updatedNormals_vec, time);
+        updateVertices(&updatedVertices_vec, &updatedNormals_vec, originalWorldX.data(), originalWorldZ.data(), gridSize, time);
+        //updateBuffers(updatedVertices_vec, updatedNormals_vec); // Use vectors for updateBuffers
+    }
     // End Reference C++ part
 
     // own C++ re-implementationto better understand the algorithm and locate redundant calculations
@@ -149,19 +301,15 @@ void Ocean::update(float deltaTime)
     float verts_y_own[numVertices];
     convert_verts_y_to_float_array(o_updatedVertices_vec, verts_y_own);
 
-    start_time = std::chrono::high_resolution_clock::now();
-    start = rdtsc();
-
-    own_cpp_updateVertices(verts_y_own, &o_updatedNormals_vec, originalWorldX.data(), originalWorldZ.data(), gridSize, time);
-    end = rdtsc();
-    end_time = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    {
+        TRACE_SCOPE("Ocean::update own");
+        own_cpp_updateVertices(verts_y_own, &o_updatedNormals_vec, originalWorldX.data(), originalWorldZ.data(), gridSize, time);
+    }
 
     for (size_t i = 0; i < o_updatedVertices_vec.size(); i++)
     {
         o_updatedVertices_vec.at(i).y = verts_y_own[i];
     }
-    std::cout << "Ocean::update (own)  took " << duration.count() << "ns " << "CPU cycles: " << (end - start) << "\n";
     // end own
 
     // Start SIMD part
@@ -184,17 +332,20 @@ void Ocean::update(float deltaTime)
     float verts_y[numVertices];
     convert_verts_y_to_float_array(updatedVertices_simd_vec, verts_y);
 
-    start_time = std::chrono::high_resolution_clock::now();
-    start = rdtsc();
-
-    updateVertices_simd(verts_y, updatedNormals_simd_array, numVertices, originalWorldX.data(), originalWorldZ.data(), gridSize, time, converted_waves, num_waves, sin_lut.data(), cos_lut.data(), LUT_SIZE);
-    end = rdtsc();
+    // The SIMD zone is the assembly kernel alone, the others are traced under their own name
+    if (surfaceKernel == OCEAN_KERNEL_SIMD)
+    {
+        TRACE_SCOPE(TRACE_ZONE_OCEAN_SIMD);
+        LATENCY_SCOPE("Ocean kernel");
+        updateVertices_simd(verts_y, updatedNormals_simd_array, numVertices, originalWorldX.data(), originalWorldZ.data(), gridSize, time, converted_waves, num_waves, sin_lut.data(), cos_lut.data(), LUT_SIZE);
+    }
+    else
+    {
+        TRACE_SCOPE(traceZone(surfaceKernel));
+        LATENCY_SCOPE("Ocean kernel");
+        runVectorKernel(surfaceKernel, verts_y, updatedNormals_simd_array);
+    }
     float_array_to_verts(verts_y, updatedVertices_simd_array, numVertices);
-
-    end_time = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
-
-    std::cout << "Ocean::update (SIMD) took  " << duration.count() << "ns " << "CPU cycles: " << (end - start) << std::endl;
     
     // --- Convert float arrays back to vectors for updateBuffers (if needed) ---
     std::vector<glm::vec3> updatedVertices_vec_from_array(numVertices);
@@ -207,7 +358,13 @@ void Ocean::update(float deltaTime)
     // THIS FUNCTION UPDATES THE VERTICES AND NORMALS. If updateVertices_simd doesn't work,
     // the surface will remain flat. Uncomment this after implementing the update logic.
 
-    updateBuffers(updatedVertices_vec_from_array, updatedNormals_vec_from_array); // Use vectors for updateBuffers
+    if (vaoID != 0) // No buffers in headless runs
+    {
+        LATENCY_SCOPE("Ocean upload");
+        updateBuffers(updatedVertices_vec_from_array, updatedNormals_vec_from_array); // Use vectors for updateBuffers
+    }
+    surfaceVertices.swap(updatedVertices_vec_from_array); // Kept for the debug lines, no copy
+    surfaceNormals.swap(updatedNormals_vec_from_array);
 
     // End SIMD part
 
@@ -271,13 +428,19 @@ float Ocean::getGerstnerWaveHeight(const GerstnerWave &wave, float x, float z, f
 {
     float k = 2.0f * glm::pi<float>() / wave.wavelength;
     float w = wave.speed * k;
+    return getGerstnerWaveHeight(wave, x, z, w * time, 2.0f * glm::pi<float>() * time / wave.wavelength);
+}
+
+float Ocean::getGerstnerWaveHeight(const GerstnerWave &wave, float x, float z, float travel, float swell) const
+{
+    float k = 2.0f * glm::pi<float>() / wave.wavelength;
     float dotProduct = glm::dot(wave.direction, glm::vec2(x, z));
-    float periodicAmplitude = wave.amplitude * 0.5f * (1.0f + sin(2.0f * glm::pi<float>() * time / wave.wavelength));
-    float waveHeightValue = periodicAmplitude * sin(k * dotProduct - w * time + wave.phase);
+    float periodicAmplitude = wave.amplitude * 0.5f * (1.0f + sin(swell));
+    float waveHeightValue = periodicAmplitude * sin(k * dotProduct - travel + wave.phase);
 
     if (fabs(x) < 0.5f && fabs(z) < 0.5f)
     {
-        // std::cout << "  getGerstnerWaveHeight - time: " << time << ", periodicAmplitude: " << periodicAmplitude << ", waveHeightValue: " << waveHeightValue << std::endl;
+        // std::cout << "  getGerstnerWaveHeight - swell: " << swell << ", periodicAmplitude: " << periodicAmplitude << ", waveHeightValue: " << waveHeightValue << std::endl;
     }
 
     return waveHeightValue;
@@ -304,26 +467,84 @@ glm::vec3 Ocean::getWaveNormal(float x, float z, float time) const
     {
         float k = 2.0f * glm::pi<float>() / wave.wavelength;
         float w = wave.speed * k;
-        float dotProduct = glm::dot(wave.direction, glm::vec2(x, z));
-        float sinTerm = sin(k * dotProduct - w * time + wave.phase);
-        float cosTerm = cos(k * dotProduct - w * time + wave.phase);
-        float periodicAmplitude = wave.amplitude * 0.5f * (1.0f + sin(2.0f * glm::pi<float>() * time / wave.wavelength));
-        float modulatedAmplitude = periodicAmplitude;
-
-        // Calculate tangent vectors for EACH wave component and ACCUMULATE them directly
-        tangentX += glm::vec3(
-            -modulatedAmplitude * wave.direction.x * wave.direction.x * k * sinTerm, // dx_dx
-            modulatedAmplitude * wave.direction.x * k * cosTerm,                     // dy_dx
-            -modulatedAmplitude * wave.direction.x * wave.direction.y * k * sinTerm  // dz_dx
-        );
-
-        tangentZ += glm::vec3(
-            -modulatedAmplitude * wave.direction.x * wave.direction.y * k * sinTerm, // dx_dz
-            modulatedAmplitude * wave.direction.y * k * cosTerm,                     // dy_dz
-            -modulatedAmplitude * wave.direction.y * wave.direction.y * k * sinTerm  // dz_dz
-        );
+        addGerstnerWaveTangents(wave, x, z, w * time, 2.0f * glm::pi<float>() * time / wave.wavelength, tangentX, tangentZ);
+    }
+
+    return glm::normalize(glm::cross(tangentZ, tangentX));
+}
+
+void Ocean::addGerstnerWaveTangents(const GerstnerWave &wave, float x, float z, float travel, float swell, glm::vec3 &tangentX, glm::vec3 &tangentZ) const
+{
+    float k = 2.0f * glm::pi<float>() / wave.wavelength;
+    float dotProduct = glm::dot(wave.direction, glm::vec2(x, z));
+    float sinTerm = sin(k * dotProduct - travel + wave.phase);
+    float cosTerm = cos(k * dotProduct - travel + wave.phase);
+    float periodicAmplitude = wave.amplitude * 0.5f * (1.0f + sin(swell));
+    float modulatedAmplitude = periodicAmplitude;
+
+    // Calculate tangent vectors for EACH wave component and ACCUMULATE them directly
+    tangentX += glm::vec3(
+        -modulatedAmplitude * wave.direction.x * wave.direction.x * k * sinTerm, // dx_dx
+        modulatedAmplitude * wave.direction.x * k * cosTerm,                     // dy_dx
+        -modulatedAmplitude * wave.direction.x * wave.direction.y * k * sinTerm  // dz_dx
+    );
+
+    tangentZ += glm::vec3(
+        -modulatedAmplitude * wave.direction.x * wave.direction.y * k * sinTerm, // dx_dz
+        modulatedAmplitude * wave.direction.y * k * cosTerm,                     // dy_dz
+        -modulatedAmplitude * wave.direction.y * wave.direction.y * k * sinTerm  // dz_dz
+    );
+}
+
+void Ocean::syncPhases()
+{
+    if (phasesTime != time || wavePhases.size() != gerstnerWaves.size()) // time was set from outside or the waves changed
+    {
+        wavePhases.resize(gerstnerWaves.size());
+        OceanKernels::resetPhases(gerstnerWaves.data(), gerstnerWaves.size(), time, wavePhases.data());
+        phasesTime = time;
     }
+}
+
+void Ocean::getSurfaceAngles(size_t wave, float &travel, float &swell) const
+{
+    const GerstnerWave &gerstner = gerstnerWaves[wave];
+    if (phasesTime == time && wavePhases.size() == gerstnerWaves.size())
+    {
+        // The phases hold speed * time / wavelength and time / wavelength in turns (2^64 each), exact where
+        // the float time has lost its fraction
+        const double turnsToRadians = 2.0 * glm::pi<double>() / 18446744073709551616.0;
+        travel = static_cast<float>(static_cast<double>(wavePhases[wave].travel) * turnsToRadians);
+        swell = static_cast<float>(static_cast<double>(wavePhases[wave].swell) * turnsToRadians);
+        return;
+    }
+    float k = 2.0f * glm::pi<float>() / gerstner.wavelength;
+    travel = gerstner.speed * k * time;
+    swell = 2.0f * glm::pi<float>() * time / gerstner.wavelength;
+}
+
+float Ocean::getSurfaceHeight(float x, float z) const
+{
+    float totalHeight = 0.0f;
+    for (size_t i = 0; i < gerstnerWaves.size(); ++i)
+    {
+        float travel, swell;
+        getSurfaceAngles(i, travel, swell);
+        totalHeight += getGerstnerWaveHeight(gerstnerWaves[i], x, z, travel, swell);
+    }
+    return totalHeight;
+}
 
+glm::vec3 Ocean::getSurfaceNormal(float x, float z) const
+{
+    glm::vec3 tangentX = glm::vec3(1.0f, 0.0f, 0.0f);
+    glm::vec3 tangentZ = glm::vec3(0.0f, 0.0f, 1.0f);
+    for (size_t i = 0; i < gerstnerWaves.size(); ++i)
+    {
+        float travel, swell;
+        getSurfaceAngles(i, travel, swell);
+        addGerstnerWaveTangents(gerstnerWaves[i], x, z, travel, swell, tangentX, tangentZ);
+    }
     return glm::normalize(glm::cross(tangentZ, tangentX));
 }
 
@@ -351,7 +572,10 @@ void Ocean::setGridSize(int newGridSize)
 
     updateVertices(&updatedVertices, &updatedNormals, originalWorldX.data(), originalWorldZ.data(), gridSize, time);
 
-    updateBuffers(updatedVertices, updatedNormals);
+    if (vaoID != 0)
+    {
+        updateBuffers(updatedVertices, updatedNormals);
+    }
     // updateVertices(); // Re-update vertices based on waves (optional, if needed immediately)
 }
 
@@ -362,7 +586,7 @@ GLuint Ocean::getVAO() const
 
 GLuint Ocean::getIndexCount() const
 {
-    return indexCount;
+    return gridIndices ? gridIndices->indexCount : 0;
 }
 
 int Ocean::getGridIndex(int x, int z) const
@@ -372,41 +596,27 @@ int Ocean::getGridIndex(int x, int z) const
 
 void Ocean::createBuffers()
 {
+    GL_DEBUG_SCOPE("Ocean::createBuffers");
     glGenVertexArrays(1, &vaoID);
-    checkGLError("glGenVertexArrays"); // Check after glGenVertexArrays
     glBindVertexArray(vaoID);
-    checkGLError("glBindVertexArray"); // Check after glBindVertexArray
 
     // Generate VBOs
     glGenBuffers(1, &vertexBufferID);
-    checkGLError("glGenBuffers - vertexBufferID"); // Check after glGenBuffers
     glGenBuffers(1, &normalBufferID);
-    checkGLError("glGenBuffers - normalBufferID"); // Check after glGenBuffers
     glGenBuffers(1, &texCoordBufferID);
-    checkGLError("glGenBuffers - texCoordBufferID"); // Check after glGenBuffers
-    glGenBuffers(1, &indexBufferID);
-    checkGLError("glGenBuffers - indexBufferID"); // Check after glGenBuffers
 
     // 1. Vertex Positions VBO
     glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
-    checkGLError("glBindBuffer - vertexBufferID"); // Check after glBindBuffer
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_DYNAMIC_DRAW);
-    checkGLError("glBufferData - vertexBufferID"); // Check after glBufferData
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    checkGLError("glVertexAttribPointer - vertexBufferID"); // Check after glVertexAttribPointer
     glEnableVertexAttribArray(0);
-    checkGLError("glEnableVertexAttribArray - location 0"); // Check after glEnableVertexAttribArray
 
     // 2. Vertex Normals VBO (initially flat normals - updated in updateVertices/updateBuffers)
     std::vector<glm::vec3> normals(vertices.size(), glm::vec3(0.0f, 1.0f, 0.0f)); // Initialize with flat normals
     glBindBuffer(GL_ARRAY_BUFFER, normalBufferID);
-    checkGLError("glBindBuffer - normalBufferID"); // Check after glBindBuffer
     glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_DYNAMIC_DRAW);
-    checkGLError("glBufferData - normalBufferID"); // Check after glBufferData
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    checkGLError("glVertexAttribPointer - normalBufferID"); // Check after glVertexAttribPointer
     glEnableVertexAttribArray(1);
-    checkGLError("glEnableVertexAttribArray - location 1"); // Check after glEnableVertexAttribArray
 
     // 3. Texture Coordinates VBO
     std::vector<glm::vec2> texCoords(vertices.size());
@@ -420,39 +630,17 @@ void Ocean::createBuffers()
         }
     }
     glBindBuffer(GL_ARRAY_BUFFER, texCoordBufferID);
-    checkGLError("glBindBuffer - texCoordBufferID"); // Check after glBindBuffer
     glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
-    checkGLError("glBufferData - texCoordBufferID"); // Check after glBufferData
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
-    checkGLError("glVertexAttribPointer - texCoordBufferID"); // Check after glVertexAttribPointer
     glEnableVertexAttribArray(2);
-    checkGLError("glEnableVertexAttribArray - location 2"); // Check after glEnableVertexAttribArray
 
-    // 4. Index Buffer Object (IBO) for Quads
-    std::vector<unsigned int> indices;
-    for (int x = 0; x < gridSize - 1; ++x)
-    {
-        for (int z = 0; z < gridSize - 1; ++z)
-        {
-            unsigned int v00 = x * gridSize + z;
-            unsigned int v10 = (x + 1) * gridSize + z;
-            unsigned int v11 = (x + 1) * gridSize + (z + 1);
-            unsigned int v01 = x * gridSize + (z + 1);
-            indices.insert(indices.end(), {v00, v10, v11, v01}); // Quad indices (counter-clockwise)
-        }
-    }
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
-    checkGLError("glBindBuffer - indexBufferID"); // Check after glBindBuffer
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-    checkGLError("glBufferData - indexBufferID"); // Check after glBufferData
+    // 4. Index Buffer Object (IBO) - triangle strips shared with every grid of this size
+    gridIndices = acquireGridIndexBuffer(gridSize, gridSize, false);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gridIndices->bufferID);
 
     glBindVertexArray(0);                                   // Unbind VAO
-    checkGLError("glBindVertexArray(0)");                   // Check after unbinding VAO
     glBindBuffer(GL_ARRAY_BUFFER, 0);                       // Unbind VBO - Optional, VAO unbinding often unbinds VBOs
-    checkGLError("glBindBuffer(0) - ARRAY_BUFFER");         // Check after unbinding ARRAY_BUFFER
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);               // Unbind IBO - Optional, VAO unbinding often unbinds IBO
-    checkGLError("glBindBuffer(0) - ELEMENT_ARRAY_BUFFER"); // Check after unbinding ELEMENT_ARRAY_BUFFER
-    indexCount = indices.size();                            // Store index count for rendering
 }
 
 Ocean::~Ocean()
@@ -462,17 +650,24 @@ Ocean::~Ocean()
 
 void Ocean::cleanup()
 {
+    if (vaoID == 0) // Never created (headless) or already released, GL may not even be loaded
+    {
+        return;
+    }
     // No dynamic memory allocation in this simple version
     // Release OpenGL resources (VBOs, IBO, VAO)
     glDeleteBuffers(1, &vertexBufferID);
     glDeleteBuffers(1, &normalBufferID);
     glDeleteBuffers(1, &texCoordBufferID);
-    glDeleteBuffers(1, &indexBufferID);
     glDeleteVertexArrays(1, &vaoID);
+    if (gridIndices != nullptr)
+    {
+        releaseGridIndexBuffer(gridIndices);
+    }
     vertexBufferID = 0;
     normalBufferID = 0;
     texCoordBufferID = 0;
-    indexBufferID = 0;
+    gridIndices = nullptr;
     vaoID = 0;
 }
 
@@ -0,0 +1,402 @@
+/*
+ * File:        OceanJit.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Run-time x86-64 code generation of the ocean kernel for the current waves
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "OceanJit.h"
+#include "Ocean.h"
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Constant page, 32-byte splats of one float each
+#define JIT_CONST_LUT_SCALE 0 // lutSize - 1
+#define JIT_CONST_ONE 1
+#define JIT_CONST_WAVES 2     // Then JIT_TERMS_PER_WAVE per wave, in WaveTerms order, kx kz offset in turns
+#define JIT_TERMS_PER_WAVE 9
+
+namespace
+{
+    enum Gpr
+    {
+        RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11
+    };
+
+    // VEX opcode maps and implied prefixes
+    enum VexMap
+    {
+        MAP_0F = 1,
+        MAP_0F38 = 2,
+        MAP_0F3A = 3
+    };
+    enum VexPrefix
+    {
+        PP_NONE = 0,
+        PP_66 = 1
+    };
+
+    struct Memory
+    {
+        int base;     // Gpr, -1 for RIP-relative
+        int index;    // Gpr or ymm (VSIB), -1 for none
+        int scale;    // log2
+        int32_t displacement;
+        int constant; // Constant page entry when base is -1
+    };
+
+    Memory at(int base, int32_t displacement = 0) { return {base, -1, 0, displacement, -1}; }
+    Memory indexed(int base, int index, int scale = 0) { return {base, index, scale, 0, -1}; }
+    Memory constant(int entry) { return {-1, -1, 0, 0, entry}; }
+
+    // Just the instructions the kernel needs; VEX is always the three-byte form
+    class Emitter
+    {
+    public:
+        std::vector<uint8_t> code;
+
+        struct Fixup
+        {
+            size_t position; // Of the disp32
+            int constant;
+        };
+        std::vector<Fixup> fixups;
+
+        void bytes(std::initializer_list<uint8_t> values) { code.insert(code.end(), values); }
+        void imm8(uint8_t value) { code.push_back(value); }
+
+        void vex(VexMap map, VexPrefix prefix, bool w, uint8_t opcode, int reg, int vvvv, int rm)
+        {
+            prefixVex(map, prefix, w, reg, vvvv, 0, rm);
+            code.push_back(opcode);
+            code.push_back(static_cast<uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+        }
+
+        void vex(VexMap map, VexPrefix prefix, bool w, uint8_t opcode, int reg, int vvvv, const Memory &memory)
+        {
+            prefixVex(map, prefix, w, reg, vvvv, memory.index < 0 ? 0 : memory.index, memory.base < 0 ? 0 : memory.base);
+            code.push_back(opcode);
+            modrm(reg, memory);
+        }
+
+        // Register-only ops on ymm, e.g. vmulps dst, a, b
+        void op(uint8_t opcode, int dst, int a, int b) { vex(MAP_0F, PP_NONE, false, opcode, dst, a, b); }
+        void op(uint8_t opcode, int dst, int a, const Memory &b) { vex(MAP_0F, PP_NONE, false, opcode, dst, a, b); }
+        void fma(uint8_t opcode, int dst, int a, int b) { vex(MAP_0F38, PP_66, false, opcode, dst, a, b); }
+        void fma(uint8_t opcode, int dst, int a, const Memory &b) { vex(MAP_0F38, PP_66, false, opcode, dst, a, b); }
+
+        void label(size_t &position) { position = code.size(); }
+
+        // Jcc rel32 to an earlier position
+        void jumpBack(uint8_t condition, size_t target)
+        {
+            bytes({0x0F, condition});
+            int32_t relative = static_cast<int32_t>(target - (code.size() + 4));
+            append32(relative);
+        }
+
+        // Jcc rel32 forward, patched by land
+        size_t jumpForward(uint8_t condition)
+        {
+            bytes({0x0F, condition});
+            append32(0);
+            return code.size() - 4;
+        }
+
+        void land(size_t jump)
+        {
+            int32_t relative = static_cast<int32_t>(code.size() - (jump + 4));
+            std::memcpy(&code[jump], &relative, 4);
+        }
+
+    private:
+        void prefixVex(VexMap map, VexPrefix prefix, bool w, int reg, int vvvv, int index, int base)
+        {
+            code.push_back(0xC4);
+            code.push_back(static_cast<uint8_t>(((~reg >> 3) & 1) << 7 | ((~index >> 3) & 1) << 6 | ((~base >> 3) & 1) << 5 | map));
+            code.push_back(static_cast<uint8_t>((w ? 0x80 : 0) | ((~vvvv & 15) << 3) | 0x04 | prefix)); // L = 256
+        }
+
+        void modrm(int reg, const Memory &memory)
+        {
+            if (memory.base < 0)
+            {
+                code.push_back(static_cast<uint8_t>(((reg & 7) << 3) | 5)); // [rip + disp32]
+                fixups.push_back({code.size(), memory.constant});
+                append32(0);
+                return;
+            }
+            int mod = memory.displacement == 0 && (memory.base & 7) != RBP ? 0 : (memory.displacement >= -128 && memory.displacement < 128 ? 1 : 2);
+            bool sib = memory.index >= 0 || (memory.base & 7) == RSP;
+            code.push_back(static_cast<uint8_t>((mod << 6) | ((reg & 7) << 3) | (sib ? 4 : (memory.base & 7))));
+            if (sib)
+            {
+                int index = memory.index >= 0 ? (memory.index & 7) : 4; // 4 = no index
+                code.push_back(static_cast<uint8_t>((memory.scale << 6) | (index << 3) | (memory.base & 7)));
+            }
+            if (mod == 1)
+            {
+                code.push_back(static_cast<uint8_t>(memory.displacement));
+            }
+            else if (mod == 2)
+            {
+                append32(memory.displacement);
+            }
+        }
+
+        void append32(int32_t value)
+        {
+            uint8_t raw[4];
+            std::memcpy(raw, &value, 4);
+            code.insert(code.end(), raw, raw + 4);
+        }
+    };
+
+    // Opcodes (map 0F unless noted)
+    const uint8_t VMOVUPS_LOAD = 0x10, VMOVUPS_STORE = 0x11, VUNPCKLPS = 0x14, VUNPCKHPS = 0x15, VSQRTPS = 0x51,
+                  VXORPS = 0x57, VMULPS = 0x59, VSUBPS = 0x5C, VDIVPS = 0x5E, VSHUFPS = 0xC6;
+    const uint8_t VCVTPS2DQ = 0x5B, VPCMPEQD = 0x76;                      // 66 0F
+    const uint8_t VROUNDPS = 0x08, VPERM2F128 = 0x06;                     // 66 0F3A
+    const uint8_t VGATHERDPS = 0x92, VFMADD231PS = 0xB8, VFMSUB231PS = 0xBA, VFNMADD231PS = 0xBC; // 66 0F38
+    const uint8_t JB = 0x82, JE = 0x84;
+
+    Memory waveTerm(size_t wave, int term) { return constant(JIT_CONST_WAVES + static_cast<int>(wave) * JIT_TERMS_PER_WAVE + term); }
+
+    // WaveMath::lutIndex on a phase already in turns, so both of its divisions by 2pi are gone:
+    // keep the fraction, scale to the table, round (vcvtps2dq rounds to nearest). index = ymm8.
+    void emitLutIndex(Emitter &e)
+    {
+        e.vex(MAP_0F3A, PP_66, false, VROUNDPS, 9, 0, 8);
+        e.imm8(0x09); // Floor, no exceptions
+        e.op(VSUBPS, 8, 8, 9);
+        e.op(VMULPS, 8, 8, constant(JIT_CONST_LUT_SCALE));
+        e.vex(MAP_0F, PP_66, false, VCVTPS2DQ, 8, 0, 8);
+    }
+
+    // System V: rdi x, rsi z, rdx heights, rcx normals, r8 block count, r9 sin LUT, [rsp + 8] cos LUT.
+    // r11 is the byte offset into x, z and heights, rcx moves 96 bytes per block.
+    // ymm0 x, ymm1 z, ymm2 height, ymm3 tangentX.x, ymm4 tangentX.y, ymm5 tangentX.z (= tangentZ.x),
+    // ymm6 tangentZ.y, ymm7 tangentZ.z, ymm8-15 scratch
+    std::vector<uint8_t> emitKernel(size_t waveCount, size_t &constantsOffset)
+    {
+        Emitter e;
+        e.bytes({0x4C, 0x8B, 0x54, 0x24, 0x08}); // mov r10, [rsp + 8]
+        e.bytes({0x49, 0xC1, 0xE0, 0x05});       // shl r8, 5 (bytes of x per call)
+        e.bytes({0x45, 0x31, 0xDB});             // xor r11d, r11d
+        e.bytes({0x4D, 0x85, 0xC0});             // test r8, r8
+        size_t empty = e.jumpForward(JE);
+
+        size_t loop;
+        e.label(loop);
+        e.op(VMOVUPS_LOAD, 0, 0, indexed(RDI, R11));
+        e.op(VMOVUPS_LOAD, 1, 0, indexed(RSI, R11));
+        e.op(VXORPS, 2, 2, 2);
+        e.op(VMOVUPS_LOAD, 3, 0, constant(JIT_CONST_ONE));
+        e.op(VXORPS, 4, 4, 4);
+        e.op(VXORPS, 5, 5, 5);
+        e.op(VXORPS, 6, 6, 6);
+        e.op(VMOVUPS_LOAD, 7, 0, constant(JIT_CONST_ONE));
+
+        for (size_t wave = 0; wave < waveCount; ++wave)
+        {
+            // phase = kx * x + kz * z + offset, in turns
+            e.op(VMOVUPS_LOAD, 8, 0, waveTerm(wave, 2));
+            e.fma(VFMADD231PS, 8, 1, waveTerm(wave, 1));
+            e.fma(VFMADD231PS, 8, 0, waveTerm(wave, 0));
+            emitLutIndex(e);
+            // Full masks, the gathers clear them
+            e.vex(MAP_0F, PP_66, false, VPCMPEQD, 10, 10, 10);
+            e.vex(MAP_0F38, PP_66, false, VGATHERDPS, 11, 10, indexed(R9, 8, 2));
+            e.vex(MAP_0F, PP_66, false, VPCMPEQD, 10, 10, 10);
+            e.vex(MAP_0F38, PP_66, false, VGATHERDPS, 12, 10, indexed(R10, 8, 2));
+
+            e.fma(VFMADD231PS, 2, 11, waveTerm(wave, 3));  // height += amplitude * sin
+            e.fma(VFNMADD231PS, 3, 11, waveTerm(wave, 6)); // tangentX.x -= slopeXX * sin
+            e.fma(VFMADD231PS, 4, 12, waveTerm(wave, 4));  // tangentX.y += slopeX * cos
+            e.fma(VFNMADD231PS, 5, 11, waveTerm(wave, 7)); // tangentX.z -= slopeXZ * sin
+            e.fma(VFMADD231PS, 6, 12, waveTerm(wave, 5));  // tangentZ.y += slopeZ * cos
+            e.fma(VFNMADD231PS, 7, 11, waveTerm(wave, 8)); // tangentZ.z -= slopeZZ * sin
+        }
+
+        e.op(VMOVUPS_STORE, 2, 0, indexed(RDX, R11));
+
+        // normalize(cross(tangentZ, tangentX)) into ymm8-10, as OceanKernel.cpp finish but with one division
+        e.op(VMULPS, 8, 7, 4);
+        e.fma(VFMSUB231PS, 8, 6, 5);
+        e.op(VMULPS, 9, 5, 5);
+        e.fma(VFMSUB231PS, 9, 7, 3);
+        e.op(VMULPS, 10, 6, 3);
+        e.fma(VFMSUB231PS, 10, 5, 4);
+        e.op(VMULPS, 11, 8, 8);
+        e.fma(VFMADD231PS, 11, 9, 9);
+        e.fma(VFMADD231PS, 11, 10, 10);
+        e.vex(MAP_0F, PP_NONE, false, VSQRTPS, 11, 0, 11);
+        e.op(VMOVUPS_LOAD, 12, 0, constant(JIT_CONST_ONE));
+        e.op(VDIVPS, 11, 12, 11);
+        e.op(VMULPS, 8, 8, 11);
+        e.op(VMULPS, 9, 9, 11);
+        e.op(VMULPS, 10, 10, 11);
+
+        // xyz triples, WaveMath::storeNormalsShuffle with x = 8, y = 9, z = 10
+        e.op(VUNPCKLPS, 11, 8, 9);                                 // xy
+        e.op(VUNPCKHPS, 12, 8, 9);                                 // xyHigh
+        e.op(VSHUFPS, 13, 10, 8); e.imm8(0xD8);          // zx = shuffle(z, x, 3 1 2 0)
+        e.op(VSHUFPS, 14, 9, 10); e.imm8(0xDD);          // yz = shuffle(y, z, 3 1 3 1)
+        e.op(VSHUFPS, 15, 11, 13); e.imm8(0x84);         // a = shuffle(xy, zx, 2 0 1 0)
+        e.op(VSHUFPS, 11, 14, 12); e.imm8(0x48);         // b = shuffle(yz, xyHigh, 1 0 2 0)
+        e.op(VSHUFPS, 12, 13, 14); e.imm8(0xDD);         // c = shuffle(zx, yz, 3 1 3 1)
+        e.vex(MAP_0F3A, PP_66, false, VPERM2F128, 8, 15, 11); e.imm8(0x20);
+        e.vex(MAP_0F3A, PP_66, false, VPERM2F128, 9, 12, 15); e.imm8(0x30);
+        e.vex(MAP_0F3A, PP_66, false, VPERM2F128, 10, 11, 12); e.imm8(0x31);
+        e.op(VMOVUPS_STORE, 8, 0, at(RCX, 0));
+        e.op(VMOVUPS_STORE, 9, 0, at(RCX, 32));
+        e.op(VMOVUPS_STORE, 10, 0, at(RCX, 64));
+
+        e.bytes({0x49, 0x83, 0xC3, 0x20}); // add r11, 32
+        e.bytes({0x48, 0x83, 0xC1, 0x60}); // add rcx, 96
+        e.bytes({0x4D, 0x39, 0xC3});       // cmp r11, r8
+        e.jumpBack(JB, loop);
+
+        e.land(empty);
+        e.bytes({0xC5, 0xF8, 0x77}); // vzeroupper
+        e.bytes({0xC3});             // ret
+
+        // Constants start on the page after the code. No RIP-relative operand has an immediate after it,
+        // so the end of the disp32 is the end of the instruction.
+        long page = sysconf(_SC_PAGESIZE);
+        constantsOffset = (e.code.size() + page - 1) / page * page;
+        for (const Emitter::Fixup &fixup : e.fixups)
+        {
+            int32_t relative = static_cast<int32_t>(constantsOffset + fixup.constant * 32 - (fixup.position + 4));
+            std::memcpy(&e.code[fixup.position], &relative, 4);
+        }
+        return e.code;
+    }
+
+    void splat(float *entry, float value)
+    {
+        for (int lane = 0; lane < 8; ++lane)
+        {
+            entry[lane] = value;
+        }
+    }
+}
+
+OceanJit::OceanJit() : mapping(nullptr), mappingSize(0), codeSize(0), constants(nullptr), function(nullptr), generated(false) {}
+
+OceanJit::~OceanJit()
+{
+    release();
+}
+
+void OceanJit::release()
+{
+    if (mapping != nullptr)
+    {
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = codeSize = 0;
+    constants = nullptr;
+    function = nullptr;
+    key.clear();
+}
+
+bool OceanJit::prepare(const GerstnerWave *waves, size_t waveCount, int lutSize)
+{
+    std::vector<float> newKey = {static_cast<float>(waveCount), static_cast<float>(lutSize)};
+    for (size_t i = 0; i < waveCount; ++i)
+    {
+        const GerstnerWave &wave = waves[i];
+        newKey.insert(newKey.end(), {wave.amplitude, wave.wavelength, wave.speed, wave.direction.x, wave.direction.y, wave.phase});
+    }
+    if (function != nullptr && newKey == key)
+    {
+        return true;
+    }
+    release();
+
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (!supported || waveCount > OCEAN_JIT_MAX_WAVES)
+    {
+        return false;
+    }
+
+    size_t constantsOffset;
+    std::vector<uint8_t> code = emitKernel(waveCount, constantsOffset);
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t constantBytes = (JIT_CONST_WAVES + waveCount * JIT_TERMS_PER_WAVE) * 32;
+    size_t size = constantsOffset + (constantBytes + page - 1) / page * page;
+
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        std::cerr << "OceanJit: cannot map " << size << " bytes, using the compiled kernel" << std::endl;
+        return false;
+    }
+    mapping = static_cast<uint8_t *>(memory);
+    mappingSize = size;
+    std::memcpy(mapping, code.data(), code.size());
+    if (mprotect(mapping, constantsOffset, PROT_READ | PROT_EXEC) != 0) // Never writable and executable at once
+    {
+        std::cerr << "OceanJit: cannot make the code executable, using the compiled kernel" << std::endl;
+        release();
+        return false;
+    }
+
+    codeSize = code.size();
+    constants = reinterpret_cast<float *>(mapping + constantsOffset);
+    splat(constants + JIT_CONST_LUT_SCALE * 8, static_cast<float>(lutSize - 1));
+    splat(constants + JIT_CONST_ONE * 8, 1.0f);
+    function = reinterpret_cast<Function>(mapping);
+    key.swap(newKey);
+    return true;
+}
+
+void OceanJit::run(const OceanKernelArgs &args, const GerstnerWave *waves, size_t waveCount, float time)
+{
+    setTime(waves, waveCount, time, args.sinLut, args.lutSize);
+    run(args, 0, args.numVertices);
+}
+
+void OceanJit::setTime(const GerstnerWave *waves, size_t waveCount, float time, const float *sinLut, int lutSize)
+{
+    terms.resize(waveCount);
+    OceanKernels::computeWaveTerms(waves, waveCount, time, sinLut, lutSize, terms.data());
+    generated = prepare(waves, waveCount, lutSize);
+    if (!generated)
+    {
+        return;
+    }
+    static_assert(sizeof(WaveTerms) == JIT_TERMS_PER_WAVE * sizeof(float), "constant layout follows WaveTerms");
+    for (size_t wave = 0; wave < waveCount; ++wave)
+    {
+        WaveTerms turns = terms[wave];
+        turns.kx /= 6.283185307f;
+        turns.kz /= 6.283185307f;
+        turns.offset /= 6.283185307f;
+        const float *values = reinterpret_cast<const float *>(&turns);
+        for (int term = 0; term < JIT_TERMS_PER_WAVE; ++term)
+        {
+            splat(constants + (JIT_CONST_WAVES + wave * JIT_TERMS_PER_WAVE + term) * 8, values[term]);
+        }
+    }
+}
+
+void OceanJit::run(const OceanKernelArgs &args, size_t begin, size_t end) const
+{
+    size_t blocks = generated ? (end - begin) / 8 : 0;
+    if (blocks > 0)
+    {
+        function(args.originalX + begin, args.originalZ + begin, args.heights + begin, args.normals + begin * 3, blocks, args.sinLut, args.cosLut);
+    }
+    if (begin + blocks * 8 < end)
+    {
+        OceanKernels::select(terms.size())(args, terms.data(), terms.size(), begin + blocks * 8, end);
+    }
+}
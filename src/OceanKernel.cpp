@@ -0,0 +1,303 @@
+/*
+ * File:        OceanKernel.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Gerstner kernel specialized on the wave count, with hoisted per-wave terms
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "OceanKernel.h"
+#include "Ocean.h"
+#include "WaveMath.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    struct WaveVectors
+    {
+        __m256 kx, kz, offset, amplitude, slopeX, slopeZ, slopeXX, slopeXZ, slopeZZ;
+    };
+
+    // Sums over the waves for eight vertices; tangentX.z and tangentZ.x are the same sum
+    struct Accumulators
+    {
+        __m256 height, tangentXx, tangentXy, tangentXZ, tangentZy, tangentZz;
+    };
+
+    inline WaveVectors broadcast(const WaveTerms &terms)
+    {
+        return {_mm256_set1_ps(terms.kx), _mm256_set1_ps(terms.kz), _mm256_set1_ps(terms.offset),
+                _mm256_set1_ps(terms.amplitude), _mm256_set1_ps(terms.slopeX), _mm256_set1_ps(terms.slopeZ),
+                _mm256_set1_ps(terms.slopeXX), _mm256_set1_ps(terms.slopeXZ), _mm256_set1_ps(terms.slopeZZ)};
+    }
+
+    inline void accumulate(const WaveVectors &wave, __m256 x, __m256 z, const OceanKernelArgs &args, Accumulators &sums)
+    {
+        __m256 phase = _mm256_fmadd_ps(wave.kx, x, _mm256_fmadd_ps(wave.kz, z, wave.offset));
+        __m256 sinTerm, cosTerm;
+        WaveMath::sincosLut(phase, args.sinLut, args.cosLut, args.lutSize, sinTerm, cosTerm);
+        sums.height = _mm256_fmadd_ps(wave.amplitude, sinTerm, sums.height);
+        sums.tangentXx = _mm256_fnmadd_ps(wave.slopeXX, sinTerm, sums.tangentXx);
+        sums.tangentXy = _mm256_fmadd_ps(wave.slopeX, cosTerm, sums.tangentXy);
+        sums.tangentXZ = _mm256_fnmadd_ps(wave.slopeXZ, sinTerm, sums.tangentXZ);
+        sums.tangentZy = _mm256_fmadd_ps(wave.slopeZ, cosTerm, sums.tangentZy);
+        sums.tangentZz = _mm256_fnmadd_ps(wave.slopeZZ, sinTerm, sums.tangentZz);
+    }
+
+    // Height, then normalize(cross(tangentZ, tangentX)) as the assembly does, stored as xyz triples
+    inline void finish(const Accumulators &sums, float *height, float *normal)
+    {
+        _mm256_storeu_ps(height, sums.height);
+        __m256 crossX = _mm256_fmsub_ps(sums.tangentZy, sums.tangentXZ, _mm256_mul_ps(sums.tangentZz, sums.tangentXy));
+        __m256 crossY = _mm256_fmsub_ps(sums.tangentZz, sums.tangentXx, _mm256_mul_ps(sums.tangentXZ, sums.tangentXZ));
+        __m256 crossZ = _mm256_fmsub_ps(sums.tangentXZ, sums.tangentXy, _mm256_mul_ps(sums.tangentZy, sums.tangentXx));
+        __m256 length = _mm256_sqrt_ps(_mm256_fmadd_ps(crossZ, crossZ, _mm256_fmadd_ps(crossY, crossY, _mm256_mul_ps(crossX, crossX))));
+        WaveMath::storeNormalsShuffle(normal, _mm256_div_ps(crossX, length), _mm256_div_ps(crossY, length), _mm256_div_ps(crossZ, length));
+    }
+
+    template <typename WaveLoop>
+    inline void forEachBlock(const OceanKernelArgs &args, size_t begin, size_t end, const WaveLoop &waveLoop)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 zero = _mm256_setzero_ps();
+        size_t fullEnd = begin + (end - begin) / 8 * 8;
+        for (size_t i = begin; i < fullEnd; i += 8)
+        {
+            Accumulators sums = {zero, one, zero, zero, zero, one};
+            waveLoop(_mm256_loadu_ps(args.originalX + i), _mm256_loadu_ps(args.originalZ + i), sums);
+            finish(sums, args.heights + i, args.normals + i * 3);
+        }
+
+        if (fullEnd < end) // Grids whose vertex count is not a multiple of 8, the assembly cannot do these
+        {
+            size_t count = end - fullEnd;
+            alignas(32) float x[8] = {}, z[8] = {}, heights[8], normals[24];
+            std::copy(args.originalX + fullEnd, args.originalX + end, x);
+            std::copy(args.originalZ + fullEnd, args.originalZ + end, z);
+            Accumulators sums = {zero, one, zero, zero, zero, one};
+            waveLoop(_mm256_load_ps(x), _mm256_load_ps(z), sums);
+            finish(sums, heights, normals);
+            std::copy(heights, heights + count, args.heights + fullEnd);
+            std::copy(normals, normals + count * 3, args.normals + fullEnd * 3);
+        }
+    }
+
+    // Terms broadcast once per call; they stay in registers as far as the 16 ymm registers go, the rest are
+    // stack loads at fixed offsets instead of the assembly's offset multiply and reload per wave
+    template <int WAVES>
+    void kernelFixed(const OceanKernelArgs &args, const WaveTerms *terms, size_t, size_t begin, size_t end)
+    {
+        WaveVectors waves[WAVES];
+        for (int wave = 0; wave < WAVES; ++wave)
+        {
+            waves[wave] = broadcast(terms[wave]);
+        }
+        forEachBlock(args, begin, end, [&](__m256 x, __m256 z, Accumulators &sums)
+                     {
+#pragma GCC unroll 16
+            for (int wave = 0; wave < WAVES; ++wave)
+            {
+                accumulate(waves[wave], x, z, args, sums);
+            } });
+    }
+
+    void kernelGeneric(const OceanKernelArgs &args, const WaveTerms *terms, size_t waveCount, size_t begin, size_t end)
+    {
+        forEachBlock(args, begin, end, [&](__m256 x, __m256 z, Accumulators &sums)
+                     {
+            for (size_t wave = 0; wave < waveCount; ++wave)
+            {
+                accumulate(broadcast(terms[wave]), x, z, args, sums);
+            } });
+    }
+
+    struct FixedWaveVectors
+    {
+        __m256i stepX, stepZ, origin;
+        __m256 amplitude, slopeX, slopeZ, slopeXX, slopeXZ, slopeZZ;
+    };
+
+    inline FixedWaveVectors broadcast(const FixedWaveTerms &terms)
+    {
+        return {_mm256_set1_epi32(static_cast<int>(terms.stepX)), _mm256_set1_epi32(static_cast<int>(terms.stepZ)),
+                _mm256_set1_epi32(static_cast<int>(terms.origin)), _mm256_set1_ps(terms.amplitude), _mm256_set1_ps(terms.slopeX),
+                _mm256_set1_ps(terms.slopeZ), _mm256_set1_ps(terms.slopeXX), _mm256_set1_ps(terms.slopeXZ), _mm256_set1_ps(terms.slopeZZ)};
+    }
+
+    // Integer multiply-adds wrap modulo a turn, the index is a shift; replaces the whole of lutIndex
+    inline void accumulateFixed(const FixedWaveVectors &wave, __m256i row, __m256i column, const OceanKernelArgs &args, Accumulators &sums)
+    {
+        __m256i phase = _mm256_add_epi32(wave.origin, _mm256_add_epi32(_mm256_mullo_epi32(row, wave.stepX), _mm256_mullo_epi32(column, wave.stepZ)));
+        __m256i index = _mm256_srli_epi32(phase, 32 - PHASE_LUT_BITS);
+        __m256 sinTerm = _mm256_i32gather_ps(args.sinLut, index, 4);
+        __m256 cosTerm = _mm256_i32gather_ps(args.cosLut, index, 4);
+        sums.height = _mm256_fmadd_ps(wave.amplitude, sinTerm, sums.height);
+        sums.tangentXx = _mm256_fnmadd_ps(wave.slopeXX, sinTerm, sums.tangentXx);
+        sums.tangentXy = _mm256_fmadd_ps(wave.slopeX, cosTerm, sums.tangentXy);
+        sums.tangentXZ = _mm256_fnmadd_ps(wave.slopeXZ, sinTerm, sums.tangentXZ);
+        sums.tangentZy = _mm256_fmadd_ps(wave.slopeZ, cosTerm, sums.tangentZy);
+        sums.tangentZz = _mm256_fnmadd_ps(wave.slopeZZ, sinTerm, sums.tangentZz);
+    }
+
+    // Lattice coordinates step along with the vertex index instead of being loaded; the lanes of the padded
+    // last block run on past the range, which is harmless as only their phases are computed
+    void kernelFixedPoint(const OceanKernelArgs &args, const OceanLattice &lattice, const FixedWaveTerms *terms, size_t waveCount, size_t begin, size_t end)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256i columns = _mm256_set1_epi32(static_cast<int>(lattice.columns));
+        const __m256i lastColumn = _mm256_set1_epi32(static_cast<int>(lattice.columns) - 1);
+        const __m256i blockStep = _mm256_set1_epi32(8);
+        __m256i row = _mm256_set1_epi32(static_cast<int>(begin / lattice.columns));
+        __m256i column = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(begin % lattice.columns)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        auto wrap = [&]()
+        {
+            for (;;) // Several rows at once if the grid is narrower than 8
+            {
+                __m256i overflow = _mm256_cmpgt_epi32(column, lastColumn);
+                if (_mm256_testz_si256(overflow, overflow))
+                {
+                    break;
+                }
+                column = _mm256_sub_epi32(column, _mm256_and_si256(overflow, columns));
+                row = _mm256_sub_epi32(row, overflow); // All ones is -1
+            }
+        };
+        wrap();
+
+        for (size_t i = begin; i < end; i += 8)
+        {
+            Accumulators sums = {zero, one, zero, zero, zero, one};
+            for (size_t wave = 0; wave < waveCount; ++wave)
+            {
+                accumulateFixed(broadcast(terms[wave]), row, column, args, sums);
+            }
+            if (i + 8 <= end)
+            {
+                finish(sums, args.heights + i, args.normals + i * 3);
+            }
+            else
+            {
+                size_t count = end - i;
+                alignas(32) float heights[8], normals[24];
+                finish(sums, heights, normals);
+                std::copy(heights, heights + count, args.heights + i);
+                std::copy(normals, normals + count * 3, args.normals + i * 3);
+            }
+            column = _mm256_add_epi32(column, blockStep);
+            wrap();
+        }
+    }
+
+    const OceanKernelFunction kernelTable[OCEAN_KERNEL_MAX_WAVES + 1] = {
+        kernelGeneric, kernelFixed<1>, kernelFixed<2>, kernelFixed<3>, kernelFixed<4>, kernelFixed<5>,
+        kernelFixed<6>, kernelFixed<7>, kernelFixed<8>, kernelFixed<9>, kernelFixed<10>, kernelFixed<11>,
+        kernelFixed<12>, kernelFixed<13>, kernelFixed<14>, kernelFixed<15>, kernelFixed<16>,
+    };
+}
+
+void OceanKernels::computeWaveTerms(const GerstnerWave *waves, size_t waveCount, float time, const float *sinLut, int lutSize, WaveTerms *terms)
+{
+    for (size_t i = 0; i < waveCount; ++i)
+    {
+        const GerstnerWave &wave = waves[i];
+        float k = 6.283185307f / wave.wavelength;
+
+        // sin(k * time) through the same LUT lookup as the assembly, so both kernels agree
+        __m256i index = WaveMath::lutIndex(_mm256_set1_ps(k * time), lutSize);
+        float amplitude = wave.amplitude * 0.5f * (1.0f + sinLut[_mm_cvtsi128_si32(_mm256_castsi256_si128(index))]);
+
+        WaveTerms &term = terms[i];
+        term.kx = k * wave.direction.x;
+        term.kz = k * wave.direction.y;
+        term.offset = k * (wave.phase - wave.speed * time);
+        term.amplitude = amplitude;
+        term.slopeX = amplitude * k * wave.direction.x;
+        term.slopeZ = amplitude * k * wave.direction.y;
+        term.slopeXX = term.slopeX * wave.direction.x;
+        term.slopeXZ = term.slopeX * wave.direction.y;
+        term.slopeZZ = term.slopeZ * wave.direction.y;
+    }
+}
+
+OceanKernelFunction OceanKernels::select(size_t waveCount)
+{
+    return waveCount <= OCEAN_KERNEL_MAX_WAVES ? kernelTable[waveCount] : kernelGeneric;
+}
+
+void OceanKernels::run(const OceanKernelArgs &args, const GerstnerWave *waves, size_t waveCount, float time)
+{
+    WaveTerms localTerms[OCEAN_KERNEL_MAX_WAVES];
+    std::vector<WaveTerms> manyTerms(waveCount > OCEAN_KERNEL_MAX_WAVES ? waveCount : 0);
+    WaveTerms *terms = waveCount > OCEAN_KERNEL_MAX_WAVES ? manyTerms.data() : localTerms;
+    computeWaveTerms(waves, waveCount, time, args.sinLut, args.lutSize, terms);
+    select(waveCount)(args, terms, waveCount, 0, args.numVertices);
+}
+
+uint32_t OceanKernels::toPhase(double turns)
+{
+    double fraction = turns - std::floor(turns);
+    return static_cast<uint32_t>(static_cast<uint64_t>(fraction * 4294967296.0)); // A fraction rounding to 1 wraps to 0
+}
+
+namespace
+{
+    uint64_t toPhase64(double turns)
+    {
+        double fraction = turns - std::floor(turns);
+        return fraction < 1.0 ? static_cast<uint64_t>(std::ldexp(fraction, 64)) : 0;
+    }
+}
+
+void OceanKernels::resetPhases(const GerstnerWave *waves, size_t waveCount, double time, WavePhase *phases)
+{
+    for (size_t i = 0; i < waveCount; ++i)
+    {
+        phases[i].travel = toPhase64(waves[i].speed * time / waves[i].wavelength);
+        phases[i].swell = toPhase64(time / waves[i].wavelength);
+    }
+}
+
+void OceanKernels::advancePhases(const GerstnerWave *waves, size_t waveCount, double deltaTime, WavePhase *phases)
+{
+    for (size_t i = 0; i < waveCount; ++i)
+    {
+        phases[i].travel += toPhase64(waves[i].speed * deltaTime / waves[i].wavelength); // Wraps modulo a turn
+        phases[i].swell += toPhase64(deltaTime / waves[i].wavelength);
+    }
+}
+
+void OceanKernels::computeFixedWaveTerms(const GerstnerWave *waves, size_t waveCount, const WavePhase *phases, const OceanLattice &lattice,
+                                         const float *sinLut, FixedWaveTerms *terms)
+{
+    for (size_t i = 0; i < waveCount; ++i)
+    {
+        const GerstnerWave &wave = waves[i];
+        float k = 6.283185307f / wave.wavelength;
+        uint32_t swell = static_cast<uint32_t>(phases[i].swell >> 32);
+        float amplitude = wave.amplitude * 0.5f * (1.0f + sinLut[(swell + PHASE_ROUNDING) >> (32 - PHASE_LUT_BITS)]);
+
+        // Spatial phase k * (direction . position + phase) in turns, k / 2pi being 1 / wavelength
+        double turnsPerUnit = 1.0 / wave.wavelength;
+        FixedWaveTerms &term = terms[i];
+        term.stepX = toPhase(wave.direction.x * lattice.spacing * turnsPerUnit);
+        term.stepZ = toPhase(wave.direction.y * lattice.spacing * turnsPerUnit);
+        term.origin = toPhase((wave.direction.x * lattice.originX + wave.direction.y * lattice.originZ + wave.phase) * turnsPerUnit) -
+                      static_cast<uint32_t>(phases[i].travel >> 32) + PHASE_ROUNDING;
+        term.amplitude = amplitude;
+        term.slopeX = amplitude * k * wave.direction.x;
+        term.slopeZ = amplitude * k * wave.direction.y;
+        term.slopeXX = term.slopeX * wave.direction.x;
+        term.slopeXZ = term.slopeX * wave.direction.y;
+        term.slopeZZ = term.slopeZ * wave.direction.y;
+    }
+}
+
+void OceanKernels::runFixed(const OceanKernelArgs &args, const OceanLattice &lattice, const FixedWaveTerms *terms, size_t waveCount, size_t begin, size_t end)
+{
+    kernelFixedPoint(args, lattice, terms, waveCount, begin, end);
+}
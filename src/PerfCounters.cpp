@@ -0,0 +1,271 @@
+/*
+ * File:        PerfCounters.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Grouped hardware counters of the calling thread via perf_event_open
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "PerfCounters.h"
+#include <algorithm>
+#include <cerrno>
+#include <cpuid.h>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <linux/perf_event.h>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+    long perfEventOpen(perf_event_attr *attr, int groupFd)
+    {
+        return syscall(__NR_perf_event_open, attr, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC); // This thread, any CPU
+    }
+
+    uint64_t cacheConfig(uint64_t cache, uint64_t operation, uint64_t result)
+    {
+        return cache | (operation << 8) | (result << 16);
+    }
+
+    std::string cpuVendor(unsigned &family, unsigned &model)
+    {
+        unsigned eax, ebx, ecx, edx;
+        family = 0;
+        model = 0;
+        if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx))
+        {
+            return "";
+        }
+        char vendor[13];
+        std::memcpy(vendor, &ebx, 4);
+        std::memcpy(vendor + 4, &edx, 4);
+        std::memcpy(vendor + 8, &ecx, 4);
+        vendor[12] = '\0';
+        if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        {
+            family = (eax >> 8) & 0xF;
+            model = (eax >> 4) & 0xF;
+            if (family == 6 || family == 0xF)
+            {
+                model |= ((eax >> 16) & 0xF) << 4;
+            }
+            if (family == 0xF)
+            {
+                family += (eax >> 20) & 0xFF;
+            }
+        }
+        return vendor;
+    }
+
+    // Family 6 models with the Haswell/Skylake L2_RQSTS and port uop encodings. Sandy and Ivy Bridge use
+    // other umasks and Ice Lake renumbered the ports, so anything not listed gets no raw events.
+    bool hasHaswellPortEvents(unsigned model)
+    {
+        static const unsigned models[] = {
+            0x3C, 0x3F, 0x45, 0x46,             // Haswell
+            0x3D, 0x47, 0x4F, 0x56,             // Broadwell
+            0x4E, 0x5E, 0x55,                   // Skylake, Skylake-X / Cascade Lake
+            0x8E, 0x9E, 0xA5, 0xA6,             // Kaby, Coffee, Comet Lake
+        };
+        return std::find(std::begin(models), std::end(models), model) != std::end(models);
+    }
+
+    int paranoidLevel()
+    {
+        std::ifstream file("/proc/sys/kernel/perf_event_paranoid");
+        int level = 2;
+        file >> level;
+        return level;
+    }
+}
+
+PerfCounters::PerfCounters() {}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+std::vector<PerfEventSpec> PerfCounters::defaultEvents()
+{
+    std::vector<PerfEventSpec> events = {
+        {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 0},
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 0},
+        {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, 0},
+        {"L1D-misses", PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), 1},
+        {"LLC-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, 1},
+    };
+
+    unsigned family, model;
+    std::string vendor = cpuVendor(family, model);
+    if (vendor == "GenuineIntel" && family == 6 && hasHaswellPortEvents(model))
+    {
+        // L2_RQSTS.MISS and UOPS_DISPATCHED_PORT (UOPS_EXECUTED_PORT on Haswell): ports 0, 1 and 5 run the
+        // vector ALU and FMA work, port 5 also the shuffles of the normal store and the gather merges
+        events.push_back({"L2-misses", PERF_TYPE_RAW, 0x3F24, 1});
+        events.push_back({"port0-uops", PERF_TYPE_RAW, 0x01A1, 2});
+        events.push_back({"port1-uops", PERF_TYPE_RAW, 0x02A1, 2});
+        events.push_back({"port5-uops", PERF_TYPE_RAW, 0x20A1, 2});
+    }
+    else if (vendor == "AuthenticAMD" && family >= 0x17)
+    {
+        // L2CacheReqStat, data and instruction fetch misses
+        events.push_back({"L2-misses", PERF_TYPE_RAW, 0x0964, 1});
+    }
+    return events;
+}
+
+bool PerfCounters::parseRawEvents(const std::string &list, std::vector<PerfEventSpec> &events)
+{
+    int group = 0;
+    for (const PerfEventSpec &event : events)
+    {
+        group = std::max(group, event.group + 1);
+    }
+
+    std::stringstream stream(list);
+    std::string item;
+    int inGroup = 0;
+    while (std::getline(stream, item, ','))
+    {
+        size_t equals = item.find('=');
+        if (equals == std::string::npos || equals + 2 > item.size() || item[equals + 1] != 'r')
+        {
+            std::cerr << "Bad perf event '" << item << "', expected name=rUUEE (hex umask and event)" << std::endl;
+            return false;
+        }
+        char *end = nullptr;
+        uint64_t config = std::strtoull(item.c_str() + equals + 2, &end, 16);
+        if (*end != '\0' || config == 0)
+        {
+            std::cerr << "Bad perf event code in '" << item << "'" << std::endl;
+            return false;
+        }
+        events.push_back({item.substr(0, equals), PERF_TYPE_RAW, config, group});
+        if (++inGroup == 3) // Three per group leaves room next to the fixed counters
+        {
+            inGroup = 0;
+            group++;
+        }
+    }
+    return true;
+}
+
+bool PerfCounters::open(const std::vector<PerfEventSpec> &events)
+{
+    close();
+    std::vector<std::string> failed;
+    int lastError = 0;
+
+    int groupId = -1;
+    for (size_t i = 0; i < events.size() && names.size() < PERF_MAX_EVENTS; ++i)
+    {
+        const PerfEventSpec &event = events[i];
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event.type;
+        attr.config = event.config;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        bool newGroup = event.group != groupId || groups.empty();
+        int fd = static_cast<int>(perfEventOpen(&attr, newGroup ? -1 : groups.back().leaderFd));
+        if (fd < 0)
+        {
+            lastError = errno;
+            failed.push_back(event.name);
+            continue; // A failed leader makes the next event of its group the leader
+        }
+        if (newGroup)
+        {
+            groups.push_back({fd, {}, names.size()});
+            groupId = event.group;
+        }
+        groups.back().fds.push_back(fd);
+        names.push_back(event.name);
+    }
+
+    if (!failed.empty())
+    {
+        std::cerr << "perf_event_open failed for";
+        for (const std::string &name : failed)
+        {
+            std::cerr << ' ' << name;
+        }
+        std::cerr << " (" << std::strerror(lastError) << ")";
+        if ((lastError == EACCES || lastError == EPERM) && paranoidLevel() > 2)
+        {
+            std::cerr << ", /proc/sys/kernel/perf_event_paranoid is above 2";
+        }
+        std::cerr << std::endl;
+    }
+    return isOpen();
+}
+
+void PerfCounters::close()
+{
+    for (const Group &group : groups)
+    {
+        for (int fd : group.fds)
+        {
+            ::close(fd);
+        }
+    }
+    groups.clear();
+    names.clear();
+}
+
+int PerfCounters::findEvent(const char *name) const
+{
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        if (names[i] == name)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool PerfCounters::read(PerfSample &sample) const
+{
+    // PERF_FORMAT_GROUP layout: nr, time_enabled, time_running, value[nr]
+    uint64_t buffer[3 + PERF_MAX_EVENTS];
+    for (const Group &group : groups)
+    {
+        ssize_t bytes = ::read(group.leaderFd, buffer, sizeof(buffer));
+        if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buffer[0] != group.fds.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < group.fds.size(); ++i)
+        {
+            sample.values[group.firstValue + i] = buffer[3 + i];
+            sample.enabled[group.firstValue + i] = buffer[1];
+            sample.running[group.firstValue + i] = buffer[2];
+        }
+    }
+    return true;
+}
+
+double PerfCounters::delta(const PerfSample &begin, const PerfSample &end, size_t index)
+{
+    // Scaling the two totals separately would use two different ratios, the interval has its own
+    uint64_t running = end.running[index] - begin.running[index];
+    if (running == 0 || end.values[index] < begin.values[index])
+    {
+        return 0.0;
+    }
+    double value = static_cast<double>(end.values[index] - begin.values[index]);
+    uint64_t enabled = end.enabled[index] - begin.enabled[index];
+    return enabled == running ? value : value * enabled / running;
+}
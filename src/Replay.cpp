@@ -0,0 +1,274 @@
+/*
+ * File:        Replay.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Binary record and replay of the input and step length of every simulation step
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "Replay.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    const char MAGIC[4] = {'I', 'P', 'A', 'R'};
+
+    // First step compares against nothing held and the fixed step of the header
+    ReplayStep initialStep(double simRate)
+    {
+        ReplayStep step;
+        step.deltaTime = static_cast<float>(1.0 / simRate);
+        step.input.mouseButtons = 0;
+        step.input.mouseX = step.input.mouseY = 0;
+        return step;
+    }
+
+    void putRaw(std::string& out, const void* value, size_t size) // x86 is little endian already
+    {
+        out.append(static_cast<const char*>(value), size);
+    }
+
+    void putVarint(std::string& out, int32_t value)
+    {
+        uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+        while (zigzag >= 0x80)
+        {
+            out.push_back(static_cast<char>((zigzag & 0x7F) | 0x80));
+            zigzag >>= 7;
+        }
+        out.push_back(static_cast<char>(zigzag));
+    }
+
+    bool getRaw(const std::string& data, size_t& position, void* value, size_t size)
+    {
+        if (position + size > data.size())
+        {
+            return false;
+        }
+        std::memcpy(value, data.data() + position, size);
+        position += size;
+        return true;
+    }
+
+    bool getVarint(const std::string& data, size_t& position, int32_t& value)
+    {
+        uint32_t zigzag = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            uint8_t byte;
+            if (!getRaw(data, position, &byte, 1))
+            {
+                return false;
+            }
+            zigzag |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                value = static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+ReplayWriter::ReplayWriter() : previous(initialStep(60.0)), steps(0) {}
+
+bool ReplayWriter::open(const std::string& path, double simRate)
+{
+    file.open(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Cannot write replay " << path << std::endl;
+        return false;
+    }
+    this->path = path;
+    std::string header(MAGIC, sizeof(MAGIC));
+    uint32_t version = REPLAY_VERSION;
+    putRaw(header, &version, sizeof(version));
+    putRaw(header, &simRate, sizeof(simRate));
+    file.write(header.data(), header.size());
+    previous = initialStep(simRate);
+    steps = 0;
+    return static_cast<bool>(file);
+}
+
+void ReplayWriter::write(const ReplayStep& step)
+{
+    // The diff base is what the reader will rebuild, so key lists past the u8 count are cut here too
+    ReplayStep stored = step;
+    InputSnapshot& input = stored.input;
+    bool cut = input.keys.size() > REPLAY_MAX_KEYS || input.specialKeys.size() > REPLAY_MAX_KEYS;
+    input.keys.resize(std::min<size_t>(input.keys.size(), REPLAY_MAX_KEYS));
+    input.specialKeys.resize(std::min<size_t>(input.specialKeys.size(), REPLAY_MAX_KEYS));
+    uint8_t flags = 0;
+    flags |= stored.deltaTime != previous.deltaTime ? REPLAY_DT : 0;
+    flags |= input.keys != previous.input.keys ? REPLAY_KEYS : 0;
+    flags |= input.specialKeys != previous.input.specialKeys ? REPLAY_SPECIAL : 0;
+    flags |= input.mouseButtons != previous.input.mouseButtons ? REPLAY_BUTTONS : 0;
+    flags |= input.mouseX != previous.input.mouseX || input.mouseY != previous.input.mouseY ? REPLAY_MOUSE : 0;
+
+    if (cut && (flags & (REPLAY_KEYS | REPLAY_SPECIAL)))
+    {
+        std::cerr << "Replay step " << steps << " holds more than " << REPLAY_MAX_KEYS << " keys, recording the first ones"
+                  << std::endl;
+    }
+
+    std::string record(1, static_cast<char>(flags));
+    if (flags & REPLAY_DT)
+    {
+        putRaw(record, &stored.deltaTime, sizeof(stored.deltaTime));
+    }
+    if (flags & REPLAY_KEYS)
+    {
+        record.push_back(static_cast<char>(input.keys.size()));
+        record.append(input.keys.begin(), input.keys.end());
+    }
+    if (flags & REPLAY_SPECIAL)
+    {
+        record.push_back(static_cast<char>(input.specialKeys.size()));
+        for (int specialKey : input.specialKeys)
+        {
+            uint16_t key = static_cast<uint16_t>(specialKey); // GLUT_KEY_* are below 0x100
+            putRaw(record, &key, sizeof(key));
+        }
+    }
+    if (flags & REPLAY_BUTTONS)
+    {
+        record.push_back(static_cast<char>(input.mouseButtons));
+    }
+    if (flags & REPLAY_MOUSE)
+    {
+        putVarint(record, input.mouseX - previous.input.mouseX);
+        putVarint(record, input.mouseY - previous.input.mouseY);
+    }
+    file.write(record.data(), record.size());
+    previous = stored;
+    steps++;
+    if (steps % REPLAY_FLUSH_STEPS == 0)
+    {
+        file.flush(); // A crash loses at most the steps since, close() writes the rest
+    }
+}
+
+bool ReplayWriter::close()
+{
+    if (!file.is_open())
+    {
+        return true;
+    }
+    file.close();
+    if (!file)
+    {
+        std::cerr << "Writing replay " << path << " failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+ReplayReader::ReplayReader() : position(0), opened(false), simRate(60.0), previous(initialStep(60.0)), steps(0) {}
+
+bool ReplayReader::open(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Cannot open replay " << path << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    data = buffer.str();
+
+    uint32_t version = 0;
+    position = sizeof(MAGIC);
+    if (data.size() < sizeof(MAGIC) || data.compare(0, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0 ||
+        !getRaw(data, position, &version, sizeof(version)) || !getRaw(data, position, &simRate, sizeof(simRate)))
+    {
+        std::cerr << path << " is not a replay file" << std::endl;
+        return false;
+    }
+    if (version != REPLAY_VERSION)
+    {
+        std::cerr << path << " has replay version " << version << ", this build reads " << REPLAY_VERSION << std::endl;
+        return false;
+    }
+    if (!(simRate >= 1.0 && simRate <= 10000.0))
+    {
+        std::cerr << path << " has a bad simulation rate" << std::endl;
+        return false;
+    }
+    previous = initialStep(simRate);
+    steps = 0;
+    opened = true;
+    return true;
+}
+
+bool ReplayReader::next(ReplayStep& step)
+{
+    if (!opened || position >= data.size())
+    {
+        return false;
+    }
+    size_t cursor = position;
+    ReplayStep current = previous;
+    InputSnapshot& input = current.input;
+    uint8_t flags = static_cast<uint8_t>(data[cursor++]);
+    bool ok = true;
+    if (flags & REPLAY_DT)
+    {
+        ok = ok && getRaw(data, cursor, &current.deltaTime, sizeof(current.deltaTime));
+    }
+    if (ok && (flags & REPLAY_KEYS))
+    {
+        uint8_t count = 0;
+        ok = getRaw(data, cursor, &count, 1) && cursor + count <= data.size();
+        if (ok)
+        {
+            input.keys.assign(data.begin() + cursor, data.begin() + cursor + count);
+            cursor += count;
+        }
+    }
+    if (ok && (flags & REPLAY_SPECIAL))
+    {
+        uint8_t count = 0;
+        ok = getRaw(data, cursor, &count, 1);
+        input.specialKeys.clear();
+        for (uint8_t i = 0; ok && i < count; ++i)
+        {
+            uint16_t key = 0;
+            ok = getRaw(data, cursor, &key, sizeof(key));
+            if (ok)
+            {
+                input.specialKeys.push_back(key);
+            }
+        }
+    }
+    if (ok && (flags & REPLAY_BUTTONS))
+    {
+        ok = getRaw(data, cursor, &input.mouseButtons, 1);
+    }
+    if (ok && (flags & REPLAY_MOUSE))
+    {
+        int32_t dx = 0, dy = 0;
+        ok = getVarint(data, cursor, dx) && getVarint(data, cursor, dy);
+        input.mouseX += dx;
+        input.mouseY += dy;
+    }
+    if (!ok || flags > (REPLAY_MOUSE << 1) - 1)
+    {
+        std::cerr << "Replay truncated or corrupt after step " << steps << ", stopping there" << std::endl;
+        position = data.size();
+        return false;
+    }
+
+    position = cursor;
+    previous = current;
+    step = current;
+    steps++;
+    return true;
+}
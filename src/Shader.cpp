@@ -9,33 +9,136 @@
  */
 
 #include "Shader.h"
+#include "utils.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 
-Shader::Shader() : vertexShaderID(0), fragmentShaderID(0), programID(0) {}
+namespace {
+    // Header of a program binary cache file, followed by the binary itself
+    struct ProgramCacheHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t binaryFormat;
+        uint32_t binaryLength;
+    };
+
+    const char PROGRAM_CACHE_MAGIC[4] = {'S', 'H', 'B', 'N'};
+
+    // FNV-1a, the sources and the driver strings are separated by a zero byte
+    uint64_t hashBytes(uint64_t hash, const char* data, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t hashString(uint64_t hash, const char* text) {
+        if (text == nullptr) {
+            text = "";
+        }
+        hash = hashBytes(hash, text, strlen(text));
+        return hashBytes(hash, "", 1);
+    }
+}
+
+Shader::Shader() : vertexShaderID(0), fragmentShaderID(0), programID(0), linkPending(false) {}
 
 Shader::~Shader() {
     cleanup();
 }
 
 
+void Shader::enableParallelCompile() {
+#ifdef GL_KHR_parallel_shader_compile
+    if (GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu); // Implementation-chosen thread count
+    }
+#endif
+}
+
 bool Shader::loadShader(const char* vertexShaderPath, const char* fragmentShaderPath) {
+    return beginLoad(vertexShaderPath, fragmentShaderPath) && finishLoad();
+}
+
+bool Shader::beginLoad(const char* vertexShaderPath, const char* fragmentShaderPath) {
+    cleanup();
+    vertexPath = vertexShaderPath;
+    fragmentPath = fragmentShaderPath;
+
+    std::string vertexSource;
+    std::string fragmentSource;
+    if (!readSource(vertexShaderPath, vertexSource) || !readSource(fragmentShaderPath, fragmentSource)) return false;
+
+    // The key covers both sources and the driver, a driver update silently invalidates every entry
+    binaryCachePath.clear();
+    GLint binaryFormatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+    if (binaryFormatCount > 0) {
+        uint64_t key = 14695981039346656037ull;
+        key = hashString(key, vertexSource.c_str());
+        key = hashString(key, fragmentSource.c_str());
+        key = hashString(key, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+        key = hashString(key, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+        key = hashString(key, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.prog", static_cast<unsigned long long>(key));
+        binaryCachePath = std::string(SHADER_CACHE_DIR) + name;
+        if (loadProgramBinary()) {
+            return true;
+        }
+    }
+
     // 1. Compile vertex and fragment shaders
-    if (!compileShader(vertexShaderID, GL_VERTEX_SHADER, vertexShaderPath)) return false;
-    if (!compileShader(fragmentShaderID, GL_FRAGMENT_SHADER, fragmentShaderPath)) return false;
+    compileShader(vertexShaderID, GL_VERTEX_SHADER, vertexSource);
+    compileShader(fragmentShaderID, GL_FRAGMENT_SHADER, fragmentSource);
 
-    // 2. Link shader program
-    if (!linkShaderProgram()) return false;
+    // 2. Link shader program, the result is checked in finishLoad
+    linkShaderProgram();
+    linkPending = true;
+    return true;
+}
 
+bool Shader::finishLoad() {
+    if (programID == 0) {
+        return false; // beginLoad failed
+    }
+    if (!linkPending) {
+        return true; // Loaded from the binary cache
+    }
+    linkPending = false;
+
+    // Check for linking errors, a failed compile shows up here too
+    int success;
+    char infoLog[512];
+    glGetProgramiv(programID, GL_LINK_STATUS, &success);
+    if (!success) {
+        if (checkCompile(vertexShaderID, vertexPath) && checkCompile(fragmentShaderID, fragmentPath)) {
+            glGetProgramInfoLog(programID, 512, NULL, infoLog);
+            std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        cleanup();
+        return false;
+    }
+
+    glDeleteShader(vertexShaderID);   // Delete shaders as they are linked into program now and no longer necessary
+    glDeleteShader(fragmentShaderID); // Shader objects are deleted after linking
+    vertexShaderID = 0;
+    fragmentShaderID = 0;
+
+    saveProgramBinary();
+    cacheUniformLocations();
     return true; // Shader program loaded and linked successfully
 }
 
 
-bool Shader::compileShader(GLuint& shaderID, GLenum shaderType, const char* shaderPath) {
-    shaderID = glCreateShader(shaderType);
-    std::string shaderCode;
+bool Shader::readSource(const char* shaderPath, std::string& source) {
     std::ifstream shaderFile;
     shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit); // Enable exception throwing
     try {
@@ -43,15 +146,24 @@ bool Shader::compileShader(GLuint& shaderID, GLenum shaderType, const char* shad
         std::stringstream shaderStream;
         shaderStream << shaderFile.rdbuf();
         shaderFile.close();
-        shaderCode = shaderStream.str();
+        source = shaderStream.str();
     } catch (std::ifstream::failure& e) {
         std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << shaderPath << std::endl;
         return false;
     }
-    const char* shaderCodeCStr = shaderCode.c_str();
+    return true;
+}
+
+
+void Shader::compileShader(GLuint& shaderID, GLenum shaderType, const std::string& source) {
+    shaderID = glCreateShader(shaderType);
+    const char* shaderCodeCStr = source.c_str();
     glShaderSource(shaderID, 1, &shaderCodeCStr, NULL);
     glCompileShader(shaderID);
+}
 
+
+bool Shader::checkCompile(GLuint shaderID, const std::string& shaderPath) const {
     // Check for shader compile errors
     int success;
     char infoLog[512];
@@ -65,31 +177,131 @@ bool Shader::compileShader(GLuint& shaderID, GLenum shaderType, const char* shad
 }
 
 
-bool Shader::linkShaderProgram() {
+void Shader::linkShaderProgram() {
     programID = glCreateProgram();
     glAttachShader(programID, vertexShaderID);
     glAttachShader(programID, fragmentShaderID);
+    if (!binaryCachePath.empty()) {
+        glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(programID);
+}
 
-    // Check for linking errors
+
+bool Shader::loadProgramBinary() {
+    std::ifstream file(binaryCachePath, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    ProgramCacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || memcmp(header.magic, PROGRAM_CACHE_MAGIC, 4) != 0 ||
+        header.version != SHADER_CACHE_VERSION || header.binaryLength == 0) {
+        return false;
+    }
+    std::vector<char> binary(header.binaryLength);
+    if (!file.read(binary.data(), binary.size())) {
+        return false;
+    }
+
+    // The driver may still reject the binary, the program is then built from source
+    programID = glCreateProgram();
+    glProgramBinary(programID, header.binaryFormat, binary.data(), header.binaryLength);
     int success;
-    char infoLog[512];
     glGetProgramiv(programID, GL_LINK_STATUS, &success);
     if (!success) {
-        glGetProgramInfoLog(programID, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        glDeleteProgram(programID);
+        programID = 0;
         return false;
     }
 
-    glDeleteShader(vertexShaderID);   // Delete shaders as they are linked into program now and no longer necessary
-    glDeleteShader(fragmentShaderID); // Shader objects are deleted after linking
-    vertexShaderID = 0;
-    fragmentShaderID = 0;
-
+    cacheUniformLocations();
     return true;
 }
 
 
+void Shader::saveProgramBinary() const {
+    if (binaryCachePath.empty()) {
+        return;
+    }
+
+    GLint binaryLength = 0;
+    glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    if (binaryLength <= 0) {
+        return;
+    }
+    std::vector<char> binary(binaryLength);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(programID, binaryLength, &binaryLength, &binaryFormat, binary.data());
+
+    makeParentDirectories(binaryCachePath); // A failure shows up when the file is opened
+
+    // Written under a temporary name so a crash never leaves a truncated cache behind
+    std::string temporaryPath = binaryCachePath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot write shader cache: " << binaryCachePath << std::endl;
+            return;
+        }
+
+        ProgramCacheHeader header;
+        memcpy(header.magic, PROGRAM_CACHE_MAGIC, 4);
+        header.version = SHADER_CACHE_VERSION;
+        header.binaryFormat = binaryFormat;
+        header.binaryLength = static_cast<uint32_t>(binaryLength);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), binaryLength);
+    }
+    std::rename(temporaryPath.c_str(), binaryCachePath.c_str());
+}
+
+
+void Shader::cacheUniformLocations() {
+    uniformLocations.clear();
+
+    GLint uniformCount = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<char> nameBuffer(maxNameLength > 0 ? maxNameLength : 1);
+    for (GLint i = 0; i < uniformCount; ++i) {
+        GLsizei nameLength = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(programID, i, maxNameLength, &nameLength, &size, &type, nameBuffer.data());
+
+        std::string name(nameBuffer.data(), nameLength);
+        GLint location = glGetUniformLocation(programID, name.c_str());
+        if (location < 0) {
+            continue; // Member of a uniform block, set through its buffer
+        }
+
+        // Arrays are reported as "name[0]", keep both spellings
+        uniformLocations[name] = location;
+        size_t bracket = name.find('[');
+        if (bracket != std::string::npos) {
+            uniformLocations[name.substr(0, bracket)] = location;
+        }
+    }
+}
+
+GLint Shader::getUniformLocation(const std::string& name) const {
+    auto found = uniformLocations.find(name);
+    return found != uniformLocations.end() ? found->second : -1;
+}
+
+bool Shader::bindUniformBlock(const char* blockName, GLuint binding) const {
+    GLuint blockIndex = glGetUniformBlockIndex(programID, blockName);
+    if (blockIndex == GL_INVALID_INDEX) {
+        std::cerr << "ERROR::SHADER::UNIFORM_BLOCK_NOT_FOUND: " << blockName << std::endl;
+        return false;
+    }
+    glUniformBlockBinding(programID, blockIndex, binding);
+    return true;
+}
+
 void Shader::use() {
     glUseProgram(programID);
 }
@@ -99,28 +311,59 @@ void Shader::unuse() {
 }
 
 void Shader::cleanup() {
+    if (vertexShaderID != 0) {
+        glDeleteShader(vertexShaderID);
+        vertexShaderID = 0;
+    }
+    if (fragmentShaderID != 0) {
+        glDeleteShader(fragmentShaderID);
+        fragmentShaderID = 0;
+    }
+    linkPending = false;
     if (programID != 0) {
         glDeleteProgram(programID);
         programID = 0;
     }
+    uniformLocations.clear();
 }
 
 
 void Shader::setInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(programID, name.c_str()), value);
+    setInt(getUniformLocation(name), value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(programID, name.c_str()), value);
+    setFloat(getUniformLocation(name), value);
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
-    glUniform3fv(glGetUniformLocation(programID, name.c_str()), 1, glm::value_ptr(value));
+    setVec3(getUniformLocation(name), value);
 }
 
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(programID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    setMat4(getUniformLocation(name), mat);
 }
+
 void Shader::setMat3(const std::string& name, const glm::mat3& mat) const {
-     glUniformMatrix3fv(glGetUniformLocation(programID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
-}
\ No newline at end of file
+    setMat3(getUniformLocation(name), mat);
+}
+
+void Shader::setInt(GLint location, int value) const {
+    glUniform1i(location, value);
+}
+
+void Shader::setFloat(GLint location, float value) const {
+    glUniform1f(location, value);
+}
+
+void Shader::setVec3(GLint location, const glm::vec3& value) const {
+    glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+void Shader::setMat4(GLint location, const glm::mat4& mat) const {
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::setMat3(GLint location, const glm::mat3& mat) const {
+    glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+}
@@ -13,8 +13,20 @@
 #include <cmath>
 #include <glm/gtc/constants.hpp>
 #include <iostream>
-#include "utils.h" // Include utils.h for checkGLError
+#include "GLDebug.h"
+#include "ThreadPool.h"
 #include <GL/glew.h>
+#include <algorithm>
+#include <immintrin.h>
+
+#define TERRAIN_HEIGHT_SCALE 40.0f // Adjust this to control terrain height scale
+#define TERRAIN_HEIGHT_OFFSET 15.0f
+
+// Red channel of the heightmap to world height
+static inline float sampleHeight(unsigned char value)
+{
+    return static_cast<float>(value) / 255.0f * TERRAIN_HEIGHT_SCALE - TERRAIN_HEIGHT_OFFSET;
+}
 
 Terrain::Terrain(int gridSize, float gridSpacing)
     : gridSize(gridSize),
@@ -25,155 +37,440 @@ Terrain::Terrain(int gridSize, float gridSpacing)
       vertexBufferID(0),
       normalBufferID(0),
       texCoordBufferID(0),
-      indexBufferID(0),
+      tileIndices(nullptr),
       vaoID(0),
-      indexCount(0) {}
+      skirtDepth(0.0f),
+      streamFrame(0) {}
 
 Terrain::~Terrain() {
     cleanup();
 }
 
-bool Terrain::init(GLuint heightMapTextureID) {
-    generateGrid(heightMapTextureID);
+bool Terrain::init(const char* heightMapPath) {
+    if (!generate(heightMapPath)) {
+        return false;
+    }
     createBuffers();
     return true;
 }
 
+bool Terrain::generate(const char* heightMapPath) {
+    // Decoded on the CPU, no texture readback (and no GL context) needed
+    if (!decodeImage(heightMapPath, heightMap)) {
+        std::cerr << "Error loading terrain heightmap: " << heightMapPath << std::endl;
+        return false;
+    }
+    generateGrid();
+    buildLOD();
+    return true;
+}
+
 void Terrain::cleanup() {
+    if (vaoID == 0) { // Headless or already released
+        return;
+    }
     glDeleteBuffers(1, &vertexBufferID);
     glDeleteBuffers(1, &normalBufferID);
     glDeleteBuffers(1, &texCoordBufferID);
-    glDeleteBuffers(1, &indexBufferID);
+    releaseGridIndexBuffer(tileIndices);
+    tileIndices = nullptr;
     glDeleteVertexArrays(1, &vaoID);
+    vertexBufferID = normalBufferID = texCoordBufferID = vaoID = 0;
+    for (TerrainNode& node : nodes) {
+        node.slot = -1;
+    }
+    slotNodes.clear();
+    slotFrames.clear();
 }
 
 
 
-void Terrain::generateGrid(GLuint heightMapTextureID) {
+void Terrain::generateGrid() {
 
     std::cout << "Terrain::generateGrid - gridSize: " << gridSize << std::endl;
     vertices.resize(gridSize * gridSize);
     normals.resize(gridSize * gridSize);
     texCoords.resize(gridSize * gridSize);
 
-    // **Access Heightmap Texture Data**
-    glBindTexture(GL_TEXTURE_2D, heightMapTextureID); // Bind heightmap texture
-    GLint textureWidth, textureHeight;
-    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &textureWidth); // Get texture width
-    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &textureHeight); // Get texture height
-
-    std::vector<unsigned char> heightmapData(textureWidth * textureHeight); // Assuming 8-bit grayscale heightmap
-    glPixelStorei(GL_PACK_ALIGNMENT, 1);
-
-    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_UNSIGNED_BYTE, heightmapData.data()); // Get texture pixel data (Red channel = grayscale height)
-    glBindTexture(GL_TEXTURE_2D, 0); // Unbind texture
-
-    float heightScale = 40.0f; // Adjust this to control terrain height scale
+    int textureWidth = heightMap.width;
+    int textureHeight = heightMap.height;
+    int sampledWidth = std::min(gridSize, textureWidth);   // Grid points outside the heightmap stay at 0
+    int sampledHeight = std::min(gridSize, textureHeight);
+
+    // **Sample height from heightmap** - imageHeights[z * gridSize + x] follows the image rows, so 8 pixels are read at once
+    std::vector<float> imageHeights(gridSize * gridSize, 0.0f);
+    ThreadPool::instance().parallelFor(sampledHeight, [&](size_t z) {
+        const unsigned char* row = heightMap.pixels.data() + z * textureWidth * 4;
+        float* rowHeights = imageHeights.data() + z * gridSize;
+
+        const __m128i redMask = _mm_set1_epi32(0xFF); // RGBA8, red is the low byte
+        const __m256 divisor = _mm256_set1_ps(255.0f);
+        const __m256 scale = _mm256_set1_ps(TERRAIN_HEIGHT_SCALE);
+        const __m256 offset = _mm256_set1_ps(TERRAIN_HEIGHT_OFFSET);
+
+        int x = 0;
+        for (; x + 8 <= sampledWidth; x += 8) {
+            __m128i low = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4)), redMask);
+            __m128i high = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4 + 16)), redMask);
+            __m256 red = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_cvtepi32_ps(low)), _mm_cvtepi32_ps(high), 1);
+            // Same operations as sampleHeight, so the result is bit-identical
+            _mm256_storeu_ps(rowHeights + x, _mm256_sub_ps(_mm256_mul_ps(_mm256_div_ps(red, divisor), scale), offset));
+        }
+        for (; x < sampledWidth; ++x) {
+            rowHeights[x] = sampleHeight(row[x * 4]);
+        }
+    });
 
-    for (int x = 0; x < gridSize; ++x) {
+    heights.resize(gridSize * gridSize);
+    ThreadPool::instance().parallelFor(gridSize, [&](size_t x) {
         for (int z = 0; z < gridSize; ++z) {
             float worldX = (x - gridSize / 2.0f) * gridSpacing;
             float worldZ = (z - gridSize / 2.0f) * gridSpacing;
 
-            // **Sample height from heightmap texture**
-            float height = 0.0f;
-            if (x < textureWidth && z < textureHeight && x >= 0 && z >= 0) { // Bounds check - important!
-                height = static_cast<float>(heightmapData[z * textureWidth + x]) / 255.0f * heightScale-15.0; // Normalize to [0, 1], scale by heightScale
+            float height = imageHeights[z * gridSize + x];
+            heights[x * gridSize + z] = height;
+            vertices[x * gridSize + z] = glm::vec3(worldX, height, worldZ); // Set vertex position with height from heightmap
+            texCoords[x * gridSize + z] = glm::vec2(static_cast<float>(x) / 50.0f, static_cast<float>(z) / 50.0f); // Example texture tiling
+        }
+    });
+    std::cout << "Width: " << textureWidth << "Geight: " << textureHeight << std::endl;
+
+    bakeNormals();
+}
+
+void Terrain::bakeNormals() {
+    normals.resize(gridSize * gridSize);
+    slopes.resize(gridSize * gridSize);
+    curvatures.resize(gridSize * gridSize);
+    if (gridSize < 2) {
+        std::fill(normals.begin(), normals.end(), glm::vec3(0.0f, 1.0f, 0.0f));
+        return;
+    }
+
+    const float inverseSpacingSquared = 1.0f / (gridSpacing * gridSpacing);
+    const float inverseDz = 1.0f / (2.0f * gridSpacing);
+
+    // One task per x row, the z direction is contiguous and goes through AVX 8 vertices at a time
+    ThreadPool::instance().parallelFor(gridSize, [&](size_t xIndex) {
+        int x = static_cast<int>(xIndex);
+        int xMinus = std::max(x - 1, 0);
+        int xPlus = std::min(x + 1, gridSize - 1);
+        const float* row = heights.data() + x * gridSize;
+        const float* rowMinus = heights.data() + xMinus * gridSize;
+        const float* rowPlus = heights.data() + xPlus * gridSize;
+        const float inverseDx = 1.0f / ((xPlus - xMinus) * gridSpacing); // One-sided difference on the border
+
+        std::vector<float> gradientX(gridSize), gradientZ(gridSize);
+        float* slopeRow = slopes.data() + x * gridSize;
+        float* curvatureRow = curvatures.data() + x * gridSize;
+
+        // Border vertices clamp their neighbours
+        auto scalarVertex = [&](int z) {
+            int zMinus = std::max(z - 1, 0);
+            int zPlus = std::min(z + 1, gridSize - 1);
+            gradientX[z] = (rowPlus[z] - rowMinus[z]) * inverseDx;
+            gradientZ[z] = (row[zPlus] - row[zMinus]) / ((zPlus - zMinus) * gridSpacing);
+            curvatureRow[z] = (rowPlus[z] + rowMinus[z] + row[zPlus] + row[zMinus] - 4.0f * row[z]) * inverseSpacingSquared;
+        };
+
+        scalarVertex(0);
+        const __m256 dxScale = _mm256_set1_ps(inverseDx);
+        const __m256 dzScale = _mm256_set1_ps(inverseDz);
+        const __m256 laplacianScale = _mm256_set1_ps(inverseSpacingSquared);
+        const __m256 four = _mm256_set1_ps(4.0f);
+        int z = 1;
+        for (; z + 8 <= gridSize - 1; z += 8) {
+            __m256 center = _mm256_loadu_ps(row + z);
+            __m256 plusX = _mm256_loadu_ps(rowPlus + z);
+            __m256 minusX = _mm256_loadu_ps(rowMinus + z);
+            __m256 plusZ = _mm256_loadu_ps(row + z + 1);
+            __m256 minusZ = _mm256_loadu_ps(row + z - 1);
+
+            _mm256_storeu_ps(&gradientX[z], _mm256_mul_ps(_mm256_sub_ps(plusX, minusX), dxScale));
+            _mm256_storeu_ps(&gradientZ[z], _mm256_mul_ps(_mm256_sub_ps(plusZ, minusZ), dzScale));
+            __m256 neighbours = _mm256_add_ps(_mm256_add_ps(plusX, minusX), _mm256_add_ps(plusZ, minusZ));
+            _mm256_storeu_ps(curvatureRow + z, _mm256_mul_ps(_mm256_sub_ps(neighbours, _mm256_mul_ps(four, center)), laplacianScale));
+        }
+        for (; z < gridSize; ++z) {
+            scalarVertex(z);
+        }
 
-            } else {
-                // Handle out-of-bounds access (e.g., set height to 0 or a default value)
-                height = 0.0f;
+        // n = normalize(-dh/dx, 1, -dh/dz), slope = |grad h|
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        glm::vec3* normalRow = normals.data() + x * gridSize;
+        float components[3][8];
+        z = 0;
+        for (; z + 8 <= gridSize; z += 8) {
+            __m256 gx = _mm256_loadu_ps(&gradientX[z]);
+            __m256 gz = _mm256_loadu_ps(&gradientZ[z]);
+            __m256 gradientSquared = _mm256_add_ps(_mm256_mul_ps(gx, gx), _mm256_mul_ps(gz, gz));
+            __m256 inverseLength = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_add_ps(gradientSquared, one)));
+
+            _mm256_storeu_ps(slopeRow + z, _mm256_sqrt_ps(gradientSquared));
+            _mm256_storeu_ps(components[0], _mm256_xor_ps(_mm256_mul_ps(gx, inverseLength), signMask));
+            _mm256_storeu_ps(components[1], inverseLength);
+            _mm256_storeu_ps(components[2], _mm256_xor_ps(_mm256_mul_ps(gz, inverseLength), signMask));
+            for (int i = 0; i < 8; ++i) {
+                normalRow[z + i] = glm::vec3(components[0][i], components[1][i], components[2][i]);
             }
+        }
+        for (; z < gridSize; ++z) {
+            float gradientSquared = gradientX[z] * gradientX[z] + gradientZ[z] * gradientZ[z];
+            float inverseLength = 1.0f / std::sqrt(gradientSquared + 1.0f);
+            slopeRow[z] = std::sqrt(gradientSquared);
+            normalRow[z] = glm::vec3(-gradientX[z] * inverseLength, inverseLength, -gradientZ[z] * inverseLength);
+        }
+    });
+}
 
-            //vertices[x * gridSize + z] = glm::vec3(worldX, height, worldZ); // Set vertex position with height from heightmap
-            vertices[x * gridSize + z] = glm::vec3(worldX, height, worldZ); // Flat terrain at y=0
-            normals[x * gridSize + z] = glm::vec3(0.0f, 1.0f, 0.0f);    // Upward normals for flat terrain
-            texCoords[x * gridSize + z] = glm::vec2(static_cast<float>(x) / 50.0f, static_cast<float>(z) / 50.0f); // Example texture tiling
-            //originalWorldX[x * gridSize + z] = worldX;
-            //originalWorldZ[x * gridSize + z] = worldZ;
+
+int Terrain::buildNode(int level, int originX, int originZ) {
+    if (originX >= gridSize - 1 || originZ >= gridSize - 1) {
+        return -1; // Tile lies past the edge of the grid
+    }
+
+    int index = static_cast<int>(nodes.size());
+    nodes.emplace_back();
+    nodes[index].level = level;
+    nodes[index].originX = originX;
+    nodes[index].originZ = originZ;
+    nodes[index].slot = -1;
+    nodes[index].error = 0.0f;
+
+    int half = (TERRAIN_TILE_QUADS << level) / 2;
+    for (int child = 0; child < 4; ++child) {
+        int childIndex = level > 0 ? buildNode(level - 1, originX + (child & 1) * half, originZ + (child >> 1) * half) : -1;
+        nodes[index].children[child] = childIndex; // nodes may have been reallocated, no references kept
+    }
+    return index;
+}
+
+void Terrain::buildLOD() {
+    nodes.clear();
+    if (gridSize < 2) {
+        return;
+    }
+
+    int rootLevel = 0;
+    while ((TERRAIN_TILE_QUADS << rootLevel) < gridSize - 1) {
+        rootLevel++;
+    }
+    buildNode(rootLevel, 0, 0);
+
+    const int Q = TERRAIN_TILE_QUADS;
+    auto height = [&](int x, int z) { return heights[x * gridSize + z]; };
+
+    // Errors and bounds, every tile against the full-resolution grid it covers
+    ThreadPool::instance().parallelFor(nodes.size(), [&](size_t index) {
+        TerrainNode& node = nodes[index];
+        int step = 1 << node.level;
+        int endX = std::min(node.originX + (Q << node.level), gridSize - 1);
+        int endZ = std::min(node.originZ + (Q << node.level), gridSize - 1);
+
+        float minHeight = height(node.originX, node.originZ);
+        float maxHeight = minHeight;
+        float error = 0.0f;
+        for (int x = node.originX; x <= endX; ++x) {
+            // Tile cell containing x, its corners are clamped to the grid like the tile vertices
+            int cellX = std::min((x - node.originX) / step, Q - 1);
+            int x0 = std::min(node.originX + cellX * step, gridSize - 1);
+            int x1 = std::min(x0 + step, gridSize - 1);
+            float tx = x1 > x0 ? static_cast<float>(x - x0) / (x1 - x0) : 0.0f;
+
+            for (int z = node.originZ; z <= endZ; ++z) {
+                float h = height(x, z);
+                minHeight = std::min(minHeight, h);
+                maxHeight = std::max(maxHeight, h);
+                if (node.level == 0) {
+                    continue;
+                }
+
+                int cellZ = std::min((z - node.originZ) / step, Q - 1);
+                int z0 = std::min(node.originZ + cellZ * step, gridSize - 1);
+                int z1 = std::min(z0 + step, gridSize - 1);
+                float tz = z1 > z0 ? static_cast<float>(z - z0) / (z1 - z0) : 0.0f;
+
+                // Same split as the tile triangles (v00, v10, v11) and (v00, v11, v01)
+                float h00 = height(x0, z0), h10 = height(x1, z0), h11 = height(x1, z1), h01 = height(x0, z1);
+                float interpolated = tx >= tz ? h00 + tx * (h10 - h00) + tz * (h11 - h10)
+                                              : h00 + tz * (h01 - h00) + tx * (h11 - h01);
+                error = std::max(error, std::fabs(h - interpolated));
+            }
+        }
+
+        node.error = error;
+        node.boundsMin = glm::vec3(vertices[node.originX * gridSize].x, minHeight, vertices[node.originZ].z);
+        node.boundsMax = glm::vec3(vertices[endX * gridSize].x, maxHeight, vertices[endZ].z);
+    });
+
+    // Children come after their parent, so a reverse pass makes the error grow towards the root
+    for (size_t index = nodes.size(); index-- > 0;) {
+        for (int child : nodes[index].children) {
+            if (child >= 0) {
+                nodes[index].error = std::max(nodes[index].error, nodes[child].error);
+            }
         }
     }
-    std::cout << "Width: " << textureWidth << "Geight: " << textureHeight << std::endl;
+
+    // A crack between two tiles is at most the error of the coarser one, so skirts as deep as the root error hide all of them
+    skirtDepth = TERRAIN_SKIRT_MIN_DEPTH + nodes[0].error;
+    for (TerrainNode& node : nodes) {
+        node.boundsMin.y -= skirtDepth;
+    }
+
+    std::cout << "Terrain LOD: " << nodes.size() << " tiles, " << rootLevel + 1 << " levels, root error " << nodes[0].error << std::endl;
+}
+
+void Terrain::buildTile(const TerrainNode& node) {
+    const int Q = TERRAIN_TILE_QUADS;
+    int step = 1 << node.level;
+    tilePositions.resize(TERRAIN_TILE_VERTICES);
+    tileNormals.resize(TERRAIN_TILE_VERTICES);
+    tileTexCoords.resize(TERRAIN_TILE_VERTICES);
+
+    auto copyVertex = [&](int tileVertex, int i, int j, float drop) {
+        int source = std::min(node.originX + i * step, gridSize - 1) * gridSize + std::min(node.originZ + j * step, gridSize - 1);
+        tilePositions[tileVertex] = vertices[source] - glm::vec3(0.0f, drop, 0.0f);
+        tileNormals[tileVertex] = normals[source];
+        tileTexCoords[tileVertex] = texCoords[source];
+    };
+
+    for (int i = 0; i <= Q; ++i) {
+        for (int j = 0; j <= Q; ++j) {
+            copyVertex(i * (Q + 1) + j, i, j, 0.0f);
+        }
+    }
+    // Skirt ring: z = 0 edge, x = Q edge, z = Q edge, x = 0 edge
+    for (int k = 0; k <= Q; ++k) {
+        copyVertex(TERRAIN_TILE_GRID_VERTICES + 0 * (Q + 1) + k, k, 0, skirtDepth);
+        copyVertex(TERRAIN_TILE_GRID_VERTICES + 1 * (Q + 1) + k, Q, k, skirtDepth);
+        copyVertex(TERRAIN_TILE_GRID_VERTICES + 2 * (Q + 1) + k, k, Q, skirtDepth);
+        copyVertex(TERRAIN_TILE_GRID_VERTICES + 3 * (Q + 1) + k, 0, k, skirtDepth);
+    }
 }
 
+void Terrain::selectTiles(const Frustum& frustum, const glm::vec3& eye, float pixelScale, std::vector<int>& tiles) const {
+    tiles.clear();
+    if (nodes.empty() || !frustum.intersects(nodes[0].boundsMin, nodes[0].boundsMax)) {
+        return;
+    }
+
+    auto screenError = [&](const TerrainNode& node) {
+        glm::vec3 outside(std::max(std::max(node.boundsMin.x - eye.x, eye.x - node.boundsMax.x), 0.0f),
+                          std::max(std::max(node.boundsMin.y - eye.y, eye.y - node.boundsMax.y), 0.0f),
+                          std::max(std::max(node.boundsMin.z - eye.z, eye.z - node.boundsMax.z), 0.0f));
+        return node.error * pixelScale / std::max(glm::length(outside), 1e-3f);
+    };
+
+    // Always split the tile with the largest screen error first, until it is small enough or the budget is used up
+    std::vector<std::pair<float, int>> open;
+    open.push_back(std::make_pair(screenError(nodes[0]), 0));
+    size_t tileCount = 1;
+
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end());
+        float error = open.back().first;
+        int index = open.back().second;
+        const TerrainNode& node = nodes[index];
+        open.pop_back();
+
+        int visibleChildren[4];
+        size_t visibleCount = 0;
+        if (error > TERRAIN_MAX_PIXEL_ERROR) {
+            for (int child : node.children) {
+                if (child >= 0 && frustum.intersects(nodes[child].boundsMin, nodes[child].boundsMax)) {
+                    visibleChildren[visibleCount++] = child;
+                }
+            }
+        }
+
+        // The parent box can touch the frustum while none of the child boxes do, the parent is drawn then
+        bool split = error > TERRAIN_MAX_PIXEL_ERROR && node.level > 0 && visibleCount > 0 &&
+                     tileCount - 1 + visibleCount <= TERRAIN_MAX_TILES;
+        if (!split) {
+            tiles.push_back(index);
+            continue;
+        }
+
+        tileCount = tileCount - 1 + visibleCount;
+        for (size_t i = 0; i < visibleCount; ++i) {
+            open.push_back(std::make_pair(screenError(nodes[visibleChildren[i]]), visibleChildren[i]));
+            std::push_heap(open.begin(), open.end());
+        }
+    }
+}
+
+void Terrain::streamTiles(const std::vector<int>& tiles, std::vector<GLint>& baseVertices) {
+    baseVertices.clear();
+    streamFrame++;
+    for (int tile : tiles) { // Marked first, so uploads of this frame never evict a tile it draws
+        if (nodes[tile].slot >= 0) {
+            slotFrames[nodes[tile].slot] = streamFrame;
+        }
+    }
+
+    for (int tile : tiles) {
+        TerrainNode& node = nodes[tile];
+        if (node.slot < 0) {
+            GL_DEBUG_SCOPE("Terrain::streamTiles");
+            int slot = static_cast<int>(std::min_element(slotFrames.begin(), slotFrames.end()) - slotFrames.begin());
+            if (slotNodes[slot] >= 0) {
+                nodes[slotNodes[slot]].slot = -1;
+            }
+            slotNodes[slot] = tile;
+            node.slot = slot;
+
+            buildTile(node);
+            GLintptr first = static_cast<GLintptr>(slot) * TERRAIN_TILE_VERTICES;
+            glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+            glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec3), TERRAIN_TILE_VERTICES * sizeof(glm::vec3), tilePositions.data());
+            glBindBuffer(GL_ARRAY_BUFFER, normalBufferID);
+            glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec3), TERRAIN_TILE_VERTICES * sizeof(glm::vec3), tileNormals.data());
+            glBindBuffer(GL_ARRAY_BUFFER, texCoordBufferID);
+            glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec2), TERRAIN_TILE_VERTICES * sizeof(glm::vec2), tileTexCoords.data());
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        slotFrames[node.slot] = streamFrame;
+        baseVertices.push_back(node.slot * TERRAIN_TILE_VERTICES);
+    }
+}
 
 void Terrain::createBuffers() {
-    glGenVertexArrays(1, &vaoID);
-    checkGLError("1"); // Check after drawMeshVBO call
+    GL_DEBUG_SCOPE("Terrain::createBuffers");
+    // Only the resident slots live on the GPU, a small terrain gets one slot per tile
+    size_t slotCount = std::min(nodes.size(), static_cast<size_t>(TERRAIN_RESIDENT_TILES));
+    size_t vertexCount = slotCount * TERRAIN_TILE_VERTICES;
+    slotNodes.assign(slotCount, -1);
+    slotFrames.assign(slotCount, 0);
+    streamFrame = 0;
 
+    glGenVertexArrays(1, &vaoID);
     glBindVertexArray(vaoID);
-    checkGLError("2"); // Check after drawMeshVBO call
 
     glGenBuffers(1, &vertexBufferID);
-    checkGLError("3"); // Check after drawMeshVBO call
-
     glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
-    checkGLError("4"); // Check after drawMeshVBO call
-
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
-    checkGLError("5"); // Check after drawMeshVBO call
-
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    checkGLError("6"); // Check after drawMeshVBO call
-
     glEnableVertexAttribArray(0);
-    checkGLError("7"); // Check after drawMeshVBO call
 
     glGenBuffers(1, &normalBufferID);
-    checkGLError("8"); // Check after drawMeshVBO call
-
     glBindBuffer(GL_ARRAY_BUFFER, normalBufferID);
-    checkGLError("9"); // Check after drawMeshVBO call
-
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
-    checkGLError("10"); // Check after drawMeshVBO call
-
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    checkGLError("11"); // Check after drawMeshVBO call
-
     glEnableVertexAttribArray(1);
-    checkGLError("12"); // Check after drawMeshVBO call
-
 
     glGenBuffers(1, &texCoordBufferID);
-    checkGLError("13"); // Check after drawMeshVBO call
-
     glBindBuffer(GL_ARRAY_BUFFER, texCoordBufferID);
-    checkGLError("14"); // Check after drawMeshVBO call
-
-    glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
-    checkGLError("15"); // Check after drawMeshVBO call
-
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(glm::vec2), nullptr, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
-    checkGLError("16"); // Check after drawMeshVBO call
-
     glEnableVertexAttribArray(2);
-    checkGLError("17"); // Check after drawMeshVBO call
 
-
-    std::vector<unsigned int> indices;
-    for (int x = 0; x < gridSize - 1; ++x) {
-        for (int z = 0; z < gridSize - 1; ++z) {
-            unsigned int v00 = x * gridSize + z;
-            unsigned int v10 = (x + 1) * gridSize + z;
-            unsigned int v11 = (x + 1) * gridSize + (z + 1);
-            unsigned int v01 = x * gridSize + (z + 1);
-            indices.insert(indices.end(), {v00, v10, v11, v01});
-        }
-    }
-    glGenBuffers(1, &indexBufferID);
-    checkGLError("glGenBuffers - indexBufferID"); // Check after glGenBuffers
-    
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
-    checkGLError("18"); // Check after drawMeshVBO call
-
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-    checkGLError("19"); // Check after drawMeshVBO call
+    // One strip index buffer for every tile, drawn with a base vertex
+    tileIndices = acquireGridIndexBuffer(TERRAIN_TILE_QUADS + 1, TERRAIN_TILE_QUADS + 1, true);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tileIndices->bufferID);
 
     glBindVertexArray(0);
-    checkGLError("20"); // Check after drawMeshVBO call
-
-    indexCount = indices.size();
 }
 
 void Terrain::updateBuffers() {
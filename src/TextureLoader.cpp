@@ -0,0 +1,624 @@
+/*
+ * File:        TextureLoader.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Asynchronous texture decoding, mip chain cache and budgeted GL upload
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "TextureLoader.h"
+#include "utils.h"
+#include <SOIL/SOIL.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace
+{
+    // Header of a cache file, followed by (width, height, byteSize, data) for every level
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceSize;  // Source file size and modification time, a change invalidates the cache
+        int64_t sourceMtime;
+        uint32_t compressed;
+        uint32_t levelCount;
+    };
+
+    const char CACHE_MAGIC[4] = {'T', 'X', 'C', 'H'};
+
+    std::string cachePath(const std::string &filename, bool compress)
+    {
+        std::string name = filename;
+        std::replace(name.begin(), name.end(), '/', '_');
+        std::replace(name.begin(), name.end(), '\\', '_');
+        std::replace(name.begin(), name.end(), ':', '_');
+        return TEXTURE_CACHE_DIR + name + (compress ? ".bc1" : ".rgba") + ".tex";
+    }
+
+    // 2x2 box filter, the last row/column is repeated for odd sizes
+    void downsample(const unsigned char *src, int width, int height, unsigned char *dst, int dstWidth, int dstHeight)
+    {
+        for (int y = 0; y < dstHeight; ++y)
+        {
+            int y0 = std::min(2 * y, height - 1);
+            int y1 = std::min(2 * y + 1, height - 1);
+            for (int x = 0; x < dstWidth; ++x)
+            {
+                int x0 = std::min(2 * x, width - 1);
+                int x1 = std::min(2 * x + 1, width - 1);
+                for (int c = 0; c < 4; ++c)
+                {
+                    int sum = src[(y0 * width + x0) * 4 + c] + src[(y0 * width + x1) * 4 + c] +
+                              src[(y1 * width + x0) * 4 + c] + src[(y1 * width + x1) * 4 + c];
+                    dst[(y * dstWidth + x) * 4 + c] = static_cast<unsigned char>((sum + 2) >> 2);
+                }
+            }
+        }
+    }
+
+    inline unsigned short toRGB565(const int *color)
+    {
+        return static_cast<unsigned short>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+    }
+
+    inline void fromRGB565(unsigned short value, int *color)
+    {
+        int r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // BC1 block from the inset colour bounding box (fast, no alpha)
+    void compressBlock(const unsigned char *block, unsigned char *out)
+    {
+        int minColor[3] = {255, 255, 255};
+        int maxColor[3] = {0, 0, 0};
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                minColor[c] = std::min(minColor[c], static_cast<int>(block[i * 4 + c]));
+                maxColor[c] = std::max(maxColor[c], static_cast<int>(block[i * 4 + c]));
+            }
+        }
+        for (int c = 0; c < 3; ++c)
+        {
+            int inset = (maxColor[c] - minColor[c]) >> 4;
+            minColor[c] += inset;
+            maxColor[c] -= inset;
+        }
+
+        unsigned short color0 = toRGB565(maxColor);
+        unsigned short color1 = toRGB565(minColor);
+        uint32_t selectors = 0;
+
+        if (color0 != color1)
+        {
+            // color0 > color1 selects the opaque 4 colour mode
+            int palette[4][3];
+            fromRGB565(color0, palette[0]);
+            fromRGB565(color1, palette[1]);
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for (int i = 0; i < 16; ++i)
+            {
+                int best = 0;
+                int bestDistance = 1 << 30;
+                for (int p = 0; p < 4; ++p)
+                {
+                    int distance = 0;
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        int d = block[i * 4 + c] - palette[p][c];
+                        distance += d * d;
+                    }
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                selectors |= static_cast<uint32_t>(best) << (2 * i);
+            }
+        }
+
+        out[0] = color0 & 0xFF;
+        out[1] = color0 >> 8;
+        out[2] = color1 & 0xFF;
+        out[3] = color1 >> 8;
+        for (int i = 0; i < 4; ++i)
+        {
+            out[4 + i] = (selectors >> (8 * i)) & 0xFF;
+        }
+    }
+
+    std::vector<unsigned char> compressBC1(const std::vector<unsigned char> &rgba, int width, int height)
+    {
+        int blocksX = (width + 3) / 4;
+        int blocksY = (height + 3) / 4;
+        std::vector<unsigned char> blocks(blocksX * blocksY * 8);
+        unsigned char block[16 * 4];
+
+        for (int by = 0; by < blocksY; ++by)
+        {
+            for (int bx = 0; bx < blocksX; ++bx)
+            {
+                // Edge blocks repeat the last row/column
+                for (int i = 0; i < 16; ++i)
+                {
+                    int x = std::min(bx * 4 + (i & 3), width - 1);
+                    int y = std::min(by * 4 + (i >> 2), height - 1);
+                    memcpy(block + i * 4, &rgba[(y * width + x) * 4], 4);
+                }
+                compressBlock(block, &blocks[(by * blocksX + bx) * 8]);
+            }
+        }
+        return blocks;
+    }
+
+    bool readCache(const std::string &path, const struct stat &source, bool &compressed, std::vector<std::vector<unsigned char>> &data,
+                   std::vector<std::pair<int, int>> &sizes)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        CacheHeader header;
+        if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || memcmp(header.magic, CACHE_MAGIC, 4) != 0 ||
+            header.version != TEXTURE_CACHE_VERSION || header.sourceSize != static_cast<uint64_t>(source.st_size) ||
+            header.sourceMtime != static_cast<int64_t>(source.st_mtime) || header.levelCount == 0 || header.levelCount > 32)
+        {
+            return false;
+        }
+
+        compressed = header.compressed != 0;
+        data.resize(header.levelCount);
+        sizes.resize(header.levelCount);
+        for (uint32_t level = 0; level < header.levelCount; ++level)
+        {
+            uint32_t levelInfo[3]; // width, height, byteSize
+            if (!file.read(reinterpret_cast<char *>(levelInfo), sizeof(levelInfo)))
+            {
+                return false;
+            }
+            sizes[level] = std::make_pair(static_cast<int>(levelInfo[0]), static_cast<int>(levelInfo[1]));
+            data[level].resize(levelInfo[2]);
+            if (!file.read(reinterpret_cast<char *>(data[level].data()), levelInfo[2]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void writeCache(const std::string &path, const struct stat &source, bool compressed, const std::vector<std::vector<unsigned char>> &data,
+                    const std::vector<std::pair<int, int>> &sizes)
+    {
+        makeParentDirectories(path); // A failure shows up when the file is opened
+
+        // Written under a temporary name so a crash never leaves a truncated cache behind
+        std::string temporaryPath = path + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary);
+            if (!file)
+            {
+                std::cerr << "Cannot write texture cache: " << path << std::endl;
+                return;
+            }
+
+            CacheHeader header;
+            memcpy(header.magic, CACHE_MAGIC, 4);
+            header.version = TEXTURE_CACHE_VERSION;
+            header.sourceSize = static_cast<uint64_t>(source.st_size);
+            header.sourceMtime = static_cast<int64_t>(source.st_mtime);
+            header.compressed = compressed ? 1 : 0;
+            header.levelCount = static_cast<uint32_t>(data.size());
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+            for (size_t level = 0; level < data.size(); ++level)
+            {
+                uint32_t levelInfo[3] = {static_cast<uint32_t>(sizes[level].first), static_cast<uint32_t>(sizes[level].second),
+                                         static_cast<uint32_t>(data[level].size())};
+                file.write(reinterpret_cast<const char *>(levelInfo), sizeof(levelInfo));
+                file.write(reinterpret_cast<const char *>(data[level].data()), data[level].size());
+            }
+        }
+        std::rename(temporaryPath.c_str(), path.c_str());
+    }
+}
+
+bool decodeImage(const char *filename, Image &image)
+{
+    int width, height, channels;
+    unsigned char *pixels = SOIL_load_image(filename, &width, &height, &channels, SOIL_LOAD_RGBA);
+    if (pixels == nullptr)
+    {
+        std::cerr << "SOIL loading error: '" << SOIL_last_result() << "' (" << filename << ")" << std::endl;
+        return false;
+    }
+
+    // Flip to bottom-up rows, same as SOIL_FLAG_INVERT_Y
+    size_t rowBytes = static_cast<size_t>(width) * 4;
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    image.pixels.resize(rowBytes * height);
+    for (int y = 0; y < height; ++y)
+    {
+        memcpy(&image.pixels[y * rowBytes], pixels + (height - 1 - y) * rowBytes, rowBytes);
+    }
+
+    SOIL_free_image_data(pixels);
+    return true;
+}
+
+TextureLoader::TextureLoader() : stopping(false)
+{
+    unsigned threadCount = std::min<unsigned>(TEXTURE_DECODE_THREADS, std::max(1u, std::thread::hardware_concurrency()));
+    for (unsigned i = 0; i < threadCount; ++i)
+    {
+        decoders.emplace_back(&TextureLoader::decoderLoop, this);
+    }
+}
+
+TextureLoader::~TextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workCondition.notify_all();
+    for (std::thread &decoder : decoders)
+    {
+        decoder.join();
+    }
+    decoders.clear();
+}
+
+GLuint TextureLoader::request(const std::string &filename, bool compress)
+{
+    if (compress && !GLEW_EXT_texture_compression_s3tc)
+    {
+        compress = false;
+    }
+
+    auto entry = std::make_shared<TextureEntry>();
+    entry->filename = filename;
+    entry->compress = compress;
+    return queueEntry(entry);
+}
+
+GLuint TextureLoader::request(const Image &image, const std::string &name)
+{
+    auto entry = std::make_shared<TextureEntry>();
+    entry->filename = name;
+    entry->compress = false;
+    entry->source = image;
+    return queueEntry(entry);
+}
+
+GLuint TextureLoader::queueEntry(const std::shared_ptr<TextureEntry> &entry)
+{
+    glGenTextures(1, &entry->id);
+    glBindTexture(GL_TEXTURE_2D, entry->id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries[entry->id] = entry;
+        decodeQueue.push_back(entry);
+    }
+    workCondition.notify_one();
+    return entry->id;
+}
+
+void TextureLoader::decoderLoop()
+{
+    for (;;)
+    {
+        std::shared_ptr<TextureEntry> entry;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workCondition.wait(lock, [this]
+                               { return stopping || !decodeQueue.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+            entry = decodeQueue.front();
+            decodeQueue.pop_front();
+            if (entry->released)
+            {
+                continue;
+            }
+        }
+
+        bool loaded = loadLevels(*entry);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            entry->state = loaded ? TextureState::Uploading : TextureState::Failed;
+            if (loaded && !entry->released)
+            {
+                uploadQueue.push_back(entry);
+            }
+        }
+        decodedCondition.notify_all();
+    }
+}
+
+bool TextureLoader::loadLevels(TextureEntry &entry)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::vector<unsigned char>> data;
+    std::vector<std::pair<int, int>> sizes;
+    bool decoded = !entry.source.pixels.empty();
+    bool compressed = entry.compress;
+    bool cacheHit = false;
+    struct stat source;
+    std::string path;
+
+    if (!decoded)
+    {
+        if (stat(entry.filename.c_str(), &source) != 0)
+        {
+            std::cerr << "Texture not found: " << entry.filename << std::endl;
+            return false;
+        }
+        path = cachePath(entry.filename, entry.compress);
+        cacheHit = readCache(path, source, compressed, data, sizes);
+    }
+
+    if (!cacheHit)
+    {
+        Image image;
+        if (decoded)
+        {
+            image = std::move(entry.source);
+        }
+        else if (!decodeImage(entry.filename.c_str(), image))
+        {
+            return false;
+        }
+
+        // Full chain down to 1x1
+        data.clear();
+        sizes.clear();
+        data.push_back(std::move(image.pixels));
+        sizes.push_back(std::make_pair(image.width, image.height));
+        while (sizes.back().first > 1 || sizes.back().second > 1)
+        {
+            int width = sizes.back().first, height = sizes.back().second;
+            int nextWidth = std::max(1, width / 2), nextHeight = std::max(1, height / 2);
+            std::vector<unsigned char> next(nextWidth * nextHeight * 4);
+            downsample(data.back().data(), width, height, next.data(), nextWidth, nextHeight);
+            data.push_back(std::move(next));
+            sizes.push_back(std::make_pair(nextWidth, nextHeight));
+        }
+
+        // BC1 has no useful alpha, images with an alpha channel stay RGBA
+        compressed = entry.compress && image.channels < 4;
+        if (compressed)
+        {
+            for (size_t level = 0; level < data.size(); ++level)
+            {
+                data[level] = compressBC1(data[level], sizes[level].first, sizes[level].second);
+            }
+        }
+
+        if (!decoded)
+        {
+            writeCache(path, source, compressed, data, sizes);
+        }
+    }
+
+    entry.compress = compressed;
+    entry.levels.resize(data.size());
+    for (size_t level = 0; level < data.size(); ++level)
+    {
+        entry.levels[level].width = sizes[level].first;
+        entry.levels[level].height = sizes[level].second;
+        entry.levels[level].data = std::move(data[level]);
+    }
+
+    std::chrono::duration<double, std::milli> loadTime = std::chrono::high_resolution_clock::now() - start;
+    std::ostringstream message;
+    message << "Texture " << entry.filename << ": " << loadTime.count() << " ms (" << (cacheHit ? "cache" : decoded ? "mip chain" : "decoded")
+            << (compressed ? ", BC1" : "") << ")\n";
+    std::cout << message.str() << std::flush;
+    return true;
+}
+
+bool TextureLoader::uploadSlice(TextureEntry &entry)
+{
+    glBindTexture(GL_TEXTURE_2D, entry.id);
+
+    if (entry.uploadLevel < 0)
+    {
+        // Smallest level first - the texture is complete (if blurry) after the first slice
+        entry.uploadLevel = static_cast<int>(entry.levels.size()) - 1;
+        entry.uploadRow = 0;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, entry.uploadLevel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.uploadLevel);
+    }
+
+    MipLevel &level = entry.levels[entry.uploadLevel];
+    int rows = entry.compress ? (level.height + 3) / 4 : level.height;
+    size_t rowBytes = entry.compress ? static_cast<size_t>((level.width + 3) / 4) * 8 : static_cast<size_t>(level.width) * 4;
+
+    if (entry.uploadRow == 0)
+    {
+        if (entry.compress)
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, entry.uploadLevel, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, level.width, level.height, 0,
+                                   static_cast<GLsizei>(level.data.size()), nullptr);
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_2D, entry.uploadLevel, GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        }
+    }
+
+    int sliceRows = std::max(1, static_cast<int>(TEXTURE_UPLOAD_SLICE_BYTES / rowBytes));
+    sliceRows = std::min(sliceRows, rows - entry.uploadRow);
+    const unsigned char *sliceData = level.data.data() + entry.uploadRow * rowBytes;
+
+    if (entry.compress)
+    {
+        int y = entry.uploadRow * 4;
+        int height = std::min(sliceRows * 4, level.height - y);
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, entry.uploadLevel, 0, y, level.width, height, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                                  static_cast<GLsizei>(sliceRows * rowBytes), sliceData);
+    }
+    else
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, entry.uploadLevel, 0, entry.uploadRow, level.width, sliceRows, GL_RGBA, GL_UNSIGNED_BYTE, sliceData);
+    }
+    entry.uploadRow += sliceRows;
+
+    bool done = false;
+    if (entry.uploadRow == rows)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.uploadLevel);
+        std::vector<unsigned char>().swap(level.data); // The GPU has its own copy now
+        entry.uploadLevel--;
+        entry.uploadRow = 0;
+        done = entry.uploadLevel < 0;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return done;
+}
+
+void TextureLoader::pumpUploads(double budgetMs)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (;;)
+    {
+        std::shared_ptr<TextureEntry> entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (uploadQueue.empty())
+            {
+                return;
+            }
+            entry = uploadQueue.front();
+            if (entry->released)
+            {
+                uploadQueue.pop_front();
+                continue;
+            }
+        }
+
+        if (uploadSlice(*entry))
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            entry->state = TextureState::Ready;
+            entry->levels.clear();
+            uploadQueue.pop_front();
+        }
+
+        // At least one slice per frame, so a slow frame cannot starve the queue
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        if (elapsed.count() >= budgetMs)
+        {
+            return;
+        }
+    }
+}
+
+bool TextureLoader::waitFor(GLuint textureID)
+{
+    std::shared_ptr<TextureEntry> entry;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto found = entries.find(textureID);
+        if (found == entries.end())
+        {
+            return false;
+        }
+        entry = found->second;
+        decodedCondition.wait(lock, [&]
+                              { return entry->state != TextureState::Pending; });
+        if (entry->state != TextureState::Uploading)
+        {
+            return entry->state == TextureState::Ready;
+        }
+    }
+
+    // Upload the rest of this texture right away, other textures keep their place in the queue
+    while (!uploadSlice(*entry))
+    {
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entry->state = TextureState::Ready;
+    entry->levels.clear();
+    uploadQueue.erase(std::find(uploadQueue.begin(), uploadQueue.end(), entry));
+    return true;
+}
+
+TextureState TextureLoader::getState(GLuint textureID) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = entries.find(textureID);
+    return found == entries.end() ? TextureState::Failed : found->second->state;
+}
+
+void TextureLoader::release(GLuint textureID)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = entries.find(textureID);
+        if (found == entries.end())
+        {
+            return;
+        }
+        found->second->released = true;
+        entries.erase(found);
+    }
+    glDeleteTextures(1, &textureID);
+}
+
+void TextureLoader::cleanup()
+{
+    std::vector<GLuint> textureIDs;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &entry : entries)
+        {
+            entry.second->released = true;
+            textureIDs.push_back(entry.first);
+        }
+        entries.clear();
+        decodeQueue.clear();
+        uploadQueue.clear();
+    }
+    if (!textureIDs.empty())
+    {
+        glDeleteTextures(static_cast<GLsizei>(textureIDs.size()), textureIDs.data());
+    }
+}
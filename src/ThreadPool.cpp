@@ -0,0 +1,145 @@
+/*
+ * File:        ThreadPool.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Persistent worker pool shared by the load-time and per-frame parallel loops
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "ThreadPool.h"
+
+namespace
+{
+    thread_local bool insidePoolWorker = false;
+}
+
+ThreadPool::ThreadPool(unsigned threadCount)
+    : owner(std::this_thread::get_id()), job(nullptr), jobTaskCount(0), jobThreads(0), nextTask(0), busyWorkers(0), generation(0), stopping(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+
+    // The thread calling parallelFor is the last one
+    for (unsigned i = 0; i + 1 < threadCount; ++i)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::instance()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::parallelFor(size_t taskCount, const std::function<void(size_t)> &fn)
+{
+    parallelFor(taskCount, getThreadCount(), fn);
+}
+
+void ThreadPool::parallelFor(size_t taskCount, unsigned maxThreads, const std::function<void(size_t)> &fn)
+{
+    if (taskCount == 0)
+    {
+        return;
+    }
+
+    // Nested loops and tiny jobs are not worth waking anybody up. A second thread would overwrite the job slot
+    // of a running loop, it does its own work instead.
+    if (insidePoolWorker || std::this_thread::get_id() != owner || workers.empty() || taskCount == 1 || maxThreads <= 1)
+    {
+        for (size_t task = 0; task < taskCount; ++task)
+        {
+            fn(task);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        jobTaskCount = taskCount;
+        jobThreads = maxThreads - 1;
+        nextTask.store(0, std::memory_order_relaxed);
+        busyWorkers = 0;
+        generation++;
+    }
+    wakeCondition.notify_all();
+
+    insidePoolWorker = true;
+    runTasks();
+    insidePoolWorker = false;
+
+    // Wait until every worker that joined has finished its last task
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this]
+                       { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::runTasks()
+{
+    for (;;)
+    {
+        size_t task = nextTask.fetch_add(1, std::memory_order_relaxed);
+        if (task >= jobTaskCount)
+        {
+            break;
+        }
+        (*job)(task);
+    }
+}
+
+void ThreadPool::workerLoop(unsigned workerIndex)
+{
+    insidePoolWorker = true;
+    unsigned long seenGeneration = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [&]
+                               { return stopping || (generation != seenGeneration && job != nullptr); });
+            if (stopping)
+            {
+                return;
+            }
+            seenGeneration = generation;
+            if (workerIndex >= jobThreads)
+            {
+                continue; // Not part of this job
+            }
+            busyWorkers++;
+        }
+
+        runTasks();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busyWorkers--;
+        }
+        doneCondition.notify_one();
+    }
+}
@@ -0,0 +1,268 @@
+/*
+ * File:        Timing.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: TSC calibration and lock-free log-linear latency histograms with periodic reports
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "Timing.h"
+#include <algorithm>
+#include <chrono>
+#include <cpuid.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+double Timing::nanosecondsPerTick = 0.0;
+
+namespace
+{
+    std::mutex histogramsMutex; // Taken once per call site and by the reports
+    std::vector<std::unique_ptr<LatencyHistogram>> histograms;
+
+    bool invariantTsc = false;
+    double reportInterval = 0.0;
+    std::chrono::steady_clock::time_point lastReport;
+
+    void reportAtExit()
+    {
+        Timing::report(false);
+    }
+
+    void printDuration(uint64_t nanoseconds)
+    {
+        std::printf(" %10.1f", nanoseconds / 1000.0);
+    }
+}
+
+LatencyHistogram::LatencyHistogram(const char *name) : name(name), max(0), intervalMax(0)
+{
+    for (unsigned i = 0; i < LATENCY_BUCKETS; ++i)
+    {
+        buckets[i].store(0, std::memory_order_relaxed);
+        reported[i] = 0;
+    }
+}
+
+unsigned LatencyHistogram::bucketIndex(uint64_t nanoseconds)
+{
+    if (nanoseconds < LATENCY_SUB_BUCKETS)
+    {
+        return static_cast<unsigned>(nanoseconds);
+    }
+    if (nanoseconds >= (1ull << LATENCY_MAX_BITS))
+    {
+        nanoseconds = (1ull << LATENCY_MAX_BITS) - 1;
+    }
+    // Keep the top LATENCY_SUB_BUCKET_BITS bits, the leading one selects the power of two
+    unsigned msb = 63 - __builtin_clzll(nanoseconds);
+    unsigned shift = msb - (LATENCY_SUB_BUCKET_BITS - 1);
+    unsigned top = static_cast<unsigned>(nanoseconds >> shift); // [SUB_BUCKETS / 2, SUB_BUCKETS)
+    return LATENCY_SUB_BUCKETS + (shift - 1) * (LATENCY_SUB_BUCKETS / 2) + (top - LATENCY_SUB_BUCKETS / 2);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(unsigned index)
+{
+    if (index < LATENCY_SUB_BUCKETS)
+    {
+        return index;
+    }
+    unsigned offset = index - LATENCY_SUB_BUCKETS;
+    unsigned shift = offset / (LATENCY_SUB_BUCKETS / 2) + 1;
+    uint64_t top = LATENCY_SUB_BUCKETS / 2 + offset % (LATENCY_SUB_BUCKETS / 2);
+    return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::updateMax(std::atomic<uint64_t> &target, uint64_t value)
+{
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds)
+{
+    buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    updateMax(max, nanoseconds);
+    updateMax(intervalMax, nanoseconds);
+}
+
+LatencySummary LatencyHistogram::summarize(const uint64_t *counts, uint64_t max)
+{
+    LatencySummary summary = {0, 0, 0, 0, max};
+    for (unsigned i = 0; i < LATENCY_BUCKETS; ++i)
+    {
+        summary.count += counts[i];
+    }
+    if (summary.count == 0)
+    {
+        return summary;
+    }
+
+    // Rank of each percentile, rounded up so p99.9 of 100 samples is the largest one
+    const double quantiles[3] = {0.5, 0.99, 0.999};
+    uint64_t *results[3] = {&summary.p50, &summary.p99, &summary.p999};
+    uint64_t seen = 0;
+    unsigned next = 0;
+    for (unsigned i = 0; i < LATENCY_BUCKETS && next < 3; ++i)
+    {
+        seen += counts[i];
+        while (next < 3 && seen >= static_cast<uint64_t>(quantiles[next] * summary.count + 0.999999))
+        {
+            *results[next] = std::min(bucketUpperBound(i), max); // The bucket bound can overshoot the real max
+            next++;
+        }
+    }
+    return summary;
+}
+
+LatencySummary LatencyHistogram::takeInterval()
+{
+    uint64_t counts[LATENCY_BUCKETS];
+    for (unsigned i = 0; i < LATENCY_BUCKETS; ++i)
+    {
+        uint64_t total = buckets[i].load(std::memory_order_relaxed);
+        counts[i] = total - reported[i];
+        reported[i] = total;
+    }
+    return summarize(counts, intervalMax.exchange(0, std::memory_order_relaxed));
+}
+
+LatencySummary LatencyHistogram::summarizeTotal() const
+{
+    uint64_t counts[LATENCY_BUCKETS];
+    for (unsigned i = 0; i < LATENCY_BUCKETS; ++i)
+    {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+    return summarize(counts, max.load(std::memory_order_relaxed));
+}
+
+void Timing::calibrate()
+{
+    if (nanosecondsPerTick != 0.0)
+    {
+        return;
+    }
+
+    // CPUID 0x80000007 EDX bit 8: invariant TSC
+    unsigned eax, ebx, ecx, edx;
+    invariantTsc = __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8)) != 0;
+    if (!invariantTsc)
+    {
+        std::cerr << "Timing: TSC is not invariant, cycle counts follow the clock frequency and are only approximate times" << std::endl;
+    }
+
+    // 20 ms against steady_clock; the sleep keeps the core from being busy, the invariant TSC does not care
+    auto startTime = std::chrono::steady_clock::now();
+    uint64_t startTicks = __rdtsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uint64_t endTicks = __rdtsc();
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+    nanosecondsPerTick = elapsed / static_cast<double>(endTicks - startTicks);
+    std::cout << "Timing: TSC at " << 1.0 / nanosecondsPerTick << " GHz" << (invariantTsc ? " (invariant)" : "") << std::endl;
+
+    lastReport = std::chrono::steady_clock::now();
+    std::atexit(reportAtExit);
+}
+
+bool Timing::hasInvariantTsc()
+{
+    return invariantTsc;
+}
+
+std::string Timing::cpuBrand()
+{
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000004)
+    {
+        return "unknown";
+    }
+    unsigned brand[12];
+    for (unsigned leaf = 0; leaf < 3; ++leaf)
+    {
+        __get_cpuid(0x80000002 + leaf, &brand[leaf * 4], &brand[leaf * 4 + 1], &brand[leaf * 4 + 2], &brand[leaf * 4 + 3]);
+    }
+    std::string name(reinterpret_cast<const char *>(brand), sizeof(brand));
+    name = name.substr(0, name.find('\0'));
+    size_t first = name.find_first_not_of(' '); // Intel pads the front
+    size_t last = name.find_last_not_of(' ');
+    return first == std::string::npos ? "unknown" : name.substr(first, last - first + 1);
+}
+
+LatencyHistogram &Timing::histogram(const char *name)
+{
+    std::lock_guard<std::mutex> lock(histogramsMutex);
+    for (const std::unique_ptr<LatencyHistogram> &histogram : histograms)
+    {
+        if (std::string(histogram->getName()) == name)
+        {
+            return *histogram; // Same zone name at two call sites
+        }
+    }
+    histograms.emplace_back(new LatencyHistogram(name));
+    return *histograms.back();
+}
+
+void Timing::setReportInterval(double seconds)
+{
+    reportInterval = seconds;
+}
+
+void Timing::pollReport()
+{
+    if (reportInterval <= 0.0)
+    {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - lastReport).count() >= reportInterval)
+    {
+        report(true);
+    }
+}
+
+void Timing::report(bool interval)
+{
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - lastReport).count();
+    lastReport = now;
+
+    std::lock_guard<std::mutex> lock(histogramsMutex);
+    if (histograms.empty())
+    {
+        return;
+    }
+    if (interval)
+    {
+        std::printf("Latency, last %.1f s (us)       count        p50        p99      p99.9        max\n", seconds);
+    }
+    else
+    {
+        std::printf("Latency, whole run (us)          count        p50        p99      p99.9        max\n");
+    }
+    for (const std::unique_ptr<LatencyHistogram> &histogram : histograms)
+    {
+        LatencySummary summary = interval ? histogram->takeInterval() : histogram->summarizeTotal();
+        if (summary.count == 0)
+        {
+            continue;
+        }
+        std::printf("  %-26s %9llu", histogram->getName(), static_cast<unsigned long long>(summary.count));
+        printDuration(summary.p50);
+        printDuration(summary.p99);
+        printDuration(summary.p999);
+        printDuration(summary.max);
+        std::printf("\n");
+    }
+    std::fflush(stdout);
+}
@@ -0,0 +1,378 @@
+/*
+ * File:        Trace.cpp
+ * Author:      Marek Hric xhricma00
+ * Date:        2026-10-18
+ * Description: Per-thread lock-free ring buffers of timing zones, Chrome trace and two-column dumps
+ *
+ * Copyright (c) 2025, Brno University of Technology. All rights reserved.
+ * Licensed under the MIT.
+ */
+
+#include "Trace.h"
+#include "Timing.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+std::atomic<bool> Trace::enabled(false);
+std::atomic<bool> Trace::countersEnabled(false);
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char *name;
+        uint64_t beginTicks;
+        uint64_t endTicks;
+        unsigned thread;
+    };
+
+    // Written only by its thread. written counts every event ever recorded, the slot is written % capacity.
+    struct ThreadRing
+    {
+        TraceEvent events[TRACE_RING_CAPACITY];
+        std::atomic<uint64_t> written;
+        unsigned thread;
+    };
+
+    // Rings are never freed, a dump may run after their thread has exited
+    std::mutex ringsMutex; // Only taken when a thread records its first event and by dump
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    thread_local ThreadRing *localRing = nullptr;
+
+    std::string outputBase;
+    volatile std::sig_atomic_t dumpRequested = 0;
+
+    uint64_t startTicks = 0; // Time zero of the Chrome trace
+
+    // Hardware counters, opened per thread on its first zone
+    struct ZoneCounters
+    {
+        const char *name;
+        uint64_t calls;
+        uint64_t ticks;
+        double values[PERF_MAX_EVENTS]; // Sums of the scaled per-call deltas
+    };
+
+    std::vector<PerfEventSpec> counterEvents;
+    std::vector<std::string> counterNames; // As opened by the first thread, threads that got a different set do not count
+    std::mutex countersMutex;
+    std::vector<ZoneCounters> zoneCounters;
+    thread_local std::unique_ptr<PerfCounters> localCounters;
+    thread_local bool localCountersTried = false;
+
+    void reportCountersAtExit()
+    {
+        std::lock_guard<std::mutex> lock(countersMutex);
+        if (zoneCounters.empty())
+        {
+            return;
+        }
+        int cycles = -1, instructions = -1;
+        std::printf("Hardware counters per call   calls    wall us");
+        for (size_t i = 0; i < counterNames.size(); ++i)
+        {
+            std::printf(" %13s", counterNames[i].c_str());
+            cycles = counterNames[i] == "cycles" ? static_cast<int>(i) : cycles;
+            instructions = counterNames[i] == "instructions" ? static_cast<int>(i) : instructions;
+        }
+        std::printf("%s\n", cycles >= 0 && instructions >= 0 ? "    IPC" : "");
+        for (const ZoneCounters &zone : zoneCounters)
+        {
+            double calls = static_cast<double>(zone.calls);
+            std::printf("  %-24s %7llu %10.1f", zone.name, static_cast<unsigned long long>(zone.calls),
+                        Timing::ticksToNanoseconds(zone.ticks) / calls / 1000.0);
+            for (size_t i = 0; i < counterNames.size(); ++i)
+            {
+                std::printf(" %13.0f", zone.values[i] / calls);
+            }
+            if (cycles >= 0 && instructions >= 0 && zone.values[cycles] > 0)
+            {
+                std::printf(" %6.2f", zone.values[instructions] / zone.values[cycles]);
+            }
+            std::printf("\n");
+        }
+        std::fflush(stdout);
+    }
+
+    ThreadRing *registerThread()
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.emplace_back(new ThreadRing());
+        ThreadRing *ring = rings.back().get();
+        ring->written.store(0, std::memory_order_relaxed);
+        ring->thread = static_cast<unsigned>(rings.size() - 1);
+        return ring;
+    }
+
+    void signalHandler(int)
+    {
+        dumpRequested = 1;
+    }
+
+    void dumpAtExit()
+    {
+        Trace::dump();
+    }
+
+    // Events still intact in every ring. A slot the owner may be overwriting during the copy is dropped.
+    std::vector<TraceEvent> collectEvents()
+    {
+        std::vector<TraceEvent> events;
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (const std::unique_ptr<ThreadRing> &ring : rings)
+        {
+            uint64_t end = ring->written.load(std::memory_order_acquire);
+            uint64_t begin = end > TRACE_RING_CAPACITY ? end - TRACE_RING_CAPACITY : 0;
+            size_t first = events.size();
+            for (uint64_t i = begin; i < end; ++i)
+            {
+                events.push_back(ring->events[i % TRACE_RING_CAPACITY]);
+            }
+
+            uint64_t after = ring->written.load(std::memory_order_acquire);
+            uint64_t overwritten = after >= TRACE_RING_CAPACITY ? after - TRACE_RING_CAPACITY + 1 : 0;
+            if (overwritten > begin)
+            {
+                size_t lost = static_cast<size_t>(std::min(overwritten, end) - begin);
+                events.erase(events.begin() + first, events.begin() + first + lost);
+            }
+        }
+        std::sort(events.begin(), events.end(), [](const TraceEvent &a, const TraceEvent &b)
+                  { return a.beginTicks < b.beginTicks; });
+        return events;
+    }
+
+    void writeJsonString(std::ostream &out, const char *text)
+    {
+        out << '"';
+        for (const char *c = text; *c != '\0'; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                out << '\\';
+            }
+            out << *c;
+        }
+        out << '"';
+    }
+
+    bool writeChromeTrace(const std::string &path, const std::vector<TraceEvent> &events, double ticksPerMicrosecond)
+    {
+        std::ofstream out(path);
+        if (!out)
+        {
+            return false;
+        }
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        for (size_t i = 0; i < events.size(); ++i)
+        {
+            const TraceEvent &event = events[i];
+            double begin = static_cast<double>(static_cast<int64_t>(event.beginTicks - startTicks)) / ticksPerMicrosecond;
+            double duration = static_cast<double>(event.endTicks - event.beginTicks) / ticksPerMicrosecond;
+            out << "{\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << begin << ",\"dur\":" << duration << '}'
+                << (i + 1 < events.size() ? ",\n" : "\n");
+        }
+        out << "]}\n";
+        return static_cast<bool>(out);
+    }
+
+    // Kernel zones and the suffix of their two-column file, the assembly kernel keeps the plain <base>.txt
+    struct PairedZone
+    {
+        const char *zone;
+        const char *suffix;
+    };
+    const PairedZone PAIRED_ZONES[] = {
+        {TRACE_ZONE_OCEAN_SIMD, ""},
+        {TRACE_ZONE_OCEAN_SPECIALIZED, ".specialized"},
+        {TRACE_ZONE_OCEAN_JIT, ".jit"},
+        {TRACE_ZONE_OCEAN_FIXED_POINT, ".fixed"},
+    };
+
+    // Reference/kernel pairs in frame order, one "ns cycles" line each. Unpaired events (ring wrap) are skipped.
+    std::string twoColumns(const std::vector<TraceEvent> &events, const char *zone, double ticksPerNanosecond)
+    {
+        std::ostringstream out;
+        const TraceEvent *reference = nullptr;
+        for (const TraceEvent &event : events)
+        {
+            if (std::strcmp(event.name, TRACE_ZONE_OCEAN_REFERENCE) == 0)
+            {
+                reference = &event;
+            }
+            else if (std::strcmp(event.name, zone) == 0 && reference != nullptr)
+            {
+                for (const TraceEvent *pairEvent : {reference, &event})
+                {
+                    uint64_t cycles = pairEvent->endTicks - pairEvent->beginTicks;
+                    out << static_cast<uint64_t>(cycles / ticksPerNanosecond) << ' ' << cycles << '\n';
+                }
+                reference = nullptr;
+            }
+        }
+        return out.str();
+    }
+
+    bool writeText(const std::string &path, const std::string &text)
+    {
+        std::ofstream out(path);
+        out << text;
+        return static_cast<bool>(out);
+    }
+}
+
+void Trace::enable(const std::string &basePath)
+{
+    if (isEnabled())
+    {
+        return;
+    }
+    Timing::calibrate(); // Ticks to ns for both dumps
+    outputBase = basePath;
+    startTicks = __rdtsc();
+    std::signal(SIGUSR1, signalHandler);
+    std::atexit(dumpAtExit); // glutMainLoop leaves through exit()
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Trace::record(const char *name, uint64_t beginTicks, uint64_t endTicks)
+{
+    ThreadRing *ring = localRing;
+    if (ring == nullptr)
+    {
+        ring = localRing = registerThread();
+    }
+    uint64_t index = ring->written.load(std::memory_order_relaxed);
+    ring->events[index % TRACE_RING_CAPACITY] = {name, beginTicks, endTicks, ring->thread};
+    ring->written.store(index + 1, std::memory_order_release);
+}
+
+void Trace::enableCounters(const std::vector<PerfEventSpec> &events)
+{
+    if (!isEnabled() || areCountersEnabled())
+    {
+        return;
+    }
+    counterEvents = events;
+    std::atexit(reportCountersAtExit);
+    countersEnabled.store(true, std::memory_order_relaxed);
+}
+
+bool Trace::readCounters(PerfSample &sample)
+{
+    if (!localCountersTried)
+    {
+        localCountersTried = true;
+        std::unique_ptr<PerfCounters> counters(new PerfCounters());
+        if (counters->open(counterEvents))
+        {
+            std::lock_guard<std::mutex> lock(countersMutex);
+            std::vector<std::string> names;
+            for (size_t i = 0; i < counters->size(); ++i)
+            {
+                names.push_back(counters->getName(i));
+            }
+            if (counterNames.empty())
+            {
+                counterNames = names;
+            }
+            if (names == counterNames)
+            {
+                localCounters = std::move(counters);
+            }
+        }
+    }
+    return localCounters && localCounters->read(sample);
+}
+
+void Trace::recordCounters(const char *name, uint64_t ticks, const PerfSample &begin)
+{
+    PerfSample end;
+    if (!localCounters->read(end))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(countersMutex); // Counting zones already pay for syscalls
+    ZoneCounters *zone = nullptr;
+    for (ZoneCounters &candidate : zoneCounters)
+    {
+        if (candidate.name == name || std::strcmp(candidate.name, name) == 0)
+        {
+            zone = &candidate;
+            break;
+        }
+    }
+    if (zone == nullptr)
+    {
+        zoneCounters.push_back(ZoneCounters());
+        zone = &zoneCounters.back();
+        std::memset(zone, 0, sizeof(ZoneCounters));
+        zone->name = name;
+    }
+    zone->calls++;
+    zone->ticks += ticks;
+    for (size_t i = 0; i < counterNames.size(); ++i)
+    {
+        zone->values[i] += PerfCounters::delta(begin, end, i);
+    }
+}
+
+bool Trace::dump()
+{
+    if (!isEnabled())
+    {
+        return false;
+    }
+    double ticksPerNanosecond = 1.0 / Timing::nanosecondsPerTick;
+
+    std::vector<TraceEvent> events = collectEvents();
+    std::string jsonPath = outputBase + ".json";
+    std::string columnsPaths;
+    bool written = true;
+    if (!writeChromeTrace(jsonPath, events, ticksPerNanosecond * 1000.0))
+    {
+        std::cerr << "Trace: cannot write " << jsonPath << std::endl;
+        written = false;
+    }
+    for (const PairedZone &paired : PAIRED_ZONES)
+    {
+        std::string text = twoColumns(events, paired.zone, ticksPerNanosecond);
+        std::string path = outputBase + paired.suffix + ".txt";
+        if (text.empty() && paired.suffix[0] != '\0')
+        {
+            continue; // Only the kernels that ran, <base>.txt is always written
+        }
+        if (!writeText(path, text))
+        {
+            std::cerr << "Trace: cannot write " << path << std::endl;
+            written = false;
+            continue;
+        }
+        columnsPaths += (columnsPaths.empty() ? "" : ", ") + path;
+    }
+    if (written)
+    {
+        std::cerr << "Trace: " << events.size() << " events written to " << jsonPath << " and " << columnsPaths << std::endl;
+    }
+    return written;
+}
+
+void Trace::pollDumpRequest()
+{
+    if (dumpRequested)
+    {
+        dumpRequested = 0;
+        dump();
+    }
+}
@@ -11,20 +11,25 @@
 
 
 #include "Renderer.h"
+#include "GLDebug.h"
 #include <iostream>
-#include <SOIL/SOIL.h>
+#include <cmath>
+#include <chrono>
 #include "utils.h"
+#include "Timing.h"
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 
 
 
-Renderer::Renderer() : oceanTextureID(0), boatTextureID(0), terrainTextureID(0), heightMapTextureID(0) {}
+Renderer::Renderer() : oceanTextureID(0), boatTextureID(0), terrainTextureID(0), heightMapTextureID(0), viewportHeight(800) {}
 
 Renderer::~Renderer() {}
 
 bool Renderer::init()
 {
+    GL_DEBUG_SCOPE("Renderer::init");
     glewInit();
     if (glewIsSupported("GL_VERSION_3_0"))
     {
@@ -37,40 +42,49 @@ bool Renderer::init()
 
     glClearColor(0.529f, 0.808f, 0.922f, 1.0f); // Light blue background
 
-    if (!loadTexture("assets/textures/ocean_texture.png", oceanTextureID))
-    {
-        std::cerr << "Error loading ocean texture." << std::endl;
+    // Programs come from the binary cache or compile on driver threads while the rest of init runs
+    auto shaderStart = std::chrono::steady_clock::now();
+    Shader::enableParallelCompile();
+    terrainShader.beginLoad("assets/shaders/terrain_vertex_shader.glsl", "assets/shaders/terrain_fragment_shader.glsl");
+    oceanShader.beginLoad("assets/shaders/ocean_vertex_shader.glsl", "assets/shaders/ocean_fragment_shader.glsl");
+    boatShader.beginLoad("assets/shaders/boat_vertex_shader.glsl", "assets/shaders/boat_fragment_shader.glsl");
+    debugShader.beginLoad("assets/shaders/debug_vertex_shader.glsl", "assets/shaders/debug_fragment_shader.glsl");
+
+    // Colour textures decode in the background while the rest of the scene is set up
+    oceanTextureID = textureLoader.request("assets/textures/ocean_texture.png", TEXTURE_COMPRESS);
+    terrainTextureID = textureLoader.request("assets/textures/rock_texture.png", TEXTURE_COMPRESS); // Assuming you name it terrain_texture.jpg
+    setupLighting();
+
+    if (!terrainShader.finishLoad()) {
+        std::cerr << "Error loading terrain shader program!" << std::endl;
         return false;
     }
-    if (!loadTexture("assets/textures/rock_texture.png", terrainTextureID)) { // Assuming you name it terrain_texture.jpg
-        std::cerr << "Error loading terrain texture." << std::endl;
+    if (!oceanShader.finishLoad()) {
+        std::cerr << "Error loading ocean shader program!" << std::endl;
         return false;
     }
-    checkGLError("loadTexture - terrainTexture"); // Check after terrain texture loading
-
-    // **Load heightmap texture:**
-    if (!loadTexture("assets/textures/terain.png", heightMapTextureID)) { // Assuming heightmap is terrain_heightmap.png
-        std::cerr << "Error loading terrain heightmap texture." << std::endl;
+    if (!boatShader.finishLoad()) {
+        std::cerr << "Error loading boat shader program!" << std::endl;
         return false;
     }
-    checkGLError("loadTexture - heightMapTexture"); // Check after heightmap texture loading
-
-    terrainShader.loadShader("assets/shaders/terrain_vertex_shader.glsl", "assets/shaders/terrain_fragment_shader.glsl");
-    if (!terrainShader.isLoaded()) {
-        std::cerr << "Error loading terrain shader program!" << std::endl;
+    if (!debugShader.finishLoad()) {
+        std::cerr << "Error loading debug shader program!" << std::endl;
         return false;
     }
-    checkGLError("terrainShader.loadShader"); // Check after shader loading
-    // Load and compile ocean shader program:
-    oceanShader.loadShader("assets/shaders/ocean_vertex_shader.glsl", "assets/shaders/ocean_fragment_shader.glsl");
-    if (!oceanShader.isLoaded()) {
-        std::cerr << "Error loading ocean shader program!" << std::endl;
+    std::chrono::duration<double, std::milli> shaderTime = std::chrono::steady_clock::now() - shaderStart;
+    std::cout << "Shader programs ready in " << shaderTime.count() << " ms" << std::endl;
+    if (!setupShaderUniforms()) {
         return false;
     }
-    checkGLError("oceanShader.loadShader"); // Check after shader loading
     // Boat texture is now loaded in drawBoat, based on Boat class texture path
 
-    setupLighting();
+    if (!debugDraw.init()) {
+        std::cerr << "Error creating debug draw buffers!" << std::endl;
+        return false;
+    }
+    debugDraw.setLayers((SHOW_NORM ? DEBUG_LAYER_NORMALS : 0) | (SHOW_GRID ? DEBUG_LAYER_GRID : 0) |
+                        (SHOW_BOUDING_BOX ? DEBUG_LAYER_BOUNDING_BOXES : 0));
+
     // shaderProgram.loadShader("assets/shaders/vertex_shader.glsl", "assets/shaders/fragment_shader.glsl"); // Optional shader loading
 
     return true;
@@ -78,57 +92,164 @@ bool Renderer::init()
 
 void Renderer::cleanup()
 {
-    glDeleteTextures(1, &oceanTextureID);
-    glDeleteTextures(1, &boatTextureID);
-    glDeleteTextures(1, &terrainTextureID);
-    glDeleteTextures(1, &heightMapTextureID);
+    textureLoader.cleanup(); // Deletes every texture it created, pending ones included
+    debugDraw.cleanup();
+    oceanTextureID = boatTextureID = terrainTextureID = heightMapTextureID = pendingBoatTextureID = 0;
+    glDeleteBuffers(1, &frameUniformBufferID);
+    frameUniformBufferID = 0;
 
     // shaderProgram.cleanup(); // Optional shader cleanup
 }
 
-void Renderer::renderScene(const Ocean &ocean, const Boat &boat, const Camera &camera, const Terrain &terrain)
+void Renderer::renderScene(const Ocean &ocean, const Boat &boat, const Camera &camera, Terrain &terrain)
 {
+    GL_DEBUG_SCOPE("renderScene");
+    {
+        LATENCY_SCOPE("Texture uploads");
+        textureLoader.pumpUploads(); // Budgeted slice of pending texture uploads
+    }
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glLoadIdentity();
 
-    camera.lookAt(); // Set up camera view
+    updateFrameUniforms(camera); // View, projection and light for every program, computed by the camera in update
 
     setupLighting(); // Ensure lighting is enabled each frame
-    drawTerrain(terrain, camera); // **Call drawTerrain here - BEFORE drawOcean**
-
-    drawOcean(ocean, camera);
-    drawBoat(boat);
-    checkGLError("drawTerrain"); // Check after drawTerrain
+    {
+        LATENCY_SCOPE("Render terrain");
+        drawTerrain(terrain, camera); // **Call drawTerrain here - BEFORE drawOcean**
+    }
+    {
+        LATENCY_SCOPE("Render ocean");
+        drawOcean(ocean, camera);
+    }
+    {
+        LATENCY_SCOPE("Render boat");
+        drawBoat(boat, camera);
+    }
+    {
+        LATENCY_SCOPE("Render debug lines");
+        debugDraw.flush(debugShader); // Lines collected by the draws above, one draw call
+    }
     // Optional: Render skybox, UI, etc.
     // ...
 }
 
+static_assert(sizeof(FrameUniforms) == 176, "FrameUniforms must match the std140 Frame block");
+
+bool Renderer::setupShaderUniforms()
+{
+    GL_DEBUG_SCOPE("setupShaderUniforms");
+    // Camera and light live in one buffer bound to every program
+    if (!oceanShader.bindUniformBlock("Frame", FRAME_UNIFORMS_BINDING) ||
+        !terrainShader.bindUniformBlock("Frame", FRAME_UNIFORMS_BINDING) ||
+        !boatShader.bindUniformBlock("Frame", FRAME_UNIFORMS_BINDING) ||
+        !debugShader.bindUniformBlock("Frame", FRAME_UNIFORMS_BINDING) ||
+        !boatShader.bindUniformBlock("Materials", BOAT_MATERIALS_BINDING)) {
+        return false;
+    }
+
+    glGenBuffers(1, &frameUniformBufferID);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBufferID);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, frameUniformBufferID);
+
+    oceanUniforms.model = oceanShader.getUniformLocation("model");
+    oceanUniforms.normalMatrix = oceanShader.getUniformLocation("normalMatrix");
+    terrainUniforms.model = terrainShader.getUniformLocation("model");
+    terrainUniforms.normalMatrix = terrainShader.getUniformLocation("normalMatrix");
+    boatUniforms.model = boatShader.getUniformLocation("model");
+    boatUniforms.normalMatrix = boatShader.getUniformLocation("normalMatrix");
+    boatMaterialLocation = boatShader.getUniformLocation("materialIndex");
+
+    // Samplers never change their texture unit, ocean and terrain vertices are already in world space
+    oceanShader.use();
+    oceanShader.setInt("oceanTexture", 0);
+    oceanShader.setMat4(oceanUniforms.model, glm::mat4(1.0f));
+    oceanShader.setMat3(oceanUniforms.normalMatrix, glm::mat3(1.0f));
+    terrainShader.use();
+    terrainShader.setInt("terrainTexture", 0);
+    terrainShader.setMat4(terrainUniforms.model, glm::mat4(1.0f));
+    terrainShader.setMat3(terrainUniforms.normalMatrix, glm::mat3(1.0f));
+    terrainShader.setInt("heightMapTexture", 1);
+    boatShader.use();
+    boatShader.setInt("boatTexture", 0);
+    boatShader.unuse();
+
+    return true;
+}
+
+void Renderer::updateFrameUniforms(const Camera &camera)
+{
+    FrameUniforms frame;
+    frame.view = camera.getViewMatrix();
+    frame.projection = camera.getProjectionMatrix();
+    frame.viewPosWorld = glm::vec4(camera.getPosition(), 1.0f);
+    frame.lightDir = glm::vec4(glm::normalize(glm::vec3(1.0f, 1.0f, 1.0f)), 0.0f); // Same light as setupLighting
+    frame.lightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBufferID);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, frameUniformBufferID);
+}
+
 void Renderer::reshape(int width, int height)
 {
     glViewport(0, 0, width, height);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluPerspective(45.0f, static_cast<float>(width) / height, 0.1f, 100.0f); // Adjust near/far planes
-    glMatrixMode(GL_MODELVIEW);
+    viewportHeight = height; // The projection itself is owned by Camera::setAspectRatio
 }
 
-bool Renderer::loadTexture(const char *filename, GLuint &textureID)
+void Renderer::setHeightMap(const Image &heightMap)
 {
-    textureID = SOIL_load_OGL_texture(filename, SOIL_LOAD_AUTO, SOIL_CREATE_NEW_ID, SOIL_FLAG_INVERT_Y);
-    if (textureID == 0)
+    // Same pixels the terrain grid was built from, only the mip chain is added
+    if (heightMapTextureID != 0)
     {
-        std::cerr << "SOIL loading error: '" << SOIL_last_result() << "' (" << filename << ")" << std::endl;
-        return false;
+        textureLoader.release(heightMapTextureID);
     }
+    heightMapTextureID = textureLoader.request(heightMap, "heightmap");
+}
 
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glGenerateMipmap(GL_TEXTURE_2D); // Generate mipmaps for better quality at distance
-    glBindTexture(GL_TEXTURE_2D, 0); // Unbind texture
-    return true;
+void Renderer::updateBoatTexture(const Boat &boat)
+{
+    const std::string &path = boat.getTexturePath();
+
+    // Start loading a new texture, the current one stays bound until the new one is complete
+    if (!path.empty() && path != lastBoatTexturePath && path != pendingBoatTexturePath)
+    {
+        if (pendingBoatTextureID != 0)
+        {
+            textureLoader.release(pendingBoatTextureID);
+        }
+        pendingBoatTextureID = textureLoader.request(path, TEXTURE_COMPRESS);
+        pendingBoatTexturePath = path;
+    }
+
+    if (pendingBoatTextureID == 0)
+    {
+        return;
+    }
+
+    TextureState state = textureLoader.getState(pendingBoatTextureID);
+    if (state == TextureState::Ready)
+    {
+        if (boatTextureID != 0)
+        {
+            textureLoader.release(boatTextureID);
+        }
+        boatTextureID = pendingBoatTextureID;
+        lastBoatTexturePath = pendingBoatTexturePath;
+        pendingBoatTextureID = 0;
+        pendingBoatTexturePath.clear();
+    }
+    else if (state == TextureState::Failed)
+    {
+        std::cerr << "Error loading boat texture: " << pendingBoatTexturePath << std::endl;
+        textureLoader.release(pendingBoatTextureID);
+        lastBoatTexturePath = pendingBoatTexturePath; // Do not retry every frame
+        pendingBoatTextureID = 0;
+        pendingBoatTexturePath.clear();
+    }
 }
 
 void Renderer::setupLighting()
@@ -156,34 +277,15 @@ void Renderer::setupLighting()
 
 void Renderer::drawOcean(const Ocean& ocean, const Camera& camera)
 {
-    
-    glPushMatrix();
+    GL_DEBUG_SCOPE("drawOcean");
 
     // Use the ocean shader program:
     oceanShader.use();
-    checkGLError("oceanShader.use"); // Check after shader use
-
-    // Set Uniforms for Ocean Shader:
-    glm::mat4 modelMatrix;
-    glm::mat4 projectionMatrix;
-
-    glGetFloatv(GL_MODELVIEW_MATRIX, glm::value_ptr(modelMatrix));
-    checkGLError("glGetFloatv(GL_MODELVIEW_MATRIX)"); // Check after glGetFloatv
-    glGetFloatv(GL_PROJECTION_MATRIX, glm::value_ptr(projectionMatrix));
-    checkGLError("glGetFloatv(GL_PROJECTION_MATRIX)"); // Check after glGetFloatv
-
-
-    oceanShader.setMat4("model", modelMatrix);
-    oceanShader.setMat4("view", camera.getViewMatrix());
-    oceanShader.setMat4("projection", projectionMatrix);
-    oceanShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(modelMatrix))));
-    checkGLError("shader.setMat4/setMat3 uniforms"); // Check after setting matrix uniforms
 
+    // View, projection and light come from the Frame buffer, the model matrix is identity (set at init)
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, oceanTextureID);
-    oceanShader.setInt("oceanTexture", 0);
-    checkGLError("glBindTexture - oceanTexture"); // Check after glBindTexture
 
     //glActiveTexture(GL_TEXTURE1);
     //glBindTexture(GL_TEXTURE_2D, normalMapTextureID);
@@ -191,218 +293,51 @@ void Renderer::drawOcean(const Ocean& ocean, const Camera& camera)
     //checkGLError("glBindTexture - normalMapTexture"); // Check after glBindTexture
 
 
-    oceanShader.setVec3("lightDir", glm::normalize(glm::vec3(1.0f, 1.0f, 1.0f)));
-    oceanShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));
-    oceanShader.setVec3("viewPosWorld", camera.getPosition());
-    checkGLError("shader.setVec3 uniforms"); // Check after setting vec3 uniforms
-
-
     drawMeshVBO(ocean); // Draw using VBOs and IBO
-    checkGLError("drawMeshVBO"); // Check after drawMeshVBO call
 
     // Unuse shader program after drawing ocean
     oceanShader.unuse();
-    checkGLError("oceanShader.unuse"); // Check after shader unuse
-
-    //glPopMatrix();
-
-    glPushMatrix();
-    //glTranslatef(0.0f, -1.0f, 0.0f); // Lower the ocean slightly
-
-    // **Disable Texture and Lighting for Normal Visualization**
-    glDisable(GL_TEXTURE_2D);
-    glDisable(GL_LIGHTING);
-    glColor3f(1.0f, 0.0f, 0.0f); // Red color for normals (you can change this)
-
-    int gridSize = ocean.getGridSize();
-    float gridSpacing = ocean.getGridSpacing();
-
-    #if SHOW_NORM
-    
-
-    // **Draw Normals as Lines**
-    glBegin(GL_LINES);
-    for (int x = 0; x < gridSize; ++x)
-    {
-        for (int z = 0; z < gridSize; ++z)
-        {
-            glm::vec3 v = ocean.getVertex(x, z);
-            glm::vec3 normal = ocean.getWaveNormal(v.x, v.z, ocean.time); // Get normal at vertex
-
-            // Calculate endpoint of normal line - Scale normal for visibility
-            float normalLength = 0.5f; // Adjust this value to control normal line length
-            glm::vec3 normalEndpoint = v + normal * normalLength;
 
-            // Draw line representing the normal
-            glVertex3f(v.x, v.y, v.z);                                        // Start point of normal line (vertex position)
-            glVertex3f(normalEndpoint.x, normalEndpoint.y, normalEndpoint.z); // End point of normal line (along normal direction)
-        }
+    // Debug lines reuse what the wave kernel produced for this frame
+    if (debugDraw.isEnabled(DEBUG_LAYER_NORMALS)) {
+        debugDraw.gridNormals(ocean.getSurfaceVertices(), ocean.getSurfaceNormals(), glm::vec3(1.0f, 0.0f, 0.0f));
     }
-    glEnd();
-
-    #endif
-
-    // **Re-enable Texture and Lighting (if you want to switch back to textured rendering later)**
-    // glEnable(GL_TEXTURE_2D);
-    // glEnable(GL_LIGHTING);
-
-    glPopMatrix();
-
-    glPushMatrix();
-
-    // **Disable Texture and Lighting for Wireframe Rendering**
-    glDisable(GL_TEXTURE_2D);
-    glDisable(GL_LIGHTING);
-    glColor3f(0.0f, 0.0f, 0.0f); // Green color for wireframe (you can change this)
-
-
-
-
-    #if SHOW_GRID
-
-    // **Change glBegin mode to GL_LINES for Wireframe**
-    glBegin(GL_LINES);
-    for (int x = 0; x < gridSize; ++x)
-    {
-        for (int z = 0; z < gridSize; ++z)
-        {
-            glm::vec3 v = ocean.getVertex(x, z);
-
-            // Draw horizontal lines (along Z-axis)
-            if (x < gridSize - 1)
-            {
-                glm::vec3 v_next_x = ocean.getVertex(x + 1, z);
-                glVertex3f(v.x, v.y, v.z);
-                glVertex3f(v_next_x.x, v_next_x.y, v_next_x.z);
-            }
-            // Draw vertical lines (along X-axis)
-            if (z < gridSize - 1)
-            {
-                glm::vec3 v_next_z = ocean.getVertex(x, z + 1);
-                glVertex3f(v.x, v.y, v.z);
-                glVertex3f(v_next_z.x, v_next_z.y, v_next_z.z);
-            }
-        }
+    if (debugDraw.isEnabled(DEBUG_LAYER_GRID)) {
+        debugDraw.gridLines(ocean.getSurfaceVertices(), ocean.getGridSize(), ocean.getGridSize(), glm::vec3(0.0f), glm::vec3(0.0f));
     }
-    glEnd();
-
-    #endif
-
-    // **Re-enable Texture and Lighting (if you want to switch back to textured rendering later)**
-    // glEnable(GL_TEXTURE_2D);
-    // glEnable(GL_LIGHTING);
-    glPopMatrix();
-
-    glPopMatrix();
 }
 
 // ... (rest of Renderer.cpp - Renderer::drawBoat, Renderer::drawMesh, etc.) ...
 
-void Renderer::drawBoat(const Boat &boat)
+void Renderer::drawBoat(const Boat &boat, const Camera &camera)
 {
-    glPushMatrix();
-    glm::vec3 boatPos = boat.getPosition();
-    glm::quat boatRotation = boat.getRotation();
+    GL_DEBUG_SCOPE("drawBoat");
+    glm::vec3 boatPos = boat.getRenderPosition(); // Interpolated between the last two simulation steps
+    glm::quat boatRotation = boat.getRenderRotation();
     float boatScale = boat.getScale(); // Get the boat's scale factor
-
-    glTranslatef(boatPos.x, boatPos.y, boatPos.z);
     glm::mat4 rotationMatrix = glm::mat4_cast(boatRotation);
-    glMultMatrixf(glm::value_ptr(rotationMatrix));
 
-    glScalef(boatScale, boatScale, boatScale); // Uniform scaling - scale equally in all directions
+    // Boat texture is loaded asynchronously, based on the texture path from the Boat class
+    updateBoatTexture(boat);
 
-    // Load boat texture here, based on the texture path from the Boat class
-    if (!boat.getTexturePath().empty())
-    {
-        if (boatTextureID == 0 || boat.getTexturePath() != lastBoatTexturePath)
-        { // Check if texture needs to be loaded or reloaded
-            if (boatTextureID != 0)
-            { // If there's a previous texture, delete it
-                glDeleteTextures(1, &boatTextureID);
-                boatTextureID = 0;
-            }
-            if (!loadTexture(boat.getTexturePath().c_str(), boatTextureID))
-            {
-                std::cerr << "Error loading boat texture: " << boat.getTexturePath() << std::endl;
-            }
-            else
-            {
-                lastBoatTexturePath = boat.getTexturePath(); // Store the path of the loaded texture
-            }
-        }
-    }
+    boatShader.use();
 
-    glEnable(GL_TEXTURE_2D);
+    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), boatPos) * rotationMatrix * glm::scale(glm::mat4(1.0f), glm::vec3(boatScale));
+    boatShader.setMat4(boatUniforms.model, modelMatrix);
+    boatShader.setMat3(boatUniforms.normalMatrix, glm::mat3(rotationMatrix)); // Uniform scale, rotation is enough
+
+    glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, boatTextureID);
-    glColor3f(1.0f, 1.0f, 1.0f); // Texture color modulation
 
-    // Draw the loaded boat mesh
-    drawMesh(boat.getVertices(), boat.getNormals(), boat.getTexCoords(), boat.getMaterialIndices(), boat.getMaterials()); // Pass material data
+    // Draw the uploaded boat mesh
+    drawMeshBoatVBO(boat);
 
     glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_TEXTURE_2D);
-    glPopMatrix();
-
-    glPushMatrix();
-    glm::vec3 minPoint = boat.getBoundingBoxMin(); // Get model-space min point
-    glm::vec3 maxPoint = boat.getBoundingBoxMax(); // Get model-space max point
-
-    glTranslatef(boatPos.x, boatPos.y, boatPos.z);
-    glMultMatrixf(glm::value_ptr(rotationMatrix));
-    glScalef(boatScale, boatScale, boatScale); // Uniform scaling - scale equally in all directions
-                                               // **Draw Wireframe Bounding Box:**
-    glDisable(GL_LIGHTING);                    // Disable lighting for bounding box (solid color wireframe)
-    glColor3f(1.0f, 1.0f, 0.0f);               // Yellow color for bounding box
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // Set polygon mode to line (wireframe)
-
-
-    #if SHOW_BOUDING_BOX
-    glBegin(GL_QUADS); // Draw a cube using quads (wireframe)
-
-    // Front face
-    glVertex3f(minPoint.x, minPoint.y, maxPoint.z);
-    glVertex3f(maxPoint.x, minPoint.y, maxPoint.z);
-    glVertex3f(maxPoint.x, maxPoint.y, maxPoint.z);
-    glVertex3f(minPoint.x, maxPoint.y, maxPoint.z);
-
-    // Back face
-    glVertex3f(minPoint.x, minPoint.y, minPoint.z);
-    glVertex3f(maxPoint.x, minPoint.y, minPoint.z);
-    glVertex3f(maxPoint.x, maxPoint.y, minPoint.z);
-    glVertex3f(minPoint.x, maxPoint.y, minPoint.z);
-
-    // Top face
-    glVertex3f(minPoint.x, maxPoint.y, maxPoint.z);
-    glVertex3f(maxPoint.x, maxPoint.y, maxPoint.z);
-    glVertex3f(maxPoint.x, maxPoint.y, minPoint.z);
-    glVertex3f(minPoint.x, maxPoint.y, minPoint.z);
-
-    // Bottom face
-    glVertex3f(minPoint.x, minPoint.y, maxPoint.z);
-    glVertex3f(maxPoint.x, minPoint.y, maxPoint.z);
-    glVertex3f(maxPoint.x, minPoint.y, minPoint.z);
-    glVertex3f(minPoint.x, minPoint.y, minPoint.z);
-
-    // Right face
-    glVertex3f(maxPoint.x, minPoint.y, maxPoint.z);
-    glVertex3f(maxPoint.x, maxPoint.y, maxPoint.z);
-    glVertex3f(maxPoint.x, maxPoint.y, minPoint.z);
-    glVertex3f(maxPoint.x, minPoint.y, minPoint.z);
-
-    // Left face
-    glVertex3f(minPoint.x, minPoint.y, maxPoint.z);
-    glVertex3f(minPoint.x, maxPoint.y, maxPoint.z);
-    glVertex3f(minPoint.x, maxPoint.y, minPoint.z);
-    glVertex3f(minPoint.x, minPoint.y, minPoint.z);
-
-    glEnd();
-
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL); // Restore polygon mode to fill
-    #endif
-
-    glEnable(GL_LIGHTING);    
-                     // Re-enable lighting for boat model
-    glPopMatrix();
+    boatShader.unuse();
+
+    if (debugDraw.isEnabled(DEBUG_LAYER_BOUNDING_BOXES)) {
+        debugDraw.box(boat.getBoundingBoxMin(), boat.getBoundingBoxMax(), modelMatrix, glm::vec3(1.0f, 1.0f, 0.0f)); // Same transform as the shaded mesh
+    }
 }
 
 
@@ -419,11 +354,10 @@ void Renderer::drawMeshVBO(const Ocean& ocean) {
     */
 
 
-    // 2. Draw using glDrawElements (assuming you are using indexed rendering with IBO)
-    glDrawElements(GL_QUADS, ocean.getIndexCount(), GL_UNSIGNED_INT, 0); // Draw using indices from IBO
-
-    // If drawing as triangles instead of quads, use:
-    // glDrawElements(GL_TRIANGLES, ocean.getIndexCount(), GL_UNSIGNED_INT, 0);
+    // 2. Draw the grid as triangle strips, rows are separated by the primitive restart index
+    beginGridDraw(ocean.getGridIndices());
+    drawGrid(ocean.getGridIndices());
+    endGridDraw();
 
 
     // 3. Unbind VAO (or VBOs if not using VAOs) - optional, but good practice
@@ -436,199 +370,64 @@ void Renderer::drawMeshVBO(const Ocean& ocean) {
     */
 }
 
-void Renderer::drawMeshTerainVBO(const Terrain& terrain) {
-    // 1. Bind Vertex Array Object (VAO) - if you are using VAOs. If not, bind VBOs directly.
-    glBindVertexArray(terrain.getVAO()); // Assuming Ocean class has getVAO() that returns VAO ID
-
-    // If NOT using VAOs, you would bind VBOs individually like this:
-    /*
-    glBindBuffer(GL_ARRAY_BUFFER, ocean.getVertexBufferID()); // Bind vertex VBO
-    glBindBuffer(GL_ARRAY_BUFFER, ocean.getNormalBufferID());   // Bind normal VBO
-    glBindBuffer(GL_ARRAY_BUFFER, ocean.getTexCoordBufferID()); // Bind texCoord VBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ocean.getIndexBufferID()); // Bind IBO
-    */
-
-
-    // 2. Draw using glDrawElements (assuming you are using indexed rendering with IBO)
-    glDrawElements(GL_QUADS, terrain.getIndexCount(), GL_UNSIGNED_INT, 0); // Draw using indices from IBO
-
-    // If drawing as triangles instead of quads, use:
-    // glDrawElements(GL_TRIANGLES, ocean.getIndexCount(), GL_UNSIGNED_INT, 0);
-
-
-    // 3. Unbind VAO (or VBOs if not using VAOs) - optional, but good practice
+void Renderer::drawMeshTerainVBO(Terrain& terrain, const Camera& camera) {
+    // Tiles outside the frustum are skipped, the rest split until their error is below a couple of pixels
+    Frustum frustum(camera.getViewProjectionMatrix());
+    float pixelScale = viewportHeight / (2.0f * std::tan(glm::radians(camera.getFov()) * 0.5f));
+    terrain.selectTiles(frustum, camera.getPosition(), pixelScale, terrainTiles);
+    terrain.streamTiles(terrainTiles, terrainBaseVertices); // Uploads the tiles that are not resident yet
+
+    // Every tile shares the index buffer, only the base vertex changes
+    const GridIndexBuffer& tileIndices = terrain.getTileIndices();
+    glBindVertexArray(terrain.getVAO());
+    beginGridDraw(tileIndices);
+    for (GLint baseVertex : terrainBaseVertices) {
+        drawGrid(tileIndices, baseVertex);
+    }
+    endGridDraw();
     glBindVertexArray(0);
-
-    // If NOT using VAOs, unbind VBOs individually (optional):
-    /*
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    */
 }
 
-// Static variable to store the last loaded boat texture path
+void Renderer::drawMeshBoatVBO(const Boat& boat) {
+    glBindVertexArray(boat.getVAO());
+    glBindBufferBase(GL_UNIFORM_BUFFER, BOAT_MATERIALS_BINDING, boat.getMaterialBufferID());
 
-void Renderer::drawMesh(const std::vector<glm::vec3> &vertices, const std::vector<glm::vec3> &normals, const std::vector<glm::vec2> &texCoords,
-                        const std::vector<int> &materialIndices, const std::vector<tinyobj::material_t> &materials)
-{
-    glBegin(GL_TRIANGLES);
-    for (size_t i = 0; i < vertices.size(); ++i)
-    {
-        int material_index = materialIndices[i];
-        if (material_index != -1 && static_cast<std::vector<tinyobj::material_t>::size_type>(material_index) < materials.size())
-        { // Check if material index is valid
-            const tinyobj::material_t &material = materials[material_index];
-            glColor3f(material.diffuse[0], material.diffuse[1], material.diffuse[2]); // Set diffuse color
-        }
-        else
-        {
-            glColor3f(1.0f, 1.0f, 1.0f); // Default white color if no valid material
-        }
-
-        glNormal3f(normals[i].x, normals[i].y, normals[i].z);
-        glTexCoord2f(texCoords[i].x, texCoords[i].y);
-        glVertex3f(vertices[i].x, vertices[i].y, vertices[i].z);
+    // Triangles are grouped by material at load time, so every material is one draw call
+    size_t indexSize = boat.usesShortIndices() ? sizeof(unsigned short) : sizeof(unsigned int);
+    for (const MeshBatch& batch : boat.getBatches()) {
+        boatShader.setInt(boatMaterialLocation, batch.material);
+        glDrawElements(GL_TRIANGLES, batch.indexCount, boat.getIndexType(), (void *)(batch.firstIndex * indexSize));
     }
-    glEnd();
+
+    glBindVertexArray(0);
 }
 
 // Renderer.cpp - Add drawTerrain function
-void Renderer::drawTerrain(const Terrain& terrain, const Camera& camera) {
+void Renderer::drawTerrain(Terrain& terrain, const Camera& camera) {
+    GL_DEBUG_SCOPE("drawTerrain");
     
-    //printf("Drawing terrain\n");
-    glPushMatrix();
-    // No translation needed for terrain in this basic example
-    glTranslatef(0.0f, 0.0f, 0.0f); // Lower the ocean slightly
-
     // Use the terrain shader program:
     terrainShader.use();
-    checkGLError("terrainShader.use");
 
-    glm::mat4 modelMatrix;
-    glm::mat4 projectionMatrix;
-
-    glGetFloatv(GL_MODELVIEW_MATRIX, glm::value_ptr(modelMatrix));
-    checkGLError("glGetFloatv(GL_MODELVIEW_MATRIX)"); // Check after glGetFloatv
-    glGetFloatv(GL_PROJECTION_MATRIX, glm::value_ptr(projectionMatrix));
-    checkGLError("glGetFloatv(GL_PROJECTION_MATRIX)"); // Check after glGetFloatv
-
-    terrainShader.setMat4("model", modelMatrix);
-    terrainShader.setMat4("view", camera.getViewMatrix());
-    terrainShader.setMat4("projection", projectionMatrix);
-    terrainShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(modelMatrix))));
-    checkGLError("terrainShader setMat4/setMat3 uniforms");
+    // View, projection and light (same as the ocean) come from the Frame buffer, the model matrix is identity
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, terrainTextureID);
-    terrainShader.setInt("terrainTexture", 0);
-    checkGLError("glBindTexture - terrainTexture");
 
-    glActiveTexture(GL_TEXTURE1); // Activate texture unit 1 for heightmap
+    glActiveTexture(GL_TEXTURE1); // Heightmap sampler is bound to unit 1 at init
     glBindTexture(GL_TEXTURE_2D, heightMapTextureID); // Bind heightmap texture
-    terrainShader.setInt("heightMapTexture", 1); // Set uniform sampler2D heightMapTexture to texture unit 1
-    checkGLError("glBindTexture - heightMapTexture"); // Check after binding heightmap texture
 
-    // Lighting Uniforms (reuse same light parameters as ocean for simplicity)
-    terrainShader.setVec3("lightDir", glm::normalize(glm::vec3(1.0f, -1.0f, 1.0f))); // Example light direction
-    terrainShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f)); // White light
-    terrainShader.setVec3("viewPosWorld", camera.getPosition());
-    checkGLError("terrainShader setVec3 uniforms");
 
-
-    drawMeshTerainVBO(terrain); // Render terrain mesh using VBOs and IBO
-    checkGLError("drawMeshVBO - terrain");
+    drawMeshTerainVBO(terrain, camera); // Render the LOD tiles selected for this camera
     glBindTexture(GL_TEXTURE_2D, 0); // Bind heightmap texture
 
     terrainShader.unuse();
-    checkGLError("terrainShader.unuse");
-
-    glPopMatrix();
-
-    
-
-    glPushMatrix();
-    glTranslatef(0.0f, 0.0f, 0.0f); // Lower the ocean slightly
-
-    // **Disable Texture and Lighting for Normal Visualization**
-    glDisable(GL_TEXTURE_2D);
-    glDisable(GL_LIGHTING);
-    glColor3f(1.0f, 0.0f, 0.0f); // Red color for normals (you can change this)
-
 
-    #if SHOW_NORM
-
-    int gridSize = terrain.getGridSize();
-    float gridSpacing = terrain.getGridSpacing();
-
-    // **Draw Normals as Lines**
-    glBegin(GL_LINES);
-    for (int x = 0; x < gridSize; ++x)
-    {
-        for (int z = 0; z < gridSize; ++z)
-        {
-            glm::vec3 v = terrain.getVertex(x, z);
-            glm::vec3 normal = terrain.getNormal(x, z); // Get normal at vertex
-
-            // Calculate endpoint of normal line - Scale normal for visibility
-            float normalLength = 0.5f; // Adjust this value to control normal line length
-            glm::vec3 normalEndpoint = v + normal * normalLength;
-
-            // Draw line representing the normal
-            glVertex3f(v.x, v.y, v.z);                                        // Start point of normal line (vertex position)
-            glVertex3f(normalEndpoint.x, normalEndpoint.y, normalEndpoint.z); // End point of normal line (along normal direction)
-        }
+    // Debug lines use the full-resolution grid, the wireframe is lifted a bit above the surface
+    if (debugDraw.isEnabled(DEBUG_LAYER_NORMALS)) {
+        debugDraw.gridNormals(terrain.getVertices(), terrain.getNormals(), glm::vec3(1.0f, 0.0f, 0.0f));
     }
-    glEnd();
-
-    #endif
-
-    // **Re-enable Texture and Lighting (if you want to switch back to textured rendering later)**
-    // glEnable(GL_TEXTURE_2D);
-    // glEnable(GL_LIGHTING);
-
-    glPopMatrix();
-
-
-
-    glPushMatrix();
-    glTranslatef(0.0f, 0.2f, 0.0f); // Lower the ocean slightly
-
-    // **Disable Texture and Lighting for Wireframe Rendering**
-    glDisable(GL_TEXTURE_2D);
-    glDisable(GL_LIGHTING);
-    glColor3f(0.0f, 0.0f, 0.0f); // Green color for wireframe (you can change this)
-
-    #if SHOW_GRID
-    // **Change glBegin mode to GL_LINES for Wireframe**
-    glBegin(GL_LINES);
-    for (int x = 0; x < gridSize; ++x)
-    {
-        for (int z = 0; z < gridSize; ++z)
-        {
-            glm::vec3 v = terrain.getVertex(x, z);
-
-            // Draw horizontal lines (along Z-axis)
-            if (x < gridSize - 1)
-            {
-                glm::vec3 v_next_x = terrain.getVertex(x + 1, z);
-                glVertex3f(v.x, v.y, v.z);
-                glVertex3f(v_next_x.x, v_next_x.y, v_next_x.z);
-            }
-            // Draw vertical lines (along X-axis)
-            if (z < gridSize - 1)
-            {
-                glm::vec3 v_next_z = terrain.getVertex(x, z + 1);
-                glVertex3f(v.x, v.y, v.z);
-                glVertex3f(v_next_z.x, v_next_z.y, v_next_z.z);
-            }
-        }
+    if (debugDraw.isEnabled(DEBUG_LAYER_GRID)) {
+        debugDraw.gridLines(terrain.getVertices(), terrain.getGridSize(), terrain.getGridSize(), glm::vec3(0.0f, 0.2f, 0.0f), glm::vec3(0.0f));
     }
-    glEnd();
-
-    #endif
-    // **Re-enable Texture and Lighting (if you want to switch back to textured rendering later)**
-    // glEnable(GL_TEXTURE_2D);
-    // glEnable(GL_LIGHTING);
-
-    glPopMatrix();
 }
\ No newline at end of file
@@ -10,12 +10,24 @@
 
 
 #include "utils.h"
+#include <cerrno>
+#include <sys/stat.h>
 
 
 uint64_t rdtsc() {
     return __rdtsc();  // Read Time-Stamp Counter
 }
 
+bool makeParentDirectories(const std::string& path) {
+    // Starts past a leading '/', an absolute path has no empty first component to create
+    for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+        if (mkdir(path.substr(0, slash).c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void checkGLError(const char* operation) {
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {